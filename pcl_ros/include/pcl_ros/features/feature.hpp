@@ -38,8 +38,13 @@
 #ifndef PCL_ROS__FEATURES__FEATURE_HPP_
 #define PCL_ROS__FEATURES__FEATURE_HPP_
 
+#include <algorithm>
+#include <mutex>
+#include <string>
+
 // PCL includes
 #include <pcl/features/feature.h>
+#include <pcl/search/kdtree.h>
 #include <pcl_msgs/msg/point_indices.hpp>
 
 #include "pcl_ros/pcl_node.hpp"
@@ -58,13 +63,16 @@ namespace pcl_ros
   ///////////////////////////////////////////////////////////////////////////////////////////
   /** \brief @b Feature represents the base feature class. Some generic 3D operations that 
     * are applicable to all features are defined here as static methods.
+    *
+    * The input, surface and output topics are sensor_msgs/PointCloud2: the input and surface are converted to
+    * pcl::PointCloud<pcl::PointXYZ>, the output is converted from the feature type of the child.
     * \author Radu Bogdan Rusu
     */
   class Feature : public PCLNode
   {
     public:
-      typedef pcl::KdTree<pcl::PointXYZ> KdTree;
-      typedef pcl::KdTree<pcl::PointXYZ>::Ptr KdTreePtr;
+      typedef pcl::search::Search<pcl::PointXYZ> KdTree;
+      typedef pcl::search::Search<pcl::PointXYZ>::Ptr KdTreePtr;
 
       typedef pcl::PointCloud<pcl::PointXYZ> PointCloudIn;
       typedef PointCloudIn::Ptr PointCloudInPtr;
@@ -73,45 +81,74 @@ namespace pcl_ros
       typedef std::shared_ptr <std::vector<int> > IndicesPtr;
       typedef std::shared_ptr <const std::vector<int> > IndicesConstPtr;
 
-      /** \brief Empty constructor. */
+      /** \brief Empty constructor. The children call subscribe () at the end of their own constructor, once their
+        * implementation is configured.
+        */
       Feature (std::string node_name, const rclcpp::NodeOptions& options);
 
     protected:
-      /** \brief The input point cloud dataset. */
-      //PointCloudInConstPtr input_;
-
-      /** \brief A pointer to the vector of point indices to use. */
-      //IndicesConstPtr indices_;
-
-      /** \brief An input point cloud describing the surface that is to be used for nearest neighbors estimation. */
-      //PointCloudInConstPtr surface_;
-
-      /** \brief A pointer to the spatial search object. */
+      /** \brief The spatial search object to use for the frame being computed, over the surface (or the input if
+        * there is no surface). Shared through SearchCache when \a use_search_cache_ is set, null otherwise, in which
+        * case the PCL implementation builds its own.
+        */
       KdTreePtr tree_;
-      // pcl::search::KdTree<pcl::PointXYZ>::Ptr tree 
+
       /** \brief The number of K nearest neighbors to use for each point. */
-      int k_;
+      int k_ = 10;
 
       /** \brief The nearest neighbors search radius for each point. */
-      double search_radius_;
+      double search_radius_ = 0.0;
+
+      /** \brief The quality level of the frame being computed, see PCLNode::qualityLevel (). */
+      int quality_level_ = 0;
+
+      /** \brief Internal mutex, held while a frame is computed and while the parameters are set. */
+      std::mutex mutex_;
+
+      /** \brief Parameter callback function handle. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr callback_handle_;
+
+      /** \brief The number of K nearest neighbors to use for the frame being computed, reduced at lower qualities. */
+      inline int
+      searchK () const
+      {
+        return (k_ > 0 ? std::max (1, static_cast<int> (k_ * QualityController::scale (quality_level_))) : k_);
+      }
+
+      /** \brief The search radius to use for the frame being computed, shrunk at lower qualities. */
+      inline double
+      searchRadius () const
+      {
+        return (search_radius_ * QualityController::radiusScale (quality_level_));
+      }
 
       // ROS node attributes
       /** \brief The surface PointCloud subscriber filter. */
-      message_filters::Subscriber<PointCloudIn> sub_surface_filter_;
+      message_filters::Subscriber<PointCloud2> sub_surface_filter_;
       
       /** \brief The input PointCloud subscriber. */
-      rclcpp::Subscription<PointCloudIn>::SharedPtr sub_input_;
-
+      rclcpp::Subscription<PointCloud2>::SharedPtr sub_input_;
 
       /** \brief Set to true if the node needs to listen for incoming point clouds representing the search surface. */
-      bool use_surface_;
+      bool use_surface_ = false;
 
-      /** \brief Parameter for the spatial locator tree. By convention, the values represent:
-        * 0: ANN (Approximate Nearest Neigbor library) kd-tree
-        * 1: FLANN (Fast Library for Approximate Nearest Neighbors) kd-tree
-        * 2: Organized spatial dataset index
+      /** \brief Set to true to publish the normals bundled with their points as pcl::PointNormal, for the
+        * point_normals input of the FeatureFromNormals nodes. Normal estimation nodes only.
         */
-      int spatial_locator_type_;
+      bool output_point_normals_ = false;
+
+      /** \brief Declare the output_point_normals parameter. Called by the normal estimation nodes. */
+      void
+      declareOutputPointNormals ();
+
+      /** \brief Publish the normals of a frame, bundled with their points if \a output_point_normals_ is set.
+        * \param cloud the input point cloud
+        * \param indices the indices the normals were computed at, null for all the points
+        * \param normals the normals, with the header of the input
+        */
+      void
+      publishNormals (const PointCloudInConstPtr &cloud, const IndicesPtr &indices,
+                      const pcl::PointCloud<pcl::Normal> &normals);
 
       /** \brief Publish an empty point cloud of the feature output type. */
       virtual void emptyPublish (const PointCloudInConstPtr &cloud) = 0;
@@ -121,30 +158,64 @@ namespace pcl_ros
                                    const PointCloudInConstPtr &surface,
                                    const IndicesPtr &indices) = 0;
 
+      /** \brief Convert a feature point cloud to a PointCloud2 and publish it on \a output.
+        * \param output the feature point cloud, with the header of the input
+        */
+      template <typename PointT> void
+      publishOutput (const pcl::PointCloud<PointT> &output)
+      {
+        auto msg = std::make_unique<PointCloud2> ();
+        pcl::toROSMsg (output, *msg);
+        pub_output_->publish (std::move (msg));
+      }
+
+      /** \brief Parameter callback
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      config_callback (const std::vector<rclcpp::Parameter> & params);
+
+      /** \brief Convert the input (and surface) of a frame and set \a tree_, from SearchCache if enabled.
+        * \param cloud the input point cloud message
+        * \param surface the surface point cloud message, null if none
+        * \param cloud_out the converted input
+        * \param surface_out the converted surface, null if none
+        */
+      void
+      prepareInputs (const PointCloud2::ConstSharedPtr &cloud, const PointCloud2::ConstSharedPtr &surface,
+                     PointCloudInConstPtr &cloud_out, PointCloudInConstPtr &surface_out);
+
       /** \brief Null passthrough filter, used for pushing empty elements in the 
         * synchronizer */
       message_filters::PassThrough<PointIndices> nf_pi_;
-      message_filters::PassThrough<PointCloudIn> nf_pc_;
+      message_filters::PassThrough<PointCloud2> nf_pc_;
 
       /** \brief Input point cloud callback.
         * Because we want to use the same synchronizer object, we push back
         * empty elements with the same timestamp.
         */
       inline void
-      input_callback (const PointCloudInConstPtr &input)
+      input_callback (const PointCloud2::ConstSharedPtr &input)
       {
-        PointIndices indices;
-        indices.header.stamp = pcl_conversions::fromPCL(input->header).stamp;
-        PointCloudIn cloud;
-        cloud.header.stamp = input->header.stamp;
-        nf_pc_.add (cloud.makeShared());
-        nf_pi_.add (std::make_shared<PointIndices> (indices));
+        auto indices = std::make_shared<PointIndices> ();
+        indices->header.stamp = input->header.stamp;
+        auto cloud = std::make_shared<PointCloud2> ();
+        cloud->header.stamp = input->header.stamp;
+        nf_pc_.add (cloud);
+        nf_pi_.add (indices);
+      }
+
+      /** \brief Get the message of an optional synchronized input, null for the empty elements of input_callback (). */
+      static inline PointCloud2::ConstSharedPtr
+      optional (const PointCloud2::ConstSharedPtr &cloud)
+      {
+        return ((cloud && !cloud->fields.empty ()) ? cloud : PointCloud2::ConstSharedPtr ());
       }
 
     private:
       /** \brief Synchronized input, surface, and point indices.*/
-      std::shared_ptr <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudIn, PointIndices> > > sync_input_surface_indices_a_;
-      std::shared_ptr <message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudIn, PointIndices> > > sync_input_surface_indices_e_;
+      std::shared_ptr <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointCloud2, PointIndices> > > sync_input_surface_indices_a_;
+      std::shared_ptr <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointCloud2, PointIndices> > > sync_input_surface_indices_e_;
 
 
       virtual void subscribe ();
@@ -154,12 +225,10 @@ namespace pcl_ros
         * \param cloud_surface the pointer to the surface point cloud
         * \param indices the pointer to the input point cloud indices
         */
-      void input_surface_indices_callback (const PointCloudInConstPtr &cloud, 
-                                           const PointCloudInConstPtr &cloud_surface, 
+      void input_surface_indices_callback (const PointCloud2::ConstSharedPtr &cloud,
+                                           const PointCloud2::ConstSharedPtr &cloud_surface,
                                            const PointIndicesConstPtr &indices);
     
-      rclcpp::Publisher<PointCloud2>::SharedPtr pub_output_;
-    
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
@@ -182,6 +251,35 @@ namespace pcl_ros
       /** \brief A pointer to the input dataset that contains the point normals of the XYZ dataset. */
       PointCloudNConstPtr normals_;
 
+      /** \brief The keypoint selection method: none (every input point), uniform_sampling, voxel_centroid or iss3d. */
+      std::string keypoint_method_ = "none";
+
+      /** \brief The voxel size of uniform_sampling and voxel_centroid, or the salient radius of iss3d. */
+      double keypoint_radius_ = 0.05;
+
+      /** \brief The keypoint indices publisher. The descriptor i of the output is computed at the keypoint i. */
+      rclcpp::Publisher<PointIndices>::SharedPtr pub_keypoints_;
+
+      /** \brief Parameter callback function handle for the keypoint parameters. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr keypoints_callback_handle_;
+
+      /** \brief Parameter callback for the keypoint parameters.
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      keypoints_callback (const std::vector<rclcpp::Parameter> & params);
+
+      /** \brief Select the keypoints to compute the descriptors at. The neighbors are still searched in the whole
+        * surface (or input).
+        * \param cloud the input point cloud
+        * \param surface the search surface, null if none
+        * \param indices the indices of the input to select from, null for all the points
+        * \return the indices of the keypoints in \a cloud
+        */
+      IndicesPtr
+      selectKeypoints (const PointCloudInConstPtr &cloud, const PointCloudInConstPtr &surface,
+                       const IndicesPtr &indices);
+
       /** \brief Publish an empty point cloud of the feature output type. */
       virtual void emptyPublish (const PointCloudInConstPtr &cloud) = 0;
 
@@ -192,12 +290,24 @@ namespace pcl_ros
                                    const IndicesPtr &indices) = 0;
 
     private:
+      /** \brief Set to true to receive the points and normals bundled in one pcl::PointNormal cloud on the input
+        * topic, instead of synchronizing the input and normals topics.
+        */
+      bool point_normals_ = false;
+
+      /** \brief The indices subscriber, when \a point_normals_ is set. */
+      rclcpp::Subscription<PointIndices>::SharedPtr sub_indices_;
+
+      /** \brief The latest indices received, when \a point_normals_ is set. */
+      PointIndicesConstPtr latest_indices_;
+      std::mutex latest_indices_mutex_;
+
       /** \brief The normals PointCloud subscriber filter. */
-      message_filters::Subscriber<PointCloudN> sub_normals_filter_;
+      message_filters::Subscriber<PointCloud2> sub_normals_filter_;
 
       /** \brief Synchronized input, normals, surface, and point indices.*/
-      std::shared_ptr<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > sync_input_normals_surface_indices_a_;
-      std::shared_ptr<message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > sync_input_normals_surface_indices_e_;
+      std::shared_ptr<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointCloud2, PointCloud2, PointIndices> > > sync_input_normals_surface_indices_a_;
+      std::shared_ptr<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointCloud2, PointCloud2, PointIndices> > > sync_input_normals_surface_indices_e_;
     
       virtual void subscribe ();
       virtual void unsubscribe ();
@@ -213,11 +323,17 @@ namespace pcl_ros
         * \param cloud_surface the pointer to the surface point cloud
         * \param indices the pointer to the input point cloud indices
         */
-      void input_normals_surface_indices_callback (const PointCloudInConstPtr &cloud, 
-                                                   const PointCloudNConstPtr &cloud_normals, 
-                                                   const PointCloudInConstPtr &cloud_surface, 
+      void input_normals_surface_indices_callback (const PointCloud2::ConstSharedPtr &cloud,
+                                                   const PointCloud2::ConstSharedPtr &cloud_normals,
+                                                   const PointCloud2::ConstSharedPtr &cloud_surface,
                                                    const PointIndicesConstPtr &indices);
 
+      /** \brief Input point cloud callback, when \a point_normals_ is set. The bundled cloud is both the input and
+        * the normals, processed with the latest indices if \a use_indices_ is set.
+        * \param cloud the pointer to the input pcl::PointNormal point cloud
+        */
+      void input_point_normals_callback (const PointCloud2::ConstSharedPtr &cloud);
+
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
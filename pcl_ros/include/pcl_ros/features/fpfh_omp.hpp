@@ -70,6 +70,15 @@ namespace pcl_ros
     private:
       pcl::FPFHEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> impl_;
 
+      /** \brief Parameter callback function handle for \a num_threads. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr threads_callback_handle_;
+
+      /** \brief Parameter callback, sets the number of OpenMP threads of the implementation.
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      threads_callback (const std::vector<rclcpp::Parameter> & params);
+
       typedef pcl::PointCloud<pcl::FPFHSignature33> PointCloudOut;
 
       /** \brief Publish an empty point cloud of the feature output type. */
@@ -80,11 +89,6 @@ namespace pcl_ros
                            const PointCloudNConstPtr &normals,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-      // FIXME Temporary fix
-      pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_;
-    
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
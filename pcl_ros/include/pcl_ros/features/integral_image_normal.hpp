@@ -0,0 +1,86 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FEATURES__INTEGRAL_IMAGE_NORMAL_HPP_
+#define PCL_ROS__FEATURES__INTEGRAL_IMAGE_NORMAL_HPP_
+
+#include <pcl/features/integral_image_normal.h>
+#include <pcl/features/normal_3d.h>
+#include "pcl_ros/features/feature.hpp"
+
+namespace pcl_ros
+{
+  /** \brief @b IntegralImageNormalEstimation estimates the surface normals of organized point clouds (RGB-D images,
+    * range images) from integral images, in time independent of the size of the neighborhood.
+    *
+    * Unorganized clouds (height 1), and clouds given with a separate search surface, fall back to the kd-tree
+    * search of \a NormalEstimation, with the k_search and radius_search parameters.
+    */
+  class IntegralImageNormalEstimation: public Feature
+  {
+    public:
+      IntegralImageNormalEstimation (const rclcpp::NodeOptions& options);
+
+    private:
+      /** \brief PCL implementation object for organized clouds. */
+      pcl::IntegralImageNormalEstimation<pcl::PointXYZ, pcl::Normal> impl_;
+
+      /** \brief PCL implementation object for unorganized clouds. */
+      pcl::NormalEstimation<pcl::PointXYZ, pcl::Normal> search_impl_;
+
+      typedef pcl::PointCloud<pcl::Normal> PointCloudOut;
+
+      /** \brief Parameter callback function handle for the integral image parameters. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr integral_callback_handle_;
+
+      /** \brief Parameter callback for the integral image parameters.
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      integral_callback (const std::vector<rclcpp::Parameter> & params);
+
+      /** \brief Publish an empty point cloud of the feature output type. */
+      void emptyPublish (const PointCloudInConstPtr &cloud);
+
+      /** \brief Compute the feature and publish it. */
+      void computePublish (const PointCloudInConstPtr &cloud,
+                           const PointCloudInConstPtr &surface,
+                           const IndicesPtr &indices);
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FEATURES__INTEGRAL_IMAGE_NORMAL_HPP_
@@ -0,0 +1,74 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FEATURES__KEYPOINTS_HPP_
+#define PCL_ROS__FEATURES__KEYPOINTS_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace pcl_ros
+{
+  /** \brief Select one keypoint per voxel of a point cloud.
+    * \param cloud the point cloud
+    * \param indices the indices of the points to select from, null for all the points
+    * \param leaf_size the size of the voxels
+    * \param centroid pick the point nearest to the centroid of the points of the voxel if true (voxel centroid),
+    * nearest to the center of the voxel otherwise (uniform sampling)
+    * \param keypoints the indices of the selected points in \a cloud, in increasing order
+    */
+  void
+  voxelKeypoints (const pcl::PointCloud<pcl::PointXYZ> &cloud, const std::vector<int> *indices, float leaf_size,
+                  bool centroid, std::vector<int> &keypoints);
+
+  /** \brief Select the Intrinsic Shape Signature (ISS3D) keypoints of a point cloud. The search object is built
+    * here: pcl::Keypoint sets the input of the one it is given, which must not happen to a shared one.
+    * \param cloud the point cloud
+    * \param surface the search surface, null to search \a cloud
+    * \param indices the indices of the points to select from, null for all the points
+    * \param salient_radius the radius of the neighborhood of the scatter matrices, the non maxima suppression uses
+    * two thirds of it
+    * \param keypoints the indices of the selected points in \a cloud
+    */
+  void
+  issKeypoints (const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &cloud,
+                const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &surface,
+                const std::shared_ptr<std::vector<int> > &indices, double salient_radius,
+                std::vector<int> &keypoints);
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FEATURES__KEYPOINTS_HPP_
@@ -52,7 +52,7 @@ namespace pcl_ros
   class MomentInvariantsEstimation: public Feature
   {
     public:
-      MomentInvariantsEstimation(const rclcpp::NodeOptions& options) : Feature("MomentInvariantsEstimationNode", options) {};
+      MomentInvariantsEstimation(const rclcpp::NodeOptions& options) : Feature("MomentInvariantsEstimationNode", options) { subscribe (); };
     
     private:
       pcl::MomentInvariantsEstimation<pcl::PointXYZ, pcl::MomentInvariants> impl_;
@@ -66,10 +66,6 @@ namespace pcl_ros
       void computePublish (const PointCloudInConstPtr &cloud,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
-    
-      pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_;
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -39,7 +39,9 @@
 #define PCL_ROS__FEATURES__NORMAL_3D_HPP_
 
 #include <pcl/features/normal_3d.h>
+#include <std_msgs/msg/float32.hpp>
 #include "pcl_ros/features/feature.hpp"
+#include "pcl_ros/features/normal_cache.hpp"
 
 namespace pcl_ros
 {
@@ -61,6 +63,26 @@ namespace pcl_ros
 
       typedef pcl::PointCloud<pcl::Normal> PointCloudOut;
 
+      /** \brief Set to true to reuse the normals of the unchanged regions of the previous frame. Only used for the
+        * inputs without indices nor surface.
+        */
+      bool use_normal_cache_ = false;
+
+      /** \brief The normals of the previous frame, per voxel. */
+      NormalCache normal_cache_;
+
+      /** \brief The publisher of the fraction of the normals reused from the previous frame. */
+      rclcpp::Publisher<std_msgs::msg::Float32>::SharedPtr pub_reused_normals_;
+
+      /** \brief Parameter callback function handle for the normal cache parameters. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr cache_callback_handle_;
+
+      /** \brief Parameter callback for the normal cache parameters.
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      cache_callback (const std::vector<rclcpp::Parameter> & params);
+
       /** \brief Publish an empty point cloud of the feature output type.
         * \param cloud the input point cloud to copy the header from.
         */ 
@@ -70,9 +92,6 @@ namespace pcl_ros
       void computePublish (const PointCloudInConstPtr &cloud,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
-      pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_;
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -55,6 +55,15 @@ namespace pcl_ros
     private:
       pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> impl_;
 
+      /** \brief Parameter callback function handle for \a num_threads. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr threads_callback_handle_;
+
+      /** \brief Parameter callback, sets the number of OpenMP threads of the implementation.
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      threads_callback (const std::vector<rclcpp::Parameter> & params);
+
       typedef pcl::PointCloud<pcl::Normal> PointCloudOut;
 
       /** \brief Publish an empty point cloud of the feature output type. */
@@ -64,10 +73,6 @@ namespace pcl_ros
       void computePublish (const PointCloudInConstPtr &cloud,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-    
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
-      pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_;
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
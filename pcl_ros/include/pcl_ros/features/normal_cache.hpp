@@ -0,0 +1,158 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FEATURES__NORMAL_CACHE_HPP_
+#define PCL_ROS__FEATURES__NORMAL_CACHE_HPP_
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include "pcl_ros/filters/voxel_hash.hpp"
+
+namespace pcl_ros
+{
+  /** \brief @b NormalCache keeps the normals of the previous frame per voxel, to only recompute the normals of the
+    * regions of a quasi-static scene that changed.
+    *
+    * The normals of a voxel are reused when the points of the 3x3x3 voxels around it did not change: their number
+    * changed by at most 3 sqrt (n), and their centroid moved by at most the tolerance. The leaf size must therefore be
+    * at least the extent of the normal estimation neighborhood.
+    *
+    * The count check only absorbs the sampling noise of a static surface: the number of returns of a region varies
+    * from a frame to the next like a Poisson count, whose standard deviation is sqrt (n), so 3 sqrt (n) keeps about
+    * 99.7% of the static blocks. Relative to n it gets tighter as the blocks get denser (10% at 900 points, 3% at
+    * 10000). The centroid is the main test: a change that keeps both the number of points and their centroid, e.g. a
+    * few points of the block replaced by as many on the other side of the centroid, is not detected.
+    *
+    * A reused normal is the one of the point of the previous frame at the same pixel, for organized clouds of the same
+    * size as the previous frame and if that point lies in the same voxel. Otherwise it is the one of the nearest point
+    * of the previous frame in the same voxel.
+    */
+  class NormalCache
+  {
+    public:
+      /** \brief Set the size of the voxels. Clears the cache. */
+      inline void
+      setLeafSize (float leaf_size)
+      {
+        leaf_size_ = leaf_size;
+        clear ();
+      }
+
+      /** \brief Set the distance the centroid of the neighborhood of a voxel can move by and still be considered
+        * unchanged.
+        */
+      inline void
+      setTolerance (float tolerance)
+      {
+        tolerance_ = tolerance;
+      }
+
+      /** \brief Reuse the normals of the unchanged regions of a frame.
+        * \param cloud the points of the frame
+        * \param normals resized to the size of \a cloud, set for the reused normals and NaN for the others
+        * \param changed the indices of the points whose normals must be recomputed
+        * \return the number of reused normals
+        */
+      size_t
+      lookup (const pcl::PointCloud<pcl::PointXYZ> &cloud, pcl::PointCloud<pcl::Normal> &normals,
+              std::vector<int> &changed);
+
+      /** \brief Store the normals of the frame given to the last lookup (), for the next frame.
+        * \param cloud the points of the frame
+        * \param normals the normals of all the points of the frame
+        */
+      void
+      update (const pcl::PointCloud<pcl::PointXYZ> &cloud, const pcl::PointCloud<pcl::Normal> &normals);
+
+      /** \brief Forget the previous frame. */
+      inline void
+      clear ()
+      {
+        previous_map_.clear ();
+        previous_.clear ();
+        previous_point_voxels_.clear ();
+        previous_point_slots_.clear ();
+        previous_width_ = previous_height_ = 0;
+      }
+
+    private:
+      struct Voxel
+      {
+        VoxelKey key;
+        uint32_t count = 0;
+        Eigen::Vector3f sum = Eigen::Vector3f::Zero ();
+        /** \brief Set by update (), sorted along \a axis. */
+        std::vector<pcl::PointXYZ> points;
+        std::vector<pcl::Normal> normals;
+        /** \brief The axis along which the points are the most spread. */
+        int axis = 0;
+      };
+
+      /** \brief Check whether the neighborhood of a voxel is unchanged since the previous frame. */
+      bool
+      unchanged (const VoxelKey &key) const;
+
+      /** \brief Find the nearest point of a voxel, scanning outwards from \a p along the sorted axis.
+        * \return the index of the point in \a voxel.points, which must not be empty
+        */
+      static size_t
+      nearest (const Voxel &voxel, const Eigen::Vector3f &p);
+
+      float leaf_size_ = 0.1f;
+      float tolerance_ = 0.01f;
+
+      /** \brief The voxels of the previous frame, with their points and normals. */
+      VoxelHashMap previous_map_;
+      std::vector<Voxel> previous_;
+      /** \brief The voxel of each point of the previous frame (npos if invalid) and its index in the voxel. */
+      std::vector<uint32_t> previous_point_voxels_;
+      std::vector<uint32_t> previous_point_slots_;
+      uint32_t previous_width_ = 0, previous_height_ = 0;
+
+      /** \brief The voxels of the frame given to lookup (), and the voxel of each of its points (npos if invalid). */
+      VoxelHashMap current_map_;
+      std::vector<Voxel> current_;
+      std::vector<uint32_t> point_voxels_;
+      std::vector<uint32_t> point_slots_;
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FEATURES__NORMAL_CACHE_HPP_
@@ -83,10 +83,6 @@ namespace pcl_ros
                            const PointCloudNConstPtr &normals,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-      pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_;
-
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -54,7 +54,7 @@ namespace pcl_ros
   class PrincipalCurvaturesEstimation : public FeatureFromNormals
   {
     public:
-      PrincipalCurvaturesEstimation(const rclcpp::NodeOptions& options) : FeatureFromNormals("PrincipalCurvaturesEstimation", options) {};
+      PrincipalCurvaturesEstimation(const rclcpp::NodeOptions& options) : FeatureFromNormals("PrincipalCurvaturesEstimation", options) { subscribe (); };
     
     private:
       pcl::PrincipalCurvaturesEstimation<pcl::PointXYZ, pcl::Normal, pcl::PrincipalCurvatures> impl_;
@@ -70,9 +70,6 @@ namespace pcl_ros
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
 
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
-      pcl::search::KdTree<pcl::PointXYZ>::Ptr tree_;
-
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
@@ -63,9 +63,7 @@ namespace pcl_ros
                            const PointCloudNConstPtr &normals,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
-    
+
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
@@ -52,6 +52,15 @@ namespace pcl_ros
     private:
       pcl::SHOTEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::SHOT352> impl_;
 
+      /** \brief Parameter callback function handle for \a num_threads. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr threads_callback_handle_;
+
+      /** \brief Parameter callback, sets the number of OpenMP threads of the implementation.
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      threads_callback (const std::vector<rclcpp::Parameter> & params);
+
       typedef pcl::PointCloud<pcl::SHOT352> PointCloudOut;
 
       /** \brief Publish an empty point cloud of the feature output type. */
@@ -62,9 +71,7 @@ namespace pcl_ros
                            const PointCloudNConstPtr &normals,
                            const PointCloudInConstPtr &surface,
                            const IndicesPtr &indices);
-    
-      rclcpp::Publisher<PointCloudOut>::SharedPtr pub_output_;
-    
+
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
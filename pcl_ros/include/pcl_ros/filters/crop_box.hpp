@@ -39,6 +39,8 @@
 #ifndef PCL_ROS__FILTERS__CROP_BOX_HPP_
 #define PCL_ROS__FILTERS__CROP_BOX_HPP_
 
+#include <map>
+
 // PCL includes
 #include <pcl/filters/crop_box.h>
 #include "pcl_ros/filters/filter.hpp"
@@ -47,6 +49,8 @@
 namespace pcl_ros
 {
   /** \brief @b CropBox is a filter that allows the user to filter all the data inside of a given box.
+    * The box can be oriented (translation and rotation parameters) and posed in any TF frame (box_frame parameter):
+    * the points are moved into the box frame while being tested, the cloud itself is not transformed.
     *
     * \author Radu Bogdan Rusu
     * \author Justin Rosen
@@ -65,17 +69,24 @@ namespace pcl_ros
         */
       void
       filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
-              PointCloud2 &output) override
-      {
-        std::lock_guard<std::mutex> lock(mutex_);
-        pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
-        pcl_conversions::toPCL (*(input), *(pcl_input));
-        impl_.setInputCloud (pcl_input);
-        impl_.setIndices(indices);
-        pcl::PCLPointCloud2 pcl_output;
-        impl_.filter (pcl_output);
-        pcl_conversions::moveFromPCL(pcl_output, output);
-      }
+              PointCloud2 &output) override;
+
+      /** \brief Select the points that pass the filter, without building the filtered dataset.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the indices of the points of \a input that pass the filter
+        */
+      bool
+      filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                     std::vector<int> &output) override;
+
+      /** \brief Drop the frames whose transformation to \a box_frame_ is not available. The transformation is kept
+        * for the following filter () or filterIndices () call on the same frame.
+        * \param input the input point cloud dataset
+        * \param reason set to "tf" when the frame is dropped
+        */
+      bool
+      acceptInput (const PointCloud2 &input, std::string &reason) override;
 
       /** \brief Parameter callback
         * \param params parameter values to set
@@ -86,6 +97,32 @@ namespace pcl_ros
     private:
       /** \brief The PCL filter implementation used. */
       pcl::CropBox<pcl::PCLPointCloud2> impl_;
+      ImplPool<pcl::CropBox<pcl::PCLPointCloud2>> impl_pool_{impl_, mutex_, num_workers_};
+
+      /** \brief The TF frame of the box pose, the input frame if empty. */
+      std::string box_frame_;
+
+      /** \brief Get the transformation from the input frame to \a box_frame_, identity if \a box_frame_ is empty.
+        * \param input the input point cloud dataset
+        * \param transform the resultant transformation
+        * \return false if the transformation is not available
+        */
+      bool
+      lookupBoxTransform (const PointCloud2 &input, Eigen::Affine3f &transform);
+
+      /** \brief Get the transformation found by acceptInput () for \a input, or look it up if there is none.
+        * \param input the input point cloud dataset
+        * \param transform the resultant transformation
+        * \return false if the transformation is not available
+        */
+      bool
+      takeBoxTransform (const PointCloud2 &input, Eigen::Affine3f &transform);
+
+      /** \brief The transformations found by acceptInput () for the frames being filtered, by frame. Several frames
+        * are in flight at once with \a num_workers_ > 1. */
+      std::map<const PointCloud2 *, Eigen::Matrix4f, std::less<const PointCloud2 *>,
+               Eigen::aligned_allocator<std::pair<const PointCloud2 * const, Eigen::Matrix4f> > > box_transforms_;
+      std::mutex box_transforms_mutex_;
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
@@ -66,13 +66,13 @@ namespace pcl_ros
       filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
               PointCloud2 &output)
       {
-        // std::lock_guard<std::mutex> lock(mutex_);
         pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
         pcl_conversions::toPCL(*(input), *(pcl_input));
-        impl_.setInputCloud (pcl_input);
-        impl_.setIndices (indices);
+        auto impl = impl_pool_.acquire();
+        impl->setInputCloud (pcl_input);
+        impl->setIndices (indices);
         pcl::PCLPointCloud2 pcl_output;
-        impl_.filter (pcl_output);
+        impl->filter (pcl_output);
         pcl_conversions::moveFromPCL(pcl_output, output);
       }
 
@@ -87,6 +87,7 @@ namespace pcl_ros
       pcl::ExtractIndices<pcl::PCLPointCloud2> impl_;
     
       std::mutex mutex_;
+      ImplPool<pcl::ExtractIndices<pcl::PCLPointCloud2>> impl_pool_{impl_, mutex_, num_workers_};
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -41,6 +41,7 @@
 // PCL includes
 #include <pcl/filters/filter.h>
 #include "pcl_ros/pcl_node.hpp"
+#include "pcl_ros/impl_pool.hpp"
 
 namespace pcl_ros
 {
@@ -48,6 +49,10 @@ namespace pcl_ros
 
   /** \brief @b Filter represents the base filter class. Some generic 3D operations that are applicable to all filters
     * are defined here as static methods.
+    *
+    * With \a num_workers_ > 1, filter () runs concurrently for different frames. The children then keep their PCL
+    * implementation object \a impl_ for the configuration only, set from the parameter callback under \a mutex_, and
+    * filter each frame with a copy acquired from an ImplPool built on it (\a impl_pool_).
     * \author Radu Bogdan Rusu
     */
   class Filter : public PCLNode
@@ -58,7 +63,13 @@ namespace pcl_ros
       typedef std::shared_ptr <std::vector<int> > IndicesPtr;
       typedef std::shared_ptr <const std::vector<int> > IndicesConstPtr;
     
-      Filter (std::string node_name, const rclcpp::NodeOptions& options);
+      /** \brief Constructor.
+        * \param node_name the name of the node
+        * \param options the node options
+        * \param supports_output_indices true if the child implements filterIndices (), otherwise setting the
+        * output_indices parameter fails the construction
+        */
+      Filter (std::string node_name, const rclcpp::NodeOptions& options, bool supports_output_indices = false);
 
     protected:
       /** \brief The input PointCloud subscriber. */
@@ -81,19 +92,32 @@ namespace pcl_ros
       /** \brief The input TF frame the data should be transformed into, if input.header.frame_id is different. */
       std::string tf_input_frame_;
 
-      /** \brief The original data input TF frame. */
-      std::string tf_input_orig_frame_;
-
       /** \brief The output TF frame the data should be transformed into, if input.header.frame_id is different. */
       std::string tf_output_frame_;
 
       /** \brief Internal mutex. */
       std::mutex mutex_;
 
+      /** \brief Keeps the output in the input order when \a num_workers_ > 1, null otherwise. */
+      std::unique_ptr<FrameSequencer> sequencer_;
+
+      /** \brief Drops the frames received while \a num_workers_ frames are being processed, null otherwise. */
+      std::unique_ptr<AdmissionGate> gate_;
+
       /** \brief Parameter callback function handle. */
       rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr callback_handle_;
 
-      /** \brief Virtual abstract filter method. To be implemented by every child. 
+      /** \brief Set to true to publish the indices of the points that pass the filter on \a output_indices, instead
+        * of the filtered point cloud on \a output. Only available for the filters implementing filterIndices ().
+        */
+      bool output_indices_ = false;
+
+      /** \brief The output PointIndices publisher, when \a output_indices_ is set. \a pub_output_ is not created
+        * then. */
+      rclcpp::Publisher<PointIndices>::SharedPtr pub_indices_;
+
+      /** \brief Virtual abstract filter method. To be implemented by every child. Called concurrently for
+        * different frames when \a num_workers_ > 1.
         * \param input the input point cloud dataset.
         * \param indices a pointer to the vector of point indices to use.   
         * \param output the resultant filtered PointCloud2
@@ -101,7 +125,41 @@ namespace pcl_ros
       virtual void 
       filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
               PointCloud2 &output) = 0;
+
+      /** \brief Select the points that pass the filter, without building the filtered point cloud. Used instead of
+        * filter () when \a output_indices_ is set, under the same concurrency rules.
+        * \param input the input point cloud dataset.
+        * \param indices a pointer to the vector of point indices to use.
+        * \param output the indices of the points of \a input that pass the filter
+        * \return false if the filter does not support indices output (default), or could not process \a input
+        */
+      virtual bool
+      filterIndices (const PointCloud2::ConstSharedPtr & /*input*/, const IndicesPtr & /*indices*/,
+                     std::vector<int> & /*output*/)
+      {
+        return (false);
+      }
     
+      /** \brief Check whether a frame can be processed, before filter () or filterIndices () are called on it. Called
+        * concurrently for different frames when \a num_workers_ > 1.
+        * \param input the input point cloud dataset.
+        * \param reason the reason the frame is dropped for in the statistics, when it cannot be processed
+        * \return false to drop the frame (default: true)
+        */
+      virtual bool
+      acceptInput (const PointCloud2 & /*input*/, std::string & /*reason*/)
+      {
+        return (true);
+      }
+
+      /** \brief Copy a subset of the points of a cloud, e.g. the result of filterIndices ().
+        * \param input the input point cloud dataset
+        * \param indices the indices of the points to copy
+        * \param output the resultant unorganized point cloud, with the fields of \a input
+        */
+      static void
+      copyPoints (const PointCloud2 &input, const std::vector<int> &indices, PointCloud2 &output);
+
       /** \brief Lazy transport subscribe routine. */
       virtual void
       subscribe();
@@ -110,18 +168,41 @@ namespace pcl_ros
       virtual void
       unsubscribe();
     
-      /** \brief Call the child filter () method, optionally transform the result, and publish it.
+      /** \brief Call the child filter () method, optionally transform the result, and publish it. With
+        * \a output_indices_, call filterIndices () and publish the indices instead.
         * \param input the input point cloud dataset.
         * \param indices a pointer to the vector of point indices to use.   
+        * \param input_orig_frame the frame of the input as received, before any \a tf_input_frame_ transform
+        * \param frame the statistics record of this frame
+        * \param ticket the place of this frame in the output order
         */
       void 
-      computePublish (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices);
+      computePublish (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                      const std::string &input_orig_frame,
+                      NodeStatistics::Frame &frame, FrameSequencer::Ticket &ticket);
 
     private:
       /** \brief Synchronized input, and indices.*/
       std::shared_ptr<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointIndices> > >       sync_input_indices_e_;
       std::shared_ptr<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointIndices> > > sync_input_indices_a_;
 
+      /** \brief The indices subscriber, when \a latched_indices_ is set. */
+      rclcpp::Subscription<PointIndices>::SharedPtr sub_indices_;
+
+      /** \brief The latest indices received, when \a latched_indices_ is set. */
+      PointIndicesConstPtr latest_indices_;
+      std::mutex latest_indices_mutex_;
+
+      /** \brief Indices callback, caches the latest indices when \a latched_indices_ is set. */
+      void
+      indices_callback (const PointIndicesConstPtr indices);
+
+      /** \brief PointCloud2 callback when \a latched_indices_ is set: processes the cloud with the latest indices,
+        * without waiting for indices with a matching stamp.
+        */
+      void
+      input_latched_indices_callback (const PointCloud2::ConstSharedPtr cloud);
+
       /** \brief PointCloud2 + Indices data callback. */
       void 
       input_indices_callback (const PointCloud2::ConstSharedPtr cloud,
@@ -0,0 +1,150 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FILTERS__FILTER_CHAIN_HPP_
+#define PCL_ROS__FILTERS__FILTER_CHAIN_HPP_
+
+// PCL includes
+#include <pcl/filters/filter_indices.h>
+#include "pcl_ros/filters/filter.hpp"
+
+#include <chrono>
+#include <map>
+
+namespace pcl_ros
+{
+  /** \brief @b FilterChain runs an ordered list of PCL filters inside a single node. The input is converted to
+    * PCL once, every stage works on the same pcl::PCLPointCloud2, and only the final result is converted back and
+    * published.
+    *
+    * Stages that only select points (PassThrough, CropBox, StatisticalOutlierRemoval, RadiusOutlierRemoval) hand a
+    * list of indices to the next stage instead of copying the data. Stages that create new points (VoxelGrid)
+    * materialize an intermediate cloud.
+    *
+    * The chain is configured through the read-only \a stages parameter, a list of stage names. Each stage needs a
+    * \a <name>.type parameter (one of "passthrough", "crop_box", "voxel_grid", "statistical_outlier_removal",
+    * "radius_outlier_removal"); the remaining stage parameters are declared as \a <name>.<parameter>, using the same
+    * parameter names as the standalone filter nodes.
+    */
+  class FilterChain : public Filter
+  {
+    public:
+      FilterChain(const rclcpp::NodeOptions& options);
+
+    protected:
+      /** \brief Run all the stages of the chain.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the resultant filtered dataset
+        */
+      void
+      filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+              PointCloud2 &output) override;
+
+      /** \brief Parameter callback
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      config_callback (const std::vector<rclcpp::Parameter> & params);
+
+    private:
+      /** \brief A single step of the chain. */
+      struct Stage
+      {
+        /** \brief The user given stage name, used as parameter prefix. */
+        std::string name;
+
+        /** \brief The stage type (e.g. "voxel_grid"). */
+        std::string type;
+
+        /** \brief The PCL filter implementation used. */
+        std::shared_ptr<pcl::Filter<pcl::PCLPointCloud2> > impl;
+
+        /** \brief Set if \a impl can output indices instead of a new point cloud. */
+        std::shared_ptr<pcl::FilterIndices<pcl::PCLPointCloud2> > indices_impl;
+
+        /** \brief Duration of the last run, and the sum over all runs. */
+        std::chrono::duration<double, std::milli> last_duration{0}, total_duration{0};
+      };
+
+      /** \brief The ordered list of stages. */
+      std::vector<Stage> stages_;
+
+      /** \brief Number of processed clouds, used to report the average stage timings. */
+      size_t nr_runs_ = 0;
+
+      /** \brief Create the PCL implementation of a stage and declare its parameters.
+        * \param name the stage name
+        * \param type the stage type
+        * \param param_names the list the declared parameter names are appended to
+        */
+      Stage
+      createStage (const std::string &name, const std::string &type, std::vector<std::string> &param_names);
+
+      /** \brief Check a stage parameter before any parameter of the batch is applied.
+        * \param stage the stage the parameter belongs to
+        * \param param_name the parameter name without the stage prefix
+        * \param param the new parameter value
+        * \param reason set to the reason of the rejection
+        * \return false if the parameter is not known to this stage type, or its value is not usable
+        */
+      bool
+      checkStageParameter (const Stage &stage, const std::string &param_name, const rclcpp::Parameter &param,
+                           std::string &reason) const;
+
+      /** \brief Check that the lower limits of a stage (passthrough filter limits, crop_box minimum point) are not
+        * greater than its upper limits, once a batch of parameters is applied.
+        * \param stage the stage to check
+        * \param values the floating point parameters of the batch for this stage, without the stage prefix
+        * \param reason set to the reason of the rejection
+        * \return false if a lower limit would be greater than the corresponding upper limit
+        */
+      bool
+      checkStageLimits (const Stage &stage, const std::map<std::string, double> &values, std::string &reason) const;
+
+      /** \brief Apply a stage parameter (a parameter named "<stage>.<parameter>") to the stage implementation.
+        * \param stage the stage the parameter belongs to
+        * \param param_name the parameter name without the stage prefix
+        * \param param the new parameter value
+        * \return false if the parameter is not known to this stage type
+        */
+      bool
+      configureStage (Stage &stage, const std::string &param_name, const rclcpp::Parameter &param);
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FILTERS__FILTER_CHAIN_HPP_
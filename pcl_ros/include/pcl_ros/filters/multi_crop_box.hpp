@@ -0,0 +1,119 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FILTERS__MULTI_CROP_BOX_HPP_
+#define PCL_ROS__FILTERS__MULTI_CROP_BOX_HPP_
+
+#include <string>
+#include <vector>
+
+#include "pcl_ros/filters/filter.hpp"
+
+namespace pcl_ros
+{
+  /** \brief @b MultiCropBox crops a point cloud with several boxes at once, e.g. to remove the body of a vehicle.
+    * Every point is tested against all the boxes in a single pass over the PointCloud2 buffer: the points are loaded
+    * by blocks into x, y, z arrays and each box is evaluated on a whole block, in loops the compiler vectorizes.
+    *
+    * A point is kept if it is inside at least one "include" box (or if there is no include box), and inside no
+    * "exclude" box. Points with non finite coordinates are removed.
+    *
+    * The boxes are listed in the read-only \a boxes parameter. Each box is configured with the parameters
+    * \a <name>.min and \a <name>.max (the box extent [x, y, z] in its own frame), \a <name>.translation and
+    * \a <name>.rotation (the box pose [x, y, z] and [roll, pitch, yaw] in the input frame, as in pcl::CropBox), and
+    * \a <name>.mode ("include" or "exclude").
+    */
+  class MultiCropBox : public Filter
+  {
+    public:
+      MultiCropBox(const rclcpp::NodeOptions& options);
+
+    protected:
+      /** \brief Call the actual filter.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the resultant filtered dataset
+        */
+      void
+      filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+              PointCloud2 &output) override;
+
+      /** \brief Select the points kept by the boxes.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the indices of the kept points
+        */
+      bool
+      filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                     std::vector<int> &output) override;
+
+      /** \brief Parameter callback
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      config_callback (const std::vector<rclcpp::Parameter> & params);
+
+    private:
+      /** \brief A single box. */
+      struct Box
+      {
+        /** \brief The user given box name, used as parameter prefix. */
+        std::string name;
+
+        /** \brief Set to true to remove the points inside the box, false to keep them. */
+        bool exclude = false;
+
+        /** \brief The box extent, in the box frame. */
+        Eigen::Vector3f min_pt = Eigen::Vector3f::Constant (-1.0f);
+        Eigen::Vector3f max_pt = Eigen::Vector3f::Constant (1.0f);
+
+        /** \brief The box pose in the input frame, as translation and roll, pitch, yaw. */
+        Eigen::Vector3f translation = Eigen::Vector3f::Zero ();
+        Eigen::Vector3f rotation = Eigen::Vector3f::Zero ();
+
+        /** \brief The transformation from the input frame to the box frame, computed from the pose. */
+        Eigen::Affine3f input_to_box = Eigen::Affine3f::Identity ();
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+      };
+
+      /** \brief The boxes. */
+      std::vector<Box, Eigen::aligned_allocator<Box> > boxes_;
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FILTERS__MULTI_CROP_BOX_HPP_
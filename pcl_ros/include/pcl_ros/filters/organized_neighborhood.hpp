@@ -0,0 +1,146 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FILTERS__ORGANIZED_NEIGHBORHOOD_HPP_
+#define PCL_ROS__FILTERS__ORGANIZED_NEIGHBORHOOD_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+namespace pcl_ros
+{
+  /** \brief @b OrganizedNeighborhood computes neighborhood statistics on an organized cloud (height > 1) using fixed
+    * image-space windows instead of a kd-tree. The neighbors of a point are searched among the valid points in the
+    * (2 * half_window + 1)^2 pixels around it.
+    *
+    * The coordinates are first loaded in separate x, y, z images. The distances are then computed one window offset
+    * at a time over whole rows, in loops without branches that the compiler vectorizes.
+    */
+  class OrganizedNeighborhood
+  {
+    public:
+      /** \brief Load the coordinates of a cloud.
+        * \param cloud the input cloud
+        * \return false if \a cloud is not organized or has no little endian FLOAT32 x, y and z fields
+        */
+      bool
+      setInputCloud (const sensor_msgs::msg::PointCloud2 &cloud);
+
+      /** \brief Compute the mean distance of every point to its \a k nearest neighbors in the window.
+        * \param half_window the half size of the window
+        * \param k the number of neighbors, all the valid points of the window are used if it holds fewer
+        * \param mean_distances the mean distance of each point, infinite if it has no neighbor, NaN if it is invalid
+        */
+      void
+      computeMeanDistances (int half_window, int k, std::vector<float> &mean_distances) const;
+
+      /** \brief Count the neighbors of every point within a radius.
+        * \param half_window the half size of the window
+        * \param radius the search radius
+        * \param counts the number of neighbors of each point (itself excluded), 0 for invalid points
+        */
+      void
+      computeRadiusCounts (int half_window, float radius, std::vector<uint16_t> &counts) const;
+
+      /** \brief Get the number of points. */
+      inline size_t
+      size () const
+      {
+        return (valid_.size ());
+      }
+
+      /** \brief Check if a point has finite coordinates. */
+      inline bool
+      isValid (size_t index) const
+      {
+        return (valid_[index] != 0);
+      }
+
+      /** \brief Smallest half window with at least \a k neighbors. */
+      static int
+      halfWindowForK (int k);
+
+    private:
+      uint32_t width_ = 0, height_ = 0;
+      std::vector<float> x_, y_, z_;
+      std::vector<uint8_t> valid_;
+  };
+
+  /** \brief Statistical outlier removal on an organized cloud, with the neighbors of OrganizedNeighborhood. Same
+    * criterion as pcl::StatisticalOutlierRemoval: a point is an inlier if its mean neighbor distance is below
+    * mean + stddev_mult * stddev, computed over all the points.
+    * \param neighborhood the loaded neighborhood
+    * \param mean_k the number of neighbors to use, searched in the smallest square window holding as many pixels
+    * \param stddev_mult the standard deviation multiplier
+    * \param negative set to true to return the outliers instead of the inliers
+    * \param indices the indices of the points to test, all the points if null
+    * \param output the indices of the inliers (or outliers)
+    */
+  void
+  organizedStatisticalOutlierRemoval (const OrganizedNeighborhood &neighborhood, int mean_k,
+                                      double stddev_mult, bool negative,
+                                      const std::shared_ptr<std::vector<int> > &indices, std::vector<int> &output);
+
+  /** \brief Select the inliers from the mean distances of the points to their neighbors, with the criterion of
+    * pcl::StatisticalOutlierRemoval.
+    * \param mean_distances the mean neighbor distance of every point of the cloud, NaN for invalid points
+    * \param stddev_mult the standard deviation multiplier
+    * \param negative set to true to return the outliers instead of the inliers
+    * \param indices the indices of the points to test, all the points if null
+    * \param output the indices of the inliers (or outliers)
+    */
+  void
+  selectStatisticalInliers (const std::vector<float> &mean_distances, double stddev_mult, bool negative,
+                            const std::shared_ptr<std::vector<int> > &indices, std::vector<int> &output);
+
+  /** \brief Radius outlier removal on an organized cloud, with the neighbors of OrganizedNeighborhood. Same criterion
+    * as pcl::RadiusOutlierRemoval: a point is an inlier if it has at least \a min_neighbors neighbors within
+    * \a radius.
+    * \param neighborhood the loaded neighborhood
+    * \param half_window the half size of the window
+    * \param radius the search radius
+    * \param min_neighbors the minimum number of neighbors of an inlier
+    * \param indices the indices of the points to test, all the points if null
+    * \param output the indices of the inliers
+    */
+  void
+  organizedRadiusOutlierRemoval (const OrganizedNeighborhood &neighborhood, int half_window,
+                                 double radius, int min_neighbors,
+                                 const std::shared_ptr<std::vector<int> > &indices, std::vector<int> &output);
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FILTERS__ORGANIZED_NEIGHBORHOOD_HPP_
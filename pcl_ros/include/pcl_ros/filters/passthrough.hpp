@@ -66,15 +66,33 @@ namespace pcl_ros
       filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
               PointCloud2 &output) override
       {
-        //std::scoped_lock lock (Filter::mutex_);
         pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
         pcl_conversions::toPCL (*(input), *(pcl_input));
-        impl_.setInputCloud (pcl_input);
-        impl_.setIndices (indices);
+        auto impl = impl_pool_.acquire();
+        impl->setInputCloud (pcl_input);
+        impl->setIndices (indices);
         pcl::PCLPointCloud2 pcl_output;
-        impl_.filter (pcl_output);
+        impl->filter (pcl_output);
         pcl_conversions::moveFromPCL(pcl_output, output);
       }
+
+      /** \brief Select the points that pass the filter, without building the filtered dataset.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the indices of the points of \a input that pass the filter
+        */
+      bool
+      filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                     std::vector<int> &output) override
+      {
+        pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+        pcl_conversions::toPCL (*(input), *(pcl_input));
+        auto impl = impl_pool_.acquire();
+        impl->setInputCloud (pcl_input);
+        impl->setIndices (indices);
+        impl->filter (output);
+        return (true);
+      }
       
       /** \brief Parameter callback
         * \param params parameter values to set
@@ -87,6 +105,7 @@ namespace pcl_ros
       pcl::PassThrough<pcl::PCLPointCloud2> impl_;
     
       std::mutex mutex_;
+      ImplPool<pcl::PassThrough<pcl::PCLPointCloud2>> impl_pool_{impl_, mutex_, num_workers_};
       
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -47,6 +47,13 @@ namespace pcl_ros
 {
   /** \brief @b RadiusOutlierRemoval is a simple filter that removes outliers if the number of neighbors in a certain
     * search radius is smaller than a given K.
+    *
+    * With \a use_organized, organized clouds (height > 1) are filtered without a kd-tree: only the points of the
+    * (2 * \a organized_window + 1) square pixel window around a point are tested against the radius. Other clouds
+    * can be filtered in linear time by counting the points of the voxels around each point, with \a approximate (see
+    * voxelRadiusOutlierRemoval), or with \a use_search_cache and no input indices, searched with a kd-tree shared with
+    * the other nodes of the process.
+    *
     * \note setFilterFieldName (), setFilterLimits (), and setFilterLimitNegative () are ignored.
     * \author Radu Bogdan Rusu
     */
@@ -63,16 +70,16 @@ namespace pcl_ros
         */
       void
       filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
-              PointCloud2 &output) override
-      {
-        pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
-        pcl_conversions::toPCL (*(input), *(pcl_input));
-        impl_.setInputCloud (pcl_input);
-        impl_.setIndices (indices);
-        pcl::PCLPointCloud2 pcl_output;
-        impl_.filter (pcl_output);
-        pcl_conversions::moveFromPCL(pcl_output, output);
-      }
+              PointCloud2 &output) override;
+
+      /** \brief Select the points that pass the filter, without building the filtered dataset.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the indices of the points of \a input that pass the filter
+        */
+      bool
+      filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                     std::vector<int> &output) override;
 
       /** \brief Parameter callback
         * \param params parameter values to set
@@ -81,8 +88,24 @@ namespace pcl_ros
       config_callback (const std::vector<rclcpp::Parameter> & params);
     
     private:
+      /** \brief Filter an organized cloud with image-space neighborhoods (see OrganizedNeighborhood).
+        * \return false if \a use_organized_ is not set or \a input is not organized
+        */
+      bool
+      filterOrganized (const PointCloud2 &input, const IndicesPtr &indices, std::vector<int> &output);
+
       /** \brief The PCL filter implementation used. */
       pcl::RadiusOutlierRemoval<pcl::PCLPointCloud2> impl_;
+      ImplPool<pcl::RadiusOutlierRemoval<pcl::PCLPointCloud2>> impl_pool_{impl_, mutex_, num_workers_};
+
+      /** \brief Set to true to use image-space neighborhoods instead of a kd-tree for organized clouds. */
+      bool use_organized_ = false;
+      /** \brief Half size of the pixel window searched for neighbors in organized clouds. */
+      int organized_window_ = 3;
+      /** \brief Set to true to count neighbors approximately in voxels of the search radius. */
+      bool approximate_ = false;
+      /** \brief Relative to min_neighbors, the voxel neighborhood size under which neighbors are counted exactly. */
+      double refine_ratio_ = 2.0;
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
@@ -42,7 +42,6 @@
 #include <pcl/filters/statistical_outlier_removal.h>
 #include "pcl_ros/filters/filter.hpp"
 #include "pcl_ros/ptr_helper.hpp"
-#include <mutex>
 
 namespace pcl_ros
 {
@@ -54,41 +53,64 @@ namespace pcl_ros
     *      Robotics and Autonomous Systems Journal (Special Issue on Semantic Knowledge), 2008.
     * </ul>
     *
+    * With \a use_organized, organized clouds (height > 1) are filtered without a kd-tree: the \a mean_k nearest
+    * neighbors of a point are searched in the smallest square pixel window holding \a mean_k pixels (see
+    * OrganizedNeighborhood).
+    * With \a use_search_cache, other clouds without input indices are searched with a kd-tree shared with the other
+    * nodes of the process.
+    *
     * \note setFilterFieldName (), setFilterLimits (), and setFilterLimitNegative () are ignored.
     * \author Radu Bogdan Rusu
     */
   class StatisticalOutlierRemoval : public Filter
   {
     public:
-      StatisticalOutlierRemoval(const rclcpp::NodeOptions& options) : Filter("StatisticalOutlierRemoval", options) {};
-    
-    protected:
-      std::mutex mutex_;
+      StatisticalOutlierRemoval(const rclcpp::NodeOptions& options);
 
-      /** \brief Call the actual filter. 
+    protected:
+      /** \brief Call the actual filter.
         * \param input the input point cloud dataset
         * \param indices the input set of indices to use from \a input
         * \param output the resultant filtered dataset
         */
-    
-      inline void
-      filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices, 
-              PointCloud2 &output)
-      {
-        std::lock_guard<std::mutex> lock (mutex_);
-        pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
-        pcl_conversions::toPCL(*(input), *(pcl_input));
-        impl_.setInputCloud (pcl_input);
-        impl_.setIndices (indices);
-        pcl::PCLPointCloud2 pcl_output;
-        impl_.filter (pcl_output);
-        pcl_conversions::moveFromPCL(pcl_output, output);
-      }
+      void
+      filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+              PointCloud2 &output) override;
 
+      /** \brief Select the points that pass the filter, without building the filtered dataset.
+        * \param input the input point cloud dataset
+        * \param indices the input set of indices to use from \a input
+        * \param output the indices of the points of \a input that pass the filter
+        */
+      bool
+      filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                     std::vector<int> &output) override;
+
+      /** \brief Parameter callback
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      config_callback (const std::vector<rclcpp::Parameter> & params);
 
     private:
+      /** \brief Filter an organized cloud with image-space neighborhoods (see OrganizedNeighborhood).
+        * \return false if \a use_organized_ is not set or \a input is not organized
+        */
+      bool
+      filterOrganized (const PointCloud2 &input, const IndicesPtr &indices, std::vector<int> &output);
+
+      /** \brief Filter with the kd-tree of \a input from SearchCache, shared with the other nodes of the process.
+        * \return false if \a use_search_cache_ is not set, \a indices is set or \a input has no x, y and z fields
+        */
+      bool
+      filterSearchCache (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices, std::vector<int> &output);
+
       /** \brief The PCL filter implementation used. */
       pcl::StatisticalOutlierRemoval<pcl::PCLPointCloud2> impl_;
+      ImplPool<pcl::StatisticalOutlierRemoval<pcl::PCLPointCloud2>> impl_pool_{impl_, mutex_, num_workers_};
+
+      /** \brief Set to true to use image-space neighborhoods instead of a kd-tree for organized clouds. */
+      bool use_organized_ = false;
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
   };
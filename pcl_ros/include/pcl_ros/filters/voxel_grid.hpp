@@ -41,6 +41,7 @@
 // PCL includes
 #include <pcl/filters/voxel_grid.h>
 #include "pcl_ros/filters/filter.hpp"
+#include "pcl_ros/filters/voxel_hash.hpp"
 
 namespace pcl_ros
 {
@@ -56,6 +57,21 @@ namespace pcl_ros
     protected:
       /** \brief The PCL filter implementation used. */
       pcl::VoxelGrid<pcl::PCLPointCloud2> impl_;
+      ImplPool<pcl::VoxelGrid<pcl::PCLPointCloud2>> impl_pool_{impl_, mutex_, num_workers_};
+
+      /** \brief The hash-based engine, used instead of \a impl_ when \a use_hash_ is set. */
+      VoxelHashGrid hash_impl_;
+
+      /** \brief Set to true to downsample with \a hash_impl_ ("method" parameter set to "hash"). The "nearest" and
+        * "first" output modes always use \a hash_impl_.
+        */
+      bool use_hash_ = false;
+
+      /** \brief The leaf size on all the axes. */
+      double leaf_size_ = 0.01;
+
+      /** \brief The leaf size on each axis, overriding \a leaf_size_ if set (0 if not). */
+      double leaf_size_xyz_[3] = {0.0, 0.0, 0.0};
 
       /** \brief Call the actual filter. 
         * \param input the input point cloud dataset
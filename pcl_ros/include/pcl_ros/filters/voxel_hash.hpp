@@ -0,0 +1,346 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FILTERS__VOXEL_HASH_HPP_
+#define PCL_ROS__FILTERS__VOXEL_HASH_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+namespace pcl_ros
+{
+  /** \brief @b VoxelKey holds the integer coordinates of a voxel, floor (p / leaf_size) on each axis. */
+  struct VoxelKey
+  {
+    int32_t x, y, z;
+
+    inline bool
+    operator== (const VoxelKey &other) const
+    {
+      return (x == other.x && y == other.y && z == other.z);
+    }
+
+    /** \brief Mix the three coordinates into 64 bits. The low bits are used for the table slot and the high bits for
+      * partitioning, both stay well distributed for neighbouring voxels.
+      */
+    inline uint64_t
+    hash () const
+    {
+      uint64_t h = (static_cast<uint64_t> (static_cast<uint32_t> (x)) * 0x9E3779B97F4A7C15ull) ^
+                   (static_cast<uint64_t> (static_cast<uint32_t> (y)) * 0xC2B2AE3D27D4EB4Full) ^
+                   (static_cast<uint64_t> (static_cast<uint32_t> (z)) * 0x165667B19E3779F9ull);
+      h ^= h >> 29;
+      h *= 0xBF58476D1CE4E5B9ull;
+      h ^= h >> 32;
+      return (h);
+    }
+  };
+
+  /** \brief Hash functor for using VoxelKey in standard containers. */
+  struct VoxelKeyHash
+  {
+    inline size_t
+    operator() (const VoxelKey &key) const
+    {
+      return (static_cast<size_t> (key.hash ()));
+    }
+  };
+
+  /** \brief Compute the key of the voxel containing a point.
+    * \param x the point x coordinate
+    * \param y the point y coordinate
+    * \param z the point z coordinate
+    * \param inverse_leaf_size the inverse of the leaf size on each axis
+    * \param key the resultant key
+    * \return false if the point is not finite or too far away to be represented, true otherwise
+    */
+  inline bool
+  computeVoxelKey (float x, float y, float z, const float inverse_leaf_size[3], VoxelKey &key)
+  {
+    // Also rejects NaN
+    const double limit = static_cast<double> (std::numeric_limits<int32_t>::max ());
+    const double vx = std::floor (static_cast<double> (x) * inverse_leaf_size[0]);
+    const double vy = std::floor (static_cast<double> (y) * inverse_leaf_size[1]);
+    const double vz = std::floor (static_cast<double> (z) * inverse_leaf_size[2]);
+    if (!(std::abs (vx) < limit && std::abs (vy) < limit && std::abs (vz) < limit))
+      return (false);
+    key.x = static_cast<int32_t> (vx);
+    key.y = static_cast<int32_t> (vy);
+    key.z = static_cast<int32_t> (vz);
+    return (true);
+  }
+
+  /** \brief @b VoxelHashMap maps voxel keys to dense ids (0, 1, 2... in insertion order), with open addressing and
+    * linear probing. Unlike a voxel index computed from the bounding box of the data, the keys never overflow as long as
+    * each coordinate fits on 32 bits, whatever the extent of the data and the leaf size.
+    */
+  class VoxelHashMap
+  {
+    public:
+      static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max ();
+
+      /** \brief Constructor.
+        * \param expected_size the number of voxels expected, to size the table
+        */
+      explicit VoxelHashMap (size_t expected_size = 16)
+      {
+        size_t capacity = 16;
+        while (capacity < 2 * expected_size)
+          capacity *= 2;
+        entries_.assign (capacity, Entry ());
+        mask_ = capacity - 1;
+      }
+
+      /** \brief Get the id of a voxel, inserting it with the next id if not present.
+        * \param key the voxel key
+        * \param inserted set to true if the voxel was not present
+        */
+      inline uint32_t
+      insert (const VoxelKey &key, bool &inserted)
+      {
+        return (insert (key, key.hash (), inserted));
+      }
+
+      /** \brief Same as insert (key, inserted), with the hash of the key already computed. */
+      uint32_t
+      insert (const VoxelKey &key, uint64_t hash, bool &inserted)
+      {
+        // Keep the load factor under 1/2
+        if (2 * (size_ + 1) > entries_.size ())
+          grow ();
+
+        size_t slot = hash & mask_;
+        while (entries_[slot].id != npos)
+        {
+          if (entries_[slot].key == key)
+          {
+            inserted = false;
+            return (entries_[slot].id);
+          }
+          slot = (slot + 1) & mask_;
+        }
+        entries_[slot].key = key;
+        entries_[slot].id = static_cast<uint32_t> (size_);
+        inserted = true;
+        return (static_cast<uint32_t> (size_++));
+      }
+
+      /** \brief Get the id of a voxel, or npos if not present. */
+      inline uint32_t
+      find (const VoxelKey &key) const
+      {
+        return (find (key, key.hash ()));
+      }
+
+      /** \brief Same as find (key), with the hash of the key already computed. */
+      uint32_t
+      find (const VoxelKey &key, uint64_t hash) const
+      {
+        size_t slot = hash & mask_;
+        while (entries_[slot].id != npos)
+        {
+          if (entries_[slot].key == key)
+            return (entries_[slot].id);
+          slot = (slot + 1) & mask_;
+        }
+        return (npos);
+      }
+
+      /** \brief Get the number of voxels. */
+      inline size_t
+      size () const
+      {
+        return (size_);
+      }
+
+      /** \brief Remove all the voxels, keeping the capacity. */
+      inline void
+      clear ()
+      {
+        std::fill (entries_.begin (), entries_.end (), Entry ());
+        size_ = 0;
+      }
+
+    private:
+      struct Entry
+      {
+        VoxelKey key = {0, 0, 0};
+        uint32_t id = npos;
+      };
+
+      void
+      grow ()
+      {
+        std::vector<Entry> entries (entries_.size () * 2);
+        const size_t mask = entries.size () - 1;
+        for (const Entry &entry : entries_)
+        {
+          if (entry.id == npos)
+            continue;
+          size_t slot = entry.key.hash () & mask;
+          while (entries[slot].id != npos)
+            slot = (slot + 1) & mask;
+          entries[slot] = entry;
+        }
+        entries_.swap (entries);
+        mask_ = mask;
+      }
+
+      std::vector<Entry> entries_;
+      size_t mask_ = 0;
+      size_t size_ = 0;
+  };
+
+  /** \brief @b VoxelHashGrid downsamples a PointCloud2 into one point per voxel, working directly on the message
+    * buffer. Points are hashed by voxel key rather than sorted by voxel index, which makes the cost linear in the
+    * number of points and removes any limit on the number of voxels spanned by the data.
+    *
+    * The points are split in contiguous chunks processed by different threads. Each thread accumulates its chunk into
+    * one partial table per partition of the key hashes; each partition is then merged by a single thread, so no
+    * locking is needed.
+    *
+    * The point of each voxel is either:
+    *  - CENTROID: floating point fields are averaged, packed "rgb"/"rgba" fields are averaged per channel, and the
+    *    other fields are taken from the first point of the voxel;
+    *  - NEAREST: the input point nearest to the centroid of the voxel, unchanged;
+    *  - FIRST: the first input point of the voxel, unchanged.
+    * NEAREST and FIRST only accumulate x, y and z (or nothing), and keep the exact attributes of a sensor point.
+    */
+  class VoxelHashGrid
+  {
+    public:
+      enum Representative
+      {
+        CENTROID,
+        NEAREST,
+        FIRST
+      };
+
+      /** \brief Set the size of the voxels on each axis. */
+      inline void
+      setLeafSize (float lx, float ly, float lz)
+      {
+        leaf_size_[0] = lx;
+        leaf_size_[1] = ly;
+        leaf_size_[2] = lz;
+      }
+
+      /** \brief Get the size of the voxels on x. */
+      inline float getLeafSizeX () const { return (leaf_size_[0]); }
+      inline float getLeafSizeY () const { return (leaf_size_[1]); }
+      inline float getLeafSizeZ () const { return (leaf_size_[2]); }
+
+      /** \brief Set the maximum number of threads, 0 for the number of cores. */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        nr_threads_ = nr_threads;
+      }
+
+      inline unsigned int getNumberOfThreads () const { return (nr_threads_); }
+
+      /** \brief Set how the point of each voxel is computed. */
+      inline void
+      setRepresentative (Representative representative)
+      {
+        representative_ = representative;
+      }
+
+      inline Representative getRepresentative () const { return (representative_); }
+
+      /** \brief Set the minimum number of points for a voxel to be output. */
+      inline void
+      setMinimumPointsNumberPerVoxel (unsigned int min_points_per_voxel)
+      {
+        min_points_per_voxel_ = min_points_per_voxel;
+      }
+
+      inline unsigned int getMinimumPointsNumberPerVoxel () const { return (min_points_per_voxel_); }
+
+      /** \brief Set to false to only output the x, y and z fields, true (default) to output all the fields. */
+      inline void
+      setDownsampleAllData (bool downsample)
+      {
+        downsample_all_data_ = downsample;
+      }
+
+      inline bool getDownsampleAllData () const { return (downsample_all_data_); }
+
+      /** \brief Downsample a cloud.
+        * \param input the input cloud
+        * \param indices the indices of the points to use, all the points if null
+        * \param output the resultant cloud, with the same fields as \a input, or only x, y and z
+        * \return false if \a input has no FLOAT32 x, y and z fields, is big endian, or the leaf size is not positive
+        */
+      bool
+      filter (const sensor_msgs::msg::PointCloud2 &input, const std::shared_ptr<const std::vector<int> > &indices,
+              sensor_msgs::msg::PointCloud2 &output) const;
+
+    private:
+      float leaf_size_[3] = {0.01f, 0.01f, 0.01f};
+      unsigned int nr_threads_ = 0;
+      Representative representative_ = CENTROID;
+      unsigned int min_points_per_voxel_ = 0;
+      bool downsample_all_data_ = true;
+  };
+
+  /** \brief Approximate radius outlier removal in linear time. The points are hashed into voxels of size \a radius, so
+    * all the neighbors of a point within \a radius lie in the 27 voxels around its own: their number of points is an
+    * upper bound of its number of neighbors.
+    *  - if the bound is below \a min_neighbors, the point is an outlier (exact);
+    *  - if the bound is at least \a refine_ratio * \a min_neighbors, the point is taken as an inlier (approximate);
+    *  - otherwise the neighbors are counted exactly in the 27 voxels.
+    * With \a refine_ratio <= 1 no point is refined; the larger \a refine_ratio, the closer to
+    * pcl::RadiusOutlierRemoval (at least \a min_neighbors neighbors within \a radius, the point itself excluded).
+    * \param input the input cloud
+    * \param indices the indices of the points to test, all the points if null. Only these points count as neighbors.
+    * \param radius the search radius
+    * \param min_neighbors the minimum number of neighbors of an inlier
+    * \param refine_ratio the bound, relative to \a min_neighbors, under which neighbors are counted exactly
+    * \param output the indices of the inliers
+    * \return false if \a input has no FLOAT32 x, y and z fields, is big endian, or \a radius is not positive
+    */
+  bool
+  voxelRadiusOutlierRemoval (const sensor_msgs::msg::PointCloud2 &input,
+                             const std::shared_ptr<const std::vector<int> > &indices, double radius,
+                             int min_neighbors, double refine_ratio, std::vector<int> &output);
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FILTERS__VOXEL_HASH_HPP_
@@ -0,0 +1,127 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__FILTERS__VOXEL_MAP_HPP_
+#define PCL_ROS__FILTERS__VOXEL_MAP_HPP_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "pcl_ros/pcl_node.hpp"
+#include "pcl_ros/filters/voxel_hash.hpp"
+
+namespace pcl_ros
+{
+  /** \brief @b VoxelMap maintains a persistent, downsampled map of the incoming scans. Each scan is transformed into
+    * the map frame and inserted point by point into a voxel hash map, so the cost of a scan is proportional to its
+    * number of points and not to the size of the map. Each voxel keeps the running centroid of its points.
+    *
+    * Voxels further than \a max_radius from the origin of the latest scan, or not updated for \a max_age seconds, are
+    * evicted before the map is published, at \a publish_rate. The map only holds x, y and z.
+    */
+  class VoxelMap : public PCLNode
+  {
+    public:
+      VoxelMap (const rclcpp::NodeOptions& options);
+
+    protected:
+      /** \brief Insert a scan into the map.
+        * \param cloud the input scan, in any frame transformable into the map frame
+        */
+      void
+      input_callback (const PointCloud2::ConstSharedPtr &cloud);
+
+      /** \brief Evict the voxels out of the window and publish the map. */
+      void
+      publish_callback ();
+
+      /** \brief Parameter callback
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      config_callback (const std::vector<rclcpp::Parameter> & params);
+
+      /** \brief The input PointCloud2 subscriber. */
+      rclcpp::Subscription<PointCloud2>::SharedPtr sub_input_;
+
+      /** \brief The map publication timer. */
+      rclcpp::TimerBase::SharedPtr publish_timer_;
+
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr callback_handle_;
+
+    private:
+      /** \brief A map voxel. */
+      struct Voxel
+      {
+        double sum[3] = {0.0, 0.0, 0.0};
+        uint32_t count = 0;
+        /** \brief Stamp of the latest scan that hit the voxel, in nanoseconds. */
+        int64_t stamp = 0;
+      };
+
+      /** \brief Internal mutex, protecting the map and the parameters. */
+      std::mutex mutex_;
+
+      /** \brief The voxels, indexed by their key. */
+      std::unordered_map<VoxelKey, Voxel, VoxelKeyHash> voxels_;
+
+      /** \brief Origin of the latest scan in the map frame, and its stamp. */
+      Eigen::Vector3f origin_ = Eigen::Vector3f::Zero ();
+      rclcpp::Time latest_stamp_;
+
+      /** \brief The frame of the map. Read only. */
+      std::string map_frame_;
+
+      /** \brief The voxel size. Read only, as changing it would invalidate the map. */
+      double leaf_size_ = 0.1;
+
+      /** \brief Voxels further than this from the latest scan origin are evicted, 0 to disable. */
+      double max_radius_ = 50.0;
+
+      /** \brief Voxels not hit for this long (in seconds, scan time) are evicted, 0 to disable. */
+      double max_age_ = 0.0;
+
+      /** \brief Maximum number of points accumulated per voxel, after which the centroid is frozen. */
+      int max_points_per_voxel_ = 100;
+
+      /** \brief How long to wait for the transform of a scan to the map frame, in seconds. */
+      double transform_timeout_ = 0.1;
+
+    public:
+      EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__FILTERS__VOXEL_MAP_HPP_
@@ -0,0 +1,307 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__IMPL_POOL_HPP_
+#define PCL_ROS__IMPL_POOL_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace pcl_ros
+{
+  /** \brief @b ImplPool keeps a small set of copies of a configured PCL implementation object, so that several frames
+    * can be processed at the same time.
+    *
+    * The node keeps configuring its usual \a impl_ object (the prototype) from the parameter callback, while holding
+    * the prototype mutex, and calls invalidate () afterwards. Every copy is refreshed from the prototype the next time
+    * it is acquired. The prototype itself must never be used for processing: it is copied as is, and the copies must
+    * not share any search structure built during processing.
+    */
+  template <typename ImplT>
+  class ImplPool
+  {
+    struct Slot
+    {
+      std::unique_ptr<ImplT> impl;
+      uint64_t generation = 0;
+      bool busy = false;
+    };
+
+    public:
+      /** \brief @b Lease gives exclusive access to one of the copies, and returns it to the pool on destruction. */
+      class Lease
+      {
+        public:
+          Lease (ImplPool *pool, Slot *slot) : pool_ (pool), slot_ (slot) {}
+          Lease (Lease &&other) : pool_ (other.pool_), slot_ (other.slot_) { other.slot_ = nullptr; }
+          Lease (const Lease &) = delete;
+          Lease &operator= (const Lease &) = delete;
+          ~Lease () { if (slot_) pool_->release (slot_); }
+
+          inline ImplT* operator-> () const { return (slot_->impl.get ()); }
+          inline ImplT& operator* () const { return (*slot_->impl); }
+
+        private:
+          ImplPool *pool_;
+          Slot *slot_;
+      };
+
+      /** \brief Constructor.
+        * \param prototype the configured implementation object the copies are made from
+        * \param prototype_mutex the mutex held while \a prototype is modified
+        * \param size the number of copies
+        */
+      ImplPool (const ImplT &prototype, std::mutex &prototype_mutex, int size = 1) :
+        prototype_ (prototype), prototype_mutex_ (prototype_mutex)
+      {
+        resize (size);
+      }
+
+      /** \brief Set the number of copies, i.e. the maximum number of frames processed at the same time.
+        * Must not be called while a lease is held.
+        */
+      void
+      resize (int size)
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        slots_.resize (size < 1 ? 1 : size);
+        for (Slot &slot : slots_)
+        {
+          if (!slot.impl)
+          {
+            slot.impl.reset (new ImplT);
+            slot.generation = 0;
+          }
+        }
+        // Force a copy of the prototype on the next acquire ()
+        ++generation_;
+      }
+
+      inline size_t size () const { return (slots_.size ()); }
+
+      /** \brief Notify the pool that the prototype changed. Call while holding the prototype mutex. */
+      inline void
+      invalidate ()
+      {
+        ++generation_;
+      }
+
+      /** \brief Get an up to date copy of the prototype, waiting for one to be available if needed. */
+      Lease
+      acquire ()
+      {
+        Slot *slot = nullptr;
+        {
+          std::unique_lock<std::mutex> lock (mutex_);
+          available_.wait (lock, [this, &slot]
+          {
+            for (Slot &s : slots_)
+            {
+              if (!s.busy)
+              {
+                slot = &s;
+                return (true);
+              }
+            }
+            return (false);
+          });
+          slot->busy = true;
+        }
+
+        std::lock_guard<std::mutex> prototype_lock (prototype_mutex_);
+        if (slot->generation != generation_)
+        {
+          *slot->impl = prototype_;
+          slot->generation = generation_;
+        }
+        return (Lease (this, slot));
+      }
+
+    private:
+      void
+      release (Slot *slot)
+      {
+        {
+          std::lock_guard<std::mutex> lock (mutex_);
+          slot->busy = false;
+        }
+        available_.notify_one ();
+      }
+
+      const ImplT &prototype_;
+      std::mutex &prototype_mutex_;
+
+      /** \brief Incremented on every prototype change, protected by the prototype mutex. */
+      uint64_t generation_ = 0;
+
+      std::mutex mutex_;
+      std::condition_variable available_;
+      std::vector<Slot> slots_;
+  };
+
+  /** \brief @b AdmissionGate bounds the number of frames processed at the same time. The executor may run more
+    * callbacks of a reentrant group than there are copies in the ImplPool; the frames above the limit are turned
+    * away at once instead of holding an executor thread while they wait for a copy. These frames are lost, whereas
+    * a node with a single worker leaves them in its input queue until it is done with the current frame.
+    */
+  class AdmissionGate
+  {
+    public:
+      /** \brief @b Pass holds one of the places of the gate, and gives it back on destruction. */
+      class Pass
+      {
+        public:
+          explicit Pass (AdmissionGate *gate) : gate_ (gate && gate->enter () ? gate : nullptr), admitted_ (!gate || gate_) {}
+          Pass (const Pass &) = delete;
+          Pass &operator= (const Pass &) = delete;
+          ~Pass () { if (gate_) gate_->leave (); }
+
+          /** \brief False if the gate was full. Always true for a pass created without a gate. */
+          inline explicit operator bool () const { return (admitted_); }
+
+        private:
+          AdmissionGate *gate_;
+          bool admitted_;
+      };
+
+      /** \brief Constructor.
+        * \param capacity the maximum number of passes held at the same time
+        */
+      explicit AdmissionGate (int capacity) : capacity_ (capacity < 1 ? 1 : capacity) {}
+
+    private:
+      inline bool
+      enter ()
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        if (inside_ >= capacity_)
+          return (false);
+        ++inside_;
+        return (true);
+      }
+
+      inline void
+      leave ()
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        --inside_;
+      }
+
+      std::mutex mutex_;
+      int capacity_;
+      int inside_ = 0;
+  };
+
+  /** \brief @b FrameSequencer hands out tickets in the order the frames are received, and makes the frames finish
+    * (publish) in that same order even when they are processed concurrently.
+    */
+  class FrameSequencer
+  {
+    public:
+      /** \brief @b Ticket is the place of a frame in the sequence. A ticket that is destroyed without being finished
+        * still waits for its turn, so that dropped frames do not stall the frames received after them. All the
+        * methods are no-ops for a ticket created without a sequencer.
+        */
+      class Ticket
+      {
+        public:
+          explicit Ticket (FrameSequencer *sequencer) : sequencer_ (sequencer)
+          {
+            if (sequencer_)
+              number_ = sequencer_->take ();
+          }
+          Ticket (const Ticket &) = delete;
+          Ticket &operator= (const Ticket &) = delete;
+          ~Ticket () { finish (); }
+
+          /** \brief Block until all the frames received earlier are finished. */
+          inline void
+          waitTurn ()
+          {
+            if (sequencer_)
+              sequencer_->waitTurn (number_);
+          }
+
+          /** \brief Let the next frame go. Waits for this frame's turn first. */
+          inline void
+          finish ()
+          {
+            if (!sequencer_)
+              return;
+            sequencer_->waitTurn (number_);
+            sequencer_->finish (number_);
+            sequencer_ = nullptr;
+          }
+
+        private:
+          FrameSequencer *sequencer_;
+          uint64_t number_ = 0;
+      };
+
+    private:
+      inline uint64_t
+      take ()
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return (next_ticket_++);
+      }
+
+      inline void
+      waitTurn (uint64_t number)
+      {
+        std::unique_lock<std::mutex> lock (mutex_);
+        turn_.wait (lock, [this, number] { return (next_finished_ == number); });
+      }
+
+      inline void
+      finish (uint64_t number)
+      {
+        {
+          std::lock_guard<std::mutex> lock (mutex_);
+          next_finished_ = number + 1;
+        }
+        turn_.notify_all ();
+      }
+
+      std::mutex mutex_;
+      std::condition_variable turn_;
+      uint64_t next_ticket_ = 0;
+      uint64_t next_finished_ = 0;
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__IMPL_POOL_HPP_
@@ -0,0 +1,67 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__INDICES_HELPER_HPP_
+#define PCL_ROS__INDICES_HELPER_HPP_
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <pcl_msgs/msg/point_indices.hpp>
+
+namespace pcl_ros
+{
+  static_assert (std::is_same<pcl_msgs::msg::PointIndices::_indices_type, std::vector<int> >::value,
+                 "PointIndices::indices must be a std::vector<int> to be handed to PCL without a copy");
+
+  /** \brief Get the indices of a PointIndices message as the IndicesPtr PCL expects, without copying them.
+    *
+    * The returned pointer shares the ownership of \a msg, which stays alive as long as the indices are in use. PCL
+    * never modifies the indices it is given, the const_cast is only needed because its setIndices () takes a pointer
+    * to mutable data.
+    * \param msg the received message, may be null
+    * \return a pointer to \a msg->indices, or null if \a msg is null
+    */
+  inline std::shared_ptr<std::vector<int> >
+  indicesFromMsg (const pcl_msgs::msg::PointIndices::ConstSharedPtr &msg)
+  {
+    if (!msg)
+      return (std::shared_ptr<std::vector<int> > ());
+    std::shared_ptr<pcl_msgs::msg::PointIndices> owner = std::const_pointer_cast<pcl_msgs::msg::PointIndices> (msg);
+    return (std::shared_ptr<std::vector<int> > (owner, &owner->indices));
+  }
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__INDICES_HELPER_HPP_
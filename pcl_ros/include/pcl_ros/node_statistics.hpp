@@ -0,0 +1,279 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__NODE_STATISTICS_HPP_
+#define PCL_ROS__NODE_STATISTICS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <diagnostic_msgs/msg/diagnostic_status.hpp>
+
+namespace pcl_ros
+{
+  /** \brief @b Histogram accumulates samples in exponentially growing buckets. Bucket \a i holds the samples in
+    * (min * 2^(i-1); min * 2^i], the first bucket everything below \a min and the last bucket everything above.
+    */
+  class Histogram
+  {
+    public:
+      /** \brief Constructor.
+        * \param min the upper bound of the first bucket
+        * \param nr_buckets the number of buckets
+        */
+      Histogram (double min, size_t nr_buckets) : min_ (min), buckets_ (nr_buckets, 0) {}
+
+      /** \brief Add a sample. */
+      inline void
+      add (double value)
+      {
+        size_t bucket = 0;
+        if (value > min_)
+          bucket = std::min (static_cast<size_t> (std::ceil (std::log2 (value / min_))), buckets_.size () - 1);
+        ++buckets_[bucket];
+        ++count_;
+        sum_ += value;
+        max_ = std::max (max_, value);
+      }
+
+      /** \brief Approximate the q-quantile (q in [0;1]) with the upper bound of the bucket it falls in. */
+      double
+      quantile (double q) const
+      {
+        if (count_ == 0)
+          return (0.0);
+        const double rank = q * count_;
+        size_t cumulative = 0;
+        for (size_t i = 0; i < buckets_.size (); ++i)
+        {
+          cumulative += buckets_[i];
+          if (cumulative >= rank)
+            return (std::min (min_ * std::pow (2.0, static_cast<double> (i)), max_));
+        }
+        return (max_);
+      }
+
+      inline size_t count () const { return (count_); }
+      inline double mean () const { return (count_ == 0 ? 0.0 : sum_ / count_); }
+      inline double max () const { return (max_); }
+
+      /** \brief Remove all the samples. */
+      inline void
+      reset ()
+      {
+        std::fill (buckets_.begin (), buckets_.end (), 0);
+        count_ = 0;
+        sum_ = max_ = 0.0;
+      }
+
+    private:
+      double min_;
+      std::vector<size_t> buckets_;
+      size_t count_ = 0;
+      double sum_ = 0.0;
+      double max_ = 0.0;
+  };
+
+  /** \brief @b NodeStatistics collects per-frame timings and point counts of a node over a rolling window. The
+    * window is closed (and the histograms cleared) every time the statistics are reported.
+    */
+  class NodeStatistics
+  {
+    public:
+      typedef std::chrono::steady_clock Clock;
+
+      /** \brief @b Frame records a single frame, from the moment it was received to the moment it was published.
+        * All the methods are no-ops if the frame was created without statistics, so that the cost of the disabled
+        * instrumentation is a pointer test.
+        */
+      class Frame
+      {
+        public:
+          explicit Frame (NodeStatistics *statistics) : statistics_ (statistics)
+          {
+            if (statistics_)
+              received_ = Clock::now ();
+          }
+
+          ~Frame ()
+          {
+            if (statistics_ && published_)
+              statistics_->record (*this);
+          }
+
+          Frame (const Frame &) = delete;
+          Frame &operator= (const Frame &) = delete;
+
+          /** \brief Mark the beginning of the computation. */
+          inline void
+          startCompute (size_t input_points)
+          {
+            if (!statistics_)
+              return;
+            input_points_ = input_points;
+            compute_start_ = Clock::now ();
+          }
+
+          /** \brief Mark the end of the computation. */
+          inline void
+          endCompute (size_t output_points)
+          {
+            if (!statistics_)
+              return;
+            output_points_ = output_points;
+            compute_end_ = Clock::now ();
+          }
+
+          /** \brief Mark the frame as published. The frame is recorded when it goes out of scope. */
+          inline void
+          published ()
+          {
+            if (!statistics_)
+              return;
+            published_ = true;
+            published_time_ = Clock::now ();
+          }
+
+          /** \brief Mark the frame as dropped.
+            * \param reason a short identifier of the reason the frame was not published (e.g. "invalid_input")
+            */
+          inline void
+          dropped (const std::string &reason)
+          {
+            if (statistics_)
+              statistics_->recordDrop (reason);
+          }
+
+        private:
+          friend class NodeStatistics;
+
+          NodeStatistics *statistics_;
+          bool published_ = false;
+          Clock::time_point received_, compute_start_, compute_end_, published_time_;
+          size_t input_points_ = 0, output_points_ = 0;
+      };
+
+      NodeStatistics () :
+        latency_ (0.01, 24), compute_ (0.01, 24), input_points_ (1.0, 32), output_points_ (1.0, 32),
+        window_start_ (Clock::now ())
+      {}
+
+      /** \brief Record a published frame. */
+      void
+      record (const Frame &frame)
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        latency_.add (std::chrono::duration<double, std::milli> (frame.published_time_ - frame.received_).count ());
+        compute_.add (std::chrono::duration<double, std::milli> (frame.compute_end_ - frame.compute_start_).count ());
+        input_points_.add (static_cast<double> (frame.input_points_));
+        output_points_.add (static_cast<double> (frame.output_points_));
+      }
+
+      /** \brief Count a dropped frame. */
+      void
+      recordDrop (const std::string &reason)
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        ++dropped_[reason];
+      }
+
+      /** \brief Fill a diagnostic status with the statistics of the current window, and start a new window.
+        * Dropped frame counters are cumulative.
+        * \param status the resultant status
+        */
+      void
+      report (diagnostic_msgs::msg::DiagnosticStatus &status)
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        const Clock::time_point now = Clock::now ();
+        const double window = std::chrono::duration<double> (now - window_start_).count ();
+
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+        status.message = "Processed " + std::to_string (latency_.count ()) + " frames";
+        status.values.clear ();
+        addValue (status, "frames", static_cast<double> (latency_.count ()));
+        addValue (status, "frame_rate", window > 0.0 ? latency_.count () / window : 0.0);
+        addHistogram (status, "latency_ms", latency_);
+        addHistogram (status, "compute_ms", compute_);
+        addHistogram (status, "input_points", input_points_);
+        addHistogram (status, "output_points", output_points_);
+        size_t total_dropped = 0;
+        for (const auto &drop : dropped_)
+        {
+          addValue (status, "dropped." + drop.first, static_cast<double> (drop.second));
+          total_dropped += drop.second;
+        }
+        addValue (status, "dropped", static_cast<double> (total_dropped));
+
+        latency_.reset ();
+        compute_.reset ();
+        input_points_.reset ();
+        output_points_.reset ();
+        window_start_ = now;
+      }
+
+    private:
+      static void
+      addValue (diagnostic_msgs::msg::DiagnosticStatus &status, const std::string &key, double value)
+      {
+        diagnostic_msgs::msg::KeyValue kv;
+        kv.key = key;
+        kv.value = std::to_string (value);
+        status.values.push_back (kv);
+      }
+
+      static void
+      addHistogram (diagnostic_msgs::msg::DiagnosticStatus &status, const std::string &key, const Histogram &histogram)
+      {
+        addValue (status, key + ".mean", histogram.mean ());
+        addValue (status, key + ".p50", histogram.quantile (0.5));
+        addValue (status, key + ".p90", histogram.quantile (0.9));
+        addValue (status, key + ".p99", histogram.quantile (0.99));
+        addValue (status, key + ".max", histogram.max ());
+      }
+
+      std::mutex mutex_;
+      Histogram latency_, compute_, input_points_, output_points_;
+      std::map<std::string, size_t> dropped_;
+      Clock::time_point window_start_;
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__NODE_STATISTICS_HPP_
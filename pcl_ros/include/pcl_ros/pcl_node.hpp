@@ -48,6 +48,8 @@
 #include <rcutils/error_handling.h>
 
 #include <sensor_msgs/msg/point_cloud2.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <std_msgs/msg/u_int8.hpp>
 
 // PCL includes
 #include <pcl_msgs/msg/point_indices.hpp>
@@ -55,6 +57,10 @@
 #include <pcl/point_types.h>
 #include <pcl_conversions/pcl_conversions.hpp>
 #include "pcl_ros/point_cloud.hpp"
+#include "pcl_ros/indices_helper.hpp"
+#include "pcl_ros/node_statistics.hpp"
+#include "pcl_ros/quality_controller.hpp"
+#include "pcl_ros/search_cache.hpp"
 // ROS Node includes
 #include <message_filters/subscriber.h>
 #include <message_filters/synchronizer.h>
@@ -135,15 +141,176 @@ namespace pcl_ros
           approximate_sync_ = declare_parameter(desc.name, approximate_sync_, desc);
         }
 
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "num_workers";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+          desc.description = "Maximum number of frames processed at the same time. Values above 1 require a "
+                             "multi-threaded executor; the output is still published in the input order. Unlike with 1 worker, where "
+                             "the frames received while busy wait in the input queue (see queue_policy), the frames received "
+                             "while num_workers frames are being processed are dropped and counted as 'busy' in the statistics.";
+          rcl_interfaces::msg::IntegerRange int_range;
+          int_range.from_value = 1;
+          int_range.to_value = 64;
+          desc.integer_range.push_back(int_range);
+          desc.read_only = true;
+          num_workers_ = declare_parameter(desc.name, num_workers_, desc);
+        }
+
+        std::string queue_policy = "all";
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "queue_policy";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+          desc.description = "What to do with the frames received while the node is busy: 'all' processes every "
+                             "queued frame, 'latest' only keeps the newest one (on every input and synchronizer queue), "
+                             "'max_age' drops the stamped frames older than max_age_ms when they are dequeued. "
+                             "The output topics keep a history of max_queue_size with every policy.";
+          desc.read_only = true;
+          queue_policy = declare_parameter(desc.name, queue_policy, desc);
+        }
+
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "max_age_ms";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+          desc.description = "Maximum age (in milliseconds) of a frame when its processing starts, with the 'max_age' queue policy.";
+          rcl_interfaces::msg::FloatingPointRange float_range;
+          float_range.from_value = 0.0;
+          float_range.to_value = 60000.0;
+          desc.floating_point_range.push_back(float_range);
+          desc.read_only = true;
+          max_age_ms_ = declare_parameter(desc.name, max_age_ms_, desc);
+        }
+
+        if (queue_policy == "all")
+          queue_policy_ = QUEUE_ALL;
+        else if (queue_policy == "latest")
+          queue_policy_ = QUEUE_LATEST;
+        else if (queue_policy == "max_age")
+          queue_policy_ = QUEUE_MAX_AGE;
+        else
+          throw std::runtime_error("Invalid queue_policy '" + queue_policy + "', expected 'all', 'latest' or 'max_age'.");
+
+        double processing_budget_ms = 0.0;
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "processing_budget_ms";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+          desc.description = "Processing time budget of a frame (in milliseconds). Nodes that support it lower their "
+                             "quality when the recent compute time exceeds it, and publish the quality level on "
+                             "~/quality_level. 0 disables the adaptive quality.";
+          rcl_interfaces::msg::FloatingPointRange float_range;
+          float_range.from_value = 0.0;
+          float_range.to_value = 60000.0;
+          desc.floating_point_range.push_back(float_range);
+          desc.read_only = true;
+          processing_budget_ms = declare_parameter(desc.name, processing_budget_ms, desc);
+        }
+
+        int max_quality_level = 3;
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "max_quality_level";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+          desc.description = "Lowest quality level allowed with a processing budget; each level roughly halves the work.";
+          rcl_interfaces::msg::IntegerRange int_range;
+          int_range.from_value = 0;
+          int_range.to_value = 8;
+          desc.integer_range.push_back(int_range);
+          desc.read_only = true;
+          max_quality_level = declare_parameter(desc.name, max_quality_level, desc);
+        }
+
+        if (processing_budget_ms > 0.0)
+        {
+          quality_.reset (new QualityController (processing_budget_ms, max_quality_level));
+          // Late subscribers get the current level
+          pub_quality_level_ = this->create_publisher<std_msgs::msg::UInt8>("~/quality_level", rclcpp::QoS(1).transient_local());
+          std_msgs::msg::UInt8 level;
+          level.data = 0;
+          pub_quality_level_->publish (level);
+        }
+
+        bool publish_statistics = false;
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "publish_statistics";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+          desc.description = "Collect per-frame latency, compute time and point counts, and publish them on ~/statistics.";
+          desc.read_only = true;
+          publish_statistics = declare_parameter(desc.name, publish_statistics, desc);
+        }
+
+        double statistics_period = 1.0;
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "statistics_period";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+          desc.description = "Period (in seconds) at which the statistics are published.";
+          rcl_interfaces::msg::FloatingPointRange float_range;
+          float_range.from_value = 0.01;
+          float_range.to_value = 3600.0;
+          desc.floating_point_range.push_back(float_range);
+          desc.read_only = true;
+          statistics_period = declare_parameter(desc.name, statistics_period, desc);
+        }
+
+        if (publish_statistics)
+        {
+          statistics_.reset (new NodeStatistics);
+          pub_statistics_ = this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("~/statistics", rclcpp::QoS(1));
+          statistics_timer_ = this->create_wall_timer(
+            std::chrono::duration<double>(statistics_period), std::bind(&PCLNode::publishStatistics, this));
+        }
+
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "use_search_cache";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+          desc.description = "Share the kd-trees built over the input clouds with the other nodes of the process "
+                             "(e.g. composed in the same container), instead of building one per node.";
+          desc.read_only = true;
+          use_search_cache_ = declare_parameter(desc.name, use_search_cache_, desc);
+        }
+
+        int search_cache_entries = 2;
+        {
+          rcl_interfaces::msg::ParameterDescriptor desc;
+          desc.name = "search_cache_entries";
+          desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+          desc.description = "Number of clouds whose search structures are kept in the process-wide cache. The "
+                             "largest value of the nodes using the cache is used.";
+          rcl_interfaces::msg::IntegerRange int_range;
+          int_range.from_value = 1;
+          int_range.to_value = 64;
+          desc.integer_range.push_back(int_range);
+          desc.read_only = true;
+          search_cache_entries = declare_parameter(desc.name, search_cache_entries, desc);
+        }
+
+        if (use_search_cache_)
+          SearchCache::instance ().reserve (static_cast<size_t> (search_cache_entries), 0);
+
         RCLCPP_DEBUG (this->get_logger(), "PCL Node successfully created with the following parameters:\n"
-                      " - approximate_sync : %s\n"
-                      " - use_indices      : %s\n"
-                      " - latched_indices  : %s\n"
-                      " - max_queue_size   : %d",
+                      " - approximate_sync   : %s\n"
+                      " - use_indices        : %s\n"
+                      " - latched_indices    : %s\n"
+                      " - max_queue_size     : %d\n"
+                      " - num_workers        : %d\n"
+                      " - queue_policy       : %s\n"
+                      " - processing_budget  : %f ms\n"
+                      " - publish_statistics : %s\n"
+                      " - use_search_cache   : %s",
                       (approximate_sync_) ? "true" : "false",
                       (use_indices_) ? "true" : "false",
                       (latched_indices_) ? "true" : "false",
-                      max_queue_size_);
+                      max_queue_size_,
+                      num_workers_,
+                      queue_policy.c_str(),
+                      processing_budget_ms,
+                      (publish_statistics) ? "true" : "false",
+                      (use_search_cache_) ? "true" : "false");
       }
 
     protected:
@@ -179,6 +346,21 @@ namespace pcl_ros
       /** \brief The maximum queue size (default: 3). */
       int max_queue_size_ = 3;
 
+      /** \brief The maximum number of frames processed concurrently (default: 1). */
+      int num_workers_ = 1;
+
+      /** \brief Queueing policy of the input topics, see the \a queue_policy parameter. */
+      enum QueuePolicy
+      {
+        QUEUE_ALL,
+        QUEUE_LATEST,
+        QUEUE_MAX_AGE
+      };
+      QueuePolicy queue_policy_ = QUEUE_ALL;
+
+      /** \brief The maximum age of a frame at dequeue with QUEUE_MAX_AGE, in milliseconds (default: 100). */
+      double max_age_ms_ = 100.0;
+
       /** \brief True if we use an approximate time synchronizer versus an exact one (false by default). */
       bool approximate_sync_ = false;
 
@@ -186,6 +368,81 @@ namespace pcl_ros
       tf2_ros::Buffer tf_buffer_;
       tf2_ros::TransformListener tf_listener_;
 
+      /** \brief Per-frame statistics, only allocated if \a publish_statistics is set. Create a
+        * NodeStatistics::Frame with statistics_.get () for every received frame; it does nothing when null.
+        */
+      std::unique_ptr<NodeStatistics> statistics_;
+
+      /** \brief The statistics publisher and its timer. */
+      rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr pub_statistics_;
+      rclcpp::TimerBase::SharedPtr statistics_timer_;
+
+      /** \brief Adaptive quality controller, only allocated if \a processing_budget_ms is set. */
+      std::unique_ptr<QualityController> quality_;
+
+      /** \brief The quality level publisher. */
+      rclcpp::Publisher<std_msgs::msg::UInt8>::SharedPtr pub_quality_level_;
+
+      /** \brief Set to true to get the search structures of the input clouds from SearchCache (false by default). */
+      bool use_search_cache_ = false;
+
+      /** \brief Get the quality level to process the next frame with, 0 (full quality) without a budget. */
+      inline int
+      qualityLevel () const
+      {
+        return (quality_ ? quality_->level () : 0);
+      }
+
+      /** \brief Account for the compute time of a frame, and publish the quality level if it changed.
+        * \param level the quality level the frame was processed with
+        * \param compute_ms the compute time of the frame, in milliseconds
+        */
+      void
+      updateQuality (int level, double compute_ms)
+      {
+        if (!quality_ || !quality_->update (level, compute_ms))
+          return;
+
+        std_msgs::msg::UInt8 msg;
+        msg.data = static_cast<uint8_t> (quality_->level ());
+        RCLCPP_INFO (this->get_logger(), "Average compute time %f ms against a budget, switching to quality level %d.",
+                     quality_->average (), msg.data);
+        pub_quality_level_->publish (msg);
+      }
+
+      /** \brief Publish the statistics collected since the last call. */
+      void
+      publishStatistics ()
+      {
+        diagnostic_msgs::msg::DiagnosticArray array;
+        array.header.stamp = this->now ();
+        diagnostic_msgs::msg::DiagnosticStatus status;
+        status.name = this->get_fully_qualified_name ();
+        status.hardware_id = "none";
+        statistics_->report (status);
+        if (use_search_cache_)
+        {
+          // Process-wide counters
+          const SearchCache::Statistics cache = SearchCache::instance ().statistics ();
+          const std::pair<const char *, double> values[] = {
+            {"search_cache.hits", static_cast<double> (cache.hits)},
+            {"search_cache.misses", static_cast<double> (cache.misses)},
+            {"search_cache.evictions", static_cast<double> (cache.evictions)},
+            {"search_cache.build_ms_saved", cache.build_ms_saved},
+            {"search_cache.entries", static_cast<double> (cache.entries)},
+            {"search_cache.bytes", static_cast<double> (cache.bytes)}};
+          for (const auto &value : values)
+          {
+            diagnostic_msgs::msg::KeyValue kv;
+            kv.key = value.first;
+            kv.value = std::to_string (value.second);
+            status.values.push_back (kv);
+          }
+        }
+        array.status.push_back (status);
+        pub_statistics_->publish (array);
+      }
+
       /** \brief Test whether a given PointCloud message is "valid" (i.e., has points, and width and height are non-zero).
         * \param cloud the point cloud to test
         * \param topic_name an optional topic name (only used for printing, defaults to "input")
@@ -252,11 +509,44 @@ namespace pcl_ros
         return true;
       }
 
+      /** \brief Test whether a received frame is too old to be processed, according to the queue policy. Call when
+        * the frame is dequeued, i.e. at the beginning of the callback, and drop the frame if true. Frames without a
+        * stamp (zero) are never stale.
+        * \param header the header of the received message
+        */
+      inline bool
+      isStale (const std_msgs::msg::Header &header)
+      {
+        if (queue_policy_ != QUEUE_MAX_AGE)
+          return (false);
+        // Unstamped clouds (e.g. from a file or a test publisher) have no age
+        if (header.stamp.sec == 0 && header.stamp.nanosec == 0)
+          return (false);
+
+        const rclcpp::Time stamp(header.stamp, this->get_clock()->get_clock_type());
+        const double age_ms = (this->now() - stamp).seconds() * 1000.0;
+        if (age_ms <= max_age_ms_)
+          return (false);
+
+        RCLCPP_DEBUG(this->get_logger(), "Dropping a frame with stamp %d.%09u and frame %s, %f ms old.",
+                     header.stamp.sec, header.stamp.nanosec, header.frame_id.c_str(), age_ms);
+        return (true);
+      }
+
+      /** \brief History depth of the input topics and of the message_filters synchronizer queues, 1 with the
+        * QUEUE_LATEST policy.
+        */
+      inline int
+      inputQueueSize() const
+      {
+        return (queue_policy_ == QUEUE_LATEST ? 1 : max_queue_size_);
+      }
+
       /* \brief Return QoS settings for indices topic */
       rclcpp::QoS
       indicesQoS() const
       {
-        rclcpp::QoS qos(max_queue_size_);
+        rclcpp::QoS qos(inputQueueSize());
         if (latched_indices_) {
           qos.transient_local();
         }
@@ -266,6 +556,15 @@ namespace pcl_ros
       /* \brief Return QoS settings for point cloud topic */
       rclcpp::QoS
       cloudQoS() const
+      {
+        rclcpp::QoS qos(inputQueueSize());
+        return qos;
+      }
+
+      /* \brief Return QoS settings for output topics. Independent of the queue policy, which only bounds what
+       * this node processes, not what the downstream nodes receive. */
+      rclcpp::QoS
+      outputQoS() const
       {
         rclcpp::QoS qos(max_queue_size_);
         return qos;
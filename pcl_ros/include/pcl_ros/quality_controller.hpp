@@ -0,0 +1,142 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__QUALITY_CONTROLLER_HPP_
+#define PCL_ROS__QUALITY_CONTROLLER_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace pcl_ros
+{
+  /** \brief @b QualityController picks a quality level for the next frame from the recent compute times and a
+    * processing budget. Level 0 is the full quality, every level above roughly halves the work to do; what is
+    * degraded is up to the node (search radius, approximate clustering...).
+    *
+    * The compute time is smoothed with an exponentially weighted moving average. The level goes up when the average
+    * exceeds the budget, and down when it falls below \a recover_ratio times the budget, i.e. when halving the work
+    * back would still fit. The level stays unchanged for \a hold_frames frames after every change, so that the
+    * average reflects the new level before the next decision.
+    */
+  class QualityController
+  {
+    public:
+      /** \brief Constructor.
+        * \param budget_ms the processing time budget of a frame, in milliseconds
+        * \param max_level the lowest quality level allowed
+        * \param alpha the weight of the newest sample in the moving average
+        * \param recover_ratio the fraction of the budget under which the quality is raised again
+        * \param hold_frames the number of frames to wait after a level change
+        */
+      QualityController (double budget_ms, int max_level, double alpha = 0.3, double recover_ratio = 0.4,
+                         int hold_frames = 5) :
+        budget_ms_ (budget_ms), max_level_ (max_level), alpha_ (alpha), recover_ratio_ (recover_ratio),
+        hold_frames_ (hold_frames)
+      {}
+
+      /** \brief Get the quality level to use for the next frame. */
+      inline int
+      level () const
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return (level_);
+      }
+
+      /** \brief Get the smoothed compute time, in milliseconds. */
+      inline double
+      average () const
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return (average_ms_);
+      }
+
+      /** \brief Account for the compute time of a frame processed at \a level.
+        * \return true if the quality level changed
+        */
+      bool
+      update (int level, double compute_ms)
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+        // Samples of frames started before the last change do not describe the current level
+        if (level != level_)
+          return (false);
+
+        average_ms_ = (nr_samples_ == 0) ? compute_ms : alpha_ * compute_ms + (1.0 - alpha_) * average_ms_;
+        ++nr_samples_;
+        if (nr_samples_ < hold_frames_)
+          return (false);
+
+        int new_level = level_;
+        if (average_ms_ > budget_ms_ && level_ < max_level_)
+          ++new_level;
+        else if (average_ms_ < recover_ratio_ * budget_ms_ && level_ > 0)
+          --new_level;
+        if (new_level == level_)
+          return (false);
+
+        level_ = new_level;
+        nr_samples_ = 0;
+        return (true);
+      }
+
+      /** \brief Scale a value by 2^-level, e.g. a number of iterations. */
+      static inline double
+      scale (int level)
+      {
+        return (std::ldexp (1.0, -level));
+      }
+
+      /** \brief Scale a search radius so that the search volume, hence roughly the cost, is halved at each level. */
+      static inline double
+      radiusScale (int level)
+      {
+        return (std::pow (2.0, -level / 3.0));
+      }
+
+    private:
+      double budget_ms_;
+      int max_level_;
+      double alpha_;
+      double recover_ratio_;
+      int hold_frames_;
+
+      mutable std::mutex mutex_;
+      int level_ = 0;
+      int nr_samples_ = 0;
+      double average_ms_ = 0.0;
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__QUALITY_CONTROLLER_HPP_
@@ -0,0 +1,170 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__SEARCH_CACHE_HPP_
+#define PCL_ROS__SEARCH_CACHE_HPP_
+
+#include <chrono>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// PCL includes
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl/search/search.h>
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+namespace pcl_ros
+{
+  /** \brief @b SearchCache shares the search structures built over a point cloud between all the nodes of a process
+    * (e.g. composed in the same container with intra-process communication), so that a cloud fed to several nodes is
+    * only converted and indexed once.
+    *
+    * Entries are keyed by the identity of the message: its data buffer, stamp and frame. A weak reference to the
+    * message is kept to tell a buffer reused by another message apart, so entries never keep the messages alive.
+    * The least recently used entries are evicted beyond \a max_entries or \a max_bytes.
+    *
+    * The searchers are shared: use them for queries only, with \a Entry::cloud as their input cloud (PCL algorithms
+    * such as pcl::Feature do not rebuild a searcher whose input cloud is already the one to search).
+    */
+  class SearchCache
+  {
+    public:
+      typedef pcl::PointCloud<pcl::PointXYZ> Cloud;
+      typedef pcl::search::Search<pcl::PointXYZ> Search;
+
+      /** \brief The kind of search structure. */
+      enum Kind
+      {
+        KDTREE,     // pcl::search::KdTree, any cloud
+        ORGANIZED   // pcl::search::OrganizedNeighbor, organized clouds from a projective sensor only
+      };
+
+      /** \brief A cloud and its search structure. */
+      struct Entry
+      {
+        Cloud::ConstPtr cloud;
+        Search::Ptr search;
+        /** \brief The time spent converting the cloud and building the searcher, in milliseconds. */
+        double build_ms = 0.0;
+        /** \brief An estimate of the memory held by the cloud and the searcher, in bytes. */
+        size_t bytes = 0;
+      };
+      typedef std::shared_ptr<const Entry> EntryConstPtr;
+
+      /** \brief Cumulative counters of the cache. */
+      struct Statistics
+      {
+        /** \brief The searchers found in the cache, failed builds excluded. */
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        /** \brief The build time of the entries found in the cache, in milliseconds. */
+        double build_ms_saved = 0.0;
+        size_t entries = 0;
+        size_t bytes = 0;
+      };
+
+      /** \brief Get the cache of the process. Defined in the pcl_ros_tf library, which all the component libraries
+        * loaded in a container share.
+        */
+      static SearchCache &
+      instance ();
+
+      /** \brief Raise the capacity of the cache. Each node asks for what it needs, the largest request wins.
+        * \param max_entries the maximum number of entries
+        * \param max_bytes the maximum estimated memory held by the entries
+        */
+      void
+      reserve (size_t max_entries, size_t max_bytes);
+
+      /** \brief Get the search structure of a cloud, building it if not cached. Concurrent requests for the same
+        * cloud wait for a single build.
+        * \param cloud the cloud message
+        * \param kind the kind of search structure
+        * \return the entry, null if the cloud has no x, y and z fields
+        */
+      EntryConstPtr
+      get (const sensor_msgs::msg::PointCloud2::ConstSharedPtr &cloud, Kind kind = KDTREE);
+
+      /** \brief Get the counters of the cache. */
+      Statistics
+      statistics () const;
+
+      /** \brief Remove all the entries. */
+      void
+      clear ();
+
+    private:
+      struct Slot
+      {
+        uint64_t id;
+        const void *data;
+        int32_t sec;
+        uint32_t nanosec;
+        std::string frame_id;
+        Kind kind;
+        std::weak_ptr<const sensor_msgs::msg::PointCloud2> message;
+        std::shared_future<EntryConstPtr> entry;
+        /** \brief Set once the entry is built. */
+        bool built = false;
+        size_t bytes = 0;
+        double build_ms = 0.0;
+      };
+
+      SearchCache () = default;
+
+      /** \brief Convert the cloud and build its searcher. */
+      static EntryConstPtr
+      build (const sensor_msgs::msg::PointCloud2 &cloud, Kind kind);
+
+      /** \brief Evict the least recently used built entries over capacity. Called with \a mutex_ held. */
+      void
+      evict ();
+
+      mutable std::mutex mutex_;
+      /** \brief Most recently used first. */
+      std::list<Slot> slots_;
+      uint64_t next_id_ = 0;
+      size_t max_entries_ = 2;
+      size_t max_bytes_ = 256 * 1024 * 1024;
+      Statistics statistics_;
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__SEARCH_CACHE_HPP_
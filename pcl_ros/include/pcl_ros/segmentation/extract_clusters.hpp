@@ -38,8 +38,13 @@
 #ifndef PCL_ROS__SEGMENTATION__EXTRACT_CLUSTERS_HPP_
 #define PCL_ROS__SEGMENTATION__EXTRACT_CLUSTERS_HPP_
 
+#include <limits>
+#include <mutex>
+#include <string>
+
 #include <pcl/segmentation/extract_clusters.h>
 #include "pcl_ros/pcl_node.hpp"
+#include "pcl_ros/segmentation/voxel_clustering.hpp"
 
 namespace pcl_ros
 {
@@ -48,6 +53,17 @@ namespace pcl_ros
   ////////////////////////////////////////////////////////////////////////////////////////////
   ////////////////////////////////////////////////////////////////////////////////////////////
   /** \brief @b EuclideanClusterExtraction represents a segmentation class for cluster extraction in an Euclidean sense.
+    *
+    * The clusters of a frame are published either one message per cluster (PointIndices, or PointCloud2 of the
+    * cluster points), or all together in a single PointCloud2 of pcl::PointXYZL with \a batch_output_, the label of
+    * a point being the number of its cluster.
+    *
+    * The clusters are extracted by pcl::EuclideanClusterExtraction, by the parallel VoxelClustering engine (method
+    * "voxel"), or for organized clouds by pcl::OrganizedConnectedComponentSegmentation (method "organized", see
+    * extractOrganizedClusters ()), which joins the neighboring pixels within the tolerance in linear time and builds
+    * no kd-tree. With
+    * \a use_search_cache, pcl::EuclideanClusterExtraction searches the whole clouds (without indices) with the kd-tree
+    * of SearchCache, shared with the other nodes of the process.
     * \author Radu Bogdan Rusu
     */
   class EuclideanClusterExtraction : public PCLNode
@@ -59,27 +75,65 @@ namespace pcl_ros
     protected:
       // ROS node attributes
       /** \brief Publish indices or convert to PointCloud clusters. Default: false */
-      bool publish_indices_;
+      bool publish_indices_ = false;
+
+      /** \brief Publish all the clusters of a frame in one labeled point cloud, with the stamp of the input. With
+        * \a publish_indices_ too, the labeled cloud is published and the indices of the input points are lost.
+        * Default: false
+        */
+      bool batch_output_ = false;
+
+      /** \brief The clustering method: euclidean, voxel or organized. Default: euclidean */
+      std::string cluster_method_ = "euclidean";
 
       /** \brief Maximum number of clusters to publish. */
-      int max_clusters_;
+      int max_clusters_ = std::numeric_limits<int>::max ();
+
+      /** \brief Internal mutex. */
+      std::mutex mutex_;
+
+      /** \brief Parameter callback function handle. */
+      rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr callback_handle_;
+
+      /** \brief Parameter callback
+        * \param params parameter values to set
+        */
+      rcl_interfaces::msg::SetParametersResult
+      config_callback (const std::vector<rclcpp::Parameter> & params);
 
       /** \brief Input point cloud callback. 
         * \param cloud the pointer to the input point cloud
         * \param indices the pointer to the input point cloud indices
         */
-      void input_indices_callback (const PointCloudConstPtr &cloud, const PointIndicesConstPtr &indices);
+      void input_indices_callback (const PointCloud2::ConstSharedPtr &cloud, const PointIndicesConstPtr &indices);
+
+      /** \brief Publish the clusters of a frame in one pcl::PointXYZL point cloud.
+        * \param header the header of the input
+        * \param cloud the input point cloud
+        * \param clusters the clusters to publish
+        */
+      void publishLabeled (const std_msgs::msg::Header &header, const PointCloud &cloud,
+                           const std::vector<pcl::PointIndices> &clusters);
 
     private:
       /** \brief The PCL implementation used. */
       pcl::EuclideanClusterExtraction<pcl::PointXYZ> impl_;
 
+      /** \brief The parallel voxel clustering engine, used by the voxel method. */
+      VoxelClustering voxel_impl_;
+
       /** \brief The input PointCloud subscriber. */
-      rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr sub_input_;
+      rclcpp::Subscription<PointCloud2>::SharedPtr sub_input_;
+
+      /** \brief The output PointIndices publisher, when \a publish_indices_ is set without \a batch_output_. */
+      rclcpp::Publisher<PointIndices>::SharedPtr pub_indices_;
 
       /** \brief Synchronized input, and indices.*/
-      std::shared_ptr<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointIndices> > >       sync_input_indices_e_;
-      std::shared_ptr<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointIndices> > > sync_input_indices_a_;
+      std::shared_ptr<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointIndices> > >       sync_input_indices_e_;
+      std::shared_ptr<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointIndices> > > sync_input_indices_a_;
+
+      void subscribe ();
+      void unsubscribe ();
 
     public:
       EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -0,0 +1,70 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__SEGMENTATION__ORGANIZED_CLUSTERING_HPP_
+#define PCL_ROS__SEGMENTATION__ORGANIZED_CLUSTERING_HPP_
+
+#include <memory>
+#include <vector>
+
+#include <pcl/PointIndices.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace pcl_ros
+{
+  /** \brief Extract the Euclidean clusters of an organized cloud in image space, with
+    * pcl::OrganizedConnectedComponentSegmentation: neighboring pixels are joined when their points are closer than
+    * the tolerance, in linear time and without a kd-tree.
+    *
+    * The clusters are those of pcl::EuclideanClusterExtraction when every pair of points within the tolerance is also
+    * connected through neighboring pixels, e.g. densely sampled surfaces whose holes do not split them. Otherwise a
+    * cluster may be split in several: across a gap of invalid or masked pixels narrower than the tolerance, or at a
+    * pixel whose neighbors are all invalid. Note also that neighboring pixels are joined when strictly closer than the
+    * tolerance, where pcl::EuclideanClusterExtraction joins points at the tolerance too.
+    * \param cloud the organized input cloud
+    * \param indices the indices of the points to cluster, all the points if null. The other points, e.g. the planes
+    * of a prior segmentation, are masked out and also separate the clusters.
+    * \param tolerance the spatial cluster tolerance
+    * \param min_cluster_size the minimum number of points of a cluster
+    * \param max_cluster_size the maximum number of points of a cluster
+    * \param clusters the resultant clusters, sorted by decreasing size, with their indices in increasing order
+    */
+  void
+  extractOrganizedClusters (const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &cloud,
+                            const std::shared_ptr<std::vector<int> > &indices, float tolerance,
+                            int min_cluster_size, int max_cluster_size, std::vector<pcl::PointIndices> &clusters);
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__SEGMENTATION__ORGANIZED_CLUSTERING_HPP_
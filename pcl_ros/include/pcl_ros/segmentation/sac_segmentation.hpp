@@ -112,12 +112,10 @@ namespace pcl_ros
         * \param cloud the pointer to the input point cloud
         * \param indices the pointer to the input point cloud indices
         */
-      void input_indices_callback (const PointCloudPtr cloud, const PointIndicesPtr indices);
+      void input_indices_callback (const PointCloudConstPtr &cloud, const PointIndicesConstPtr &indices);
 
-      /** \brief Pointer to a set of indices stored internally.
-       * (used when \a latched_indices_ is set). 
-       */
-      PointIndices indices_;
+      /** \brief The latest indices received (used when \a latched_indices_ is set). */
+      PointIndicesConstPtr indices_;
 
       /** \brief Indices callback. Used when \a latched_indices_ is set.
         * \param indices the pointer to the input point cloud indices
@@ -125,25 +123,37 @@ namespace pcl_ros
       inline void
       indices_callback (const PointIndicesConstPtr &indices)
       {
-        indices_ = *indices.get();
+        std::lock_guard<std::mutex> lock (indices_mutex_);
+        indices_ = indices;
       }
 
-      /** \brief Input callback. Used when \a latched_indices_ is set.
+      /** \brief Input callback. Used when \a latched_indices_ is set: the cloud is segmented right away with the
+        * latest indices received, bypassing the synchronizer.
         * \param input the pointer to the input point cloud
         */
       inline void
       input_callback (const PointCloudConstPtr &input)
       {
-        indices_.header = fromPCL(input->header);
         PointIndicesConstPtr indices;
-        indices.reset (new PointIndices (indices_));
-        nf_pi_.add (indices);
+        {
+          std::lock_guard<std::mutex> lock (indices_mutex_);
+          indices = indices_;
+        }
+        if (!indices)
+        {
+          RCLCPP_WARN_THROTTLE (this->get_logger (), *this->get_clock (), 5000, "No indices received yet, dropping the input clouds.");
+          return;
+        }
+        input_indices_callback (input, indices);
       }
 
     private:
       /** \brief Internal mutex. */
       std::mutex mutex_;
 
+      /** \brief Protects \a indices_. */
+      std::mutex indices_mutex_;
+
       /** \brief The PCL implementation used. */
       pcl::SACSegmentation<pcl::PointXYZ> impl_;
 
@@ -0,0 +1,126 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PCL_ROS__SEGMENTATION__VOXEL_CLUSTERING_HPP_
+#define PCL_ROS__SEGMENTATION__VOXEL_CLUSTERING_HPP_
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <pcl/PointIndices.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+namespace pcl_ros
+{
+  /** \brief @b VoxelClustering extracts Euclidean clusters with a voxel grid and a concurrent union-find, instead of
+    * the radius search per point and the sequential region growing of pcl::EuclideanClusterExtraction.
+    *
+    * The points are hashed into voxels whose diagonal is the cluster tolerance: the points of a voxel all belong to the
+    * same cluster, and the points within the tolerance of a point lie in the 5x5x5 voxels around its own. The voxels
+    * are split between threads, each joining its voxels with their occupied neighbors in a lock-free union-find:
+    *  - with refinement (default), neighboring voxels are joined when two of their points are within the tolerance,
+    *    which gives exactly the clusters of pcl::EuclideanClusterExtraction;
+    *  - without, the neighboring voxels are joined whole when the bounding boxes of their points are within the
+    *    tolerance. Points within the tolerance are never split, but points up to 3 tolerances apart may be joined.
+    * The clusters are sorted by decreasing size, with their indices in increasing order.
+    */
+  class VoxelClustering
+  {
+    public:
+      /** \brief Set the spatial cluster tolerance. */
+      inline void
+      setClusterTolerance (double tolerance)
+      {
+        tolerance_ = tolerance;
+      }
+
+      inline double getClusterTolerance () const { return (tolerance_); }
+
+      /** \brief Set the minimum number of points of a cluster. */
+      inline void
+      setMinClusterSize (int min_cluster_size)
+      {
+        min_cluster_size_ = min_cluster_size;
+      }
+
+      inline int getMinClusterSize () const { return (min_cluster_size_); }
+
+      /** \brief Set the maximum number of points of a cluster. */
+      inline void
+      setMaxClusterSize (int max_cluster_size)
+      {
+        max_cluster_size_ = max_cluster_size;
+      }
+
+      inline int getMaxClusterSize () const { return (max_cluster_size_); }
+
+      /** \brief Set to false to join neighboring voxels whole, on the distance between the bounding boxes of their points. */
+      inline void
+      setRefine (bool refine)
+      {
+        refine_ = refine;
+      }
+
+      inline bool getRefine () const { return (refine_); }
+
+      /** \brief Set the maximum number of threads, 0 for the number of cores. */
+      inline void
+      setNumberOfThreads (unsigned int nr_threads)
+      {
+        nr_threads_ = nr_threads;
+      }
+
+      inline unsigned int getNumberOfThreads () const { return (nr_threads_); }
+
+      /** \brief Extract the clusters of a cloud. The points that are not finite are left out.
+        * \param cloud the input cloud
+        * \param indices the indices of the points to cluster, all the points if null
+        * \param clusters the resultant clusters
+        */
+      void
+      extract (const pcl::PointCloud<pcl::PointXYZ> &cloud, const std::shared_ptr<const std::vector<int> > &indices,
+               std::vector<pcl::PointIndices> &clusters) const;
+
+    private:
+      double tolerance_ = 0.05;
+      int min_cluster_size_ = 1;
+      int max_cluster_size_ = std::numeric_limits<int>::max ();
+      bool refine_ = true;
+      unsigned int nr_threads_ = 0;
+  };
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__SEGMENTATION__VOXEL_CLUSTERING_HPP_
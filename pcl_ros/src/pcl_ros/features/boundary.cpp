@@ -36,9 +36,10 @@
  */
 
 #include "pcl_ros/features/boundary.hpp"
-pcl_ros::BoundaryEstimation::BoundaryEstimation (std::string node_name, const rclcpp::NodeOptions& options) : pcl_ros::FeatureFromNormals(node_name, options)
+
+pcl_ros::BoundaryEstimation::BoundaryEstimation (const rclcpp::NodeOptions& options) : pcl_ros::FeatureFromNormals("BoundaryEstimationNode", options)
 {
-  pub_output_ = this->create_publisher<PointCloudOut> ("output", max_queue_size_);
+  subscribe ();
 }
 
 void
@@ -46,7 +47,7 @@ pcl_ros::BoundaryEstimation::emptyPublish (const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish (output.makeShared ());
+  publishOutput (output);
 }
 
 void
@@ -56,13 +57,14 @@ pcl_ros::BoundaryEstimation::computePublish (const PointCloudInConstPtr &cloud,
                                              const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch (k_);
-  impl_.setRadiusSearch (search_radius_);
+  impl_.setKSearch (searchK ());
+  impl_.setRadiusSearch (searchRadius ());
 
   // Set the inputs
   impl_.setInputCloud (cloud);
   impl_.setIndices (indices);
   impl_.setSearchSurface (surface);
+  impl_.setSearchMethod (tree_);
   impl_.setInputNormals (normals);
   // Estimate the feature
   PointCloudOut output;
@@ -70,7 +72,7 @@ pcl_ros::BoundaryEstimation::computePublish (const PointCloudInConstPtr &cloud,
 
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishOutput (output);
 }
 
 typedef pcl_ros::BoundaryEstimation BoundaryEstimation;
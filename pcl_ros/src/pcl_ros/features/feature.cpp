@@ -33,55 +33,187 @@
  *
  * $Id: feature.cpp 35422 2011-01-24 20:04:44Z rusu $
  *
- */
-
-// Include the implementations here instead of compiling them separately to speed up compile time
-//#include "normal_3d.cpp"
-//#include "boundary.cpp"
-//#include "fpfh.cpp"
-//#include "fpfh_omp.cpp"
-//#include "moment_invariants.cpp"
-//#include "normal_3d_omp.cpp"
-//#include "normal_3d_tbb.cpp"
-//#include "pfh.cpp"
-//#include "principal_curvatures.cpp"
-//#include "vfh.cpp"
+
 #include <pcl/common/io.h>
+#include <chrono>
 #include "pcl_ros/features/feature.hpp"
-#include <message_filters/null_types.h>
+#include "pcl_ros/features/keypoints.hpp"
 
-////////////////////////////////////////////////////////////////////////////////////////////
-pcl_ros::Feature::Feature (std::string node_name, const rclcpp::NodeOptions& options) : pcl_ros::PCLNode(node_name, options)
+namespace
 {
-  // Allow each individual class that inherits from us to declare their own Publisher
-  // This is useful for Publisher<pcl::PointCloud<T> >, as NormalEstimation can publish PointCloud<Normal>, etc
-  //pub_output_ = this->template advertise<PointCloud2> ("output", max_queue_size_);
-
-  // ---[ Mandatory parameters
-  if (!this->get_parameter ("k_search", k_) && !this->get_parameter ("radius_search", search_radius_))
+  /** \brief An empty input cloud with the header of a message, for emptyPublish (). */
+  pcl_ros::Feature::PointCloudInConstPtr
+  emptyCloud (const sensor_msgs::msg::PointCloud2 &cloud)
   {
-    RCLCPP_ERROR (this->get_logger(), "[%s::onConstructor] Neither 'k_search' nor 'radius_search' set! Need to set at least one of these parameters before continuing.", this->get_name());
-    return;
-  }
-  if (!this->get_parameter ("spatial_locator", spatial_locator_type_))
-  {
-    RCLCPP_ERROR (this->get_logger(), "[%s::onConstructor] Need a 'spatial_locator' parameter to be set before continuing!", this->get_name ());
-    return;
+    pcl_ros::Feature::PointCloudInPtr empty (new pcl_ros::Feature::PointCloudIn);
+    pcl_conversions::toPCL (cloud.header, empty->header);
+    return (empty);
   }
+}  // namespace
 
-  // ---[ Optional parameters
-  this->get_parameter ("use_surface", use_surface_);
+////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::Feature::Feature (std::string node_name, const rclcpp::NodeOptions& options)
+: pcl_ros::PCLNode(node_name, options)
+{
+  rcl_interfaces::msg::ParameterDescriptor k_search_desc;
+  k_search_desc.name = "k_search";
+  k_search_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  k_search_desc.description = "Number of k-nearest neighbors to search for. Exactly one of k_search and radius_search must be non-zero.";
+  rcl_interfaces::msg::IntegerRange k_search_range;
+  k_search_range.from_value = 0;
+  k_search_range.to_value = 1000;
+  k_search_desc.integer_range.push_back (k_search_range);
+  declare_parameter (k_search_desc.name, rclcpp::ParameterValue(k_), k_search_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor radius_search_desc;
+  radius_search_desc.name = "radius_search";
+  radius_search_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  radius_search_desc.description = "Sphere radius for nearest neighbor search. Exactly one of k_search and radius_search must be non-zero.";
+  rcl_interfaces::msg::FloatingPointRange radius_search_range;
+  radius_search_range.from_value = 0.0;
+  radius_search_range.to_value = 10.0;
+  radius_search_desc.floating_point_range.push_back (radius_search_range);
+  declare_parameter (radius_search_desc.name, rclcpp::ParameterValue(search_radius_), radius_search_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor use_surface_desc;
+  use_surface_desc.name = "use_surface";
+  use_surface_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  use_surface_desc.description = "Search the neighbors in the point clouds received on the surface topic, instead of the input.";
+  use_surface_desc.read_only = true;
+  use_surface_ = declare_parameter (use_surface_desc.name, use_surface_, use_surface_desc);
+
+  pub_output_ = this->create_publisher<PointCloud2> ("output", outputQoS ());
+
+  callback_handle_ = add_on_set_parameters_callback (std::bind (&Feature::config_callback, this, std::placeholders::_1));
+
+  std::vector<std::string> param_names{
+    k_search_desc.name,
+    radius_search_desc.name,
+  };
+  auto result = config_callback (get_parameters (param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
 
   RCLCPP_DEBUG (this->get_logger(), "[%s::onConstructor] Node successfully created with the following parameters:\n"
                  " - use_surface    : %s\n"
                  " - k_search       : %d\n"
-                 " - radius_search  : %f\n"
-                 " - spatial_locator: %d",
+                 " - radius_search  : %f",
                 this->get_name (),
-                (use_surface_) ? "true" : "false", k_, search_radius_, spatial_locator_type_);
-  
-  pub_output_ = this->create_publisher<PointCloud2> ("output", max_queue_size_);
+                (use_surface_) ? "true" : "false", k_, search_radius_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::Feature::config_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+
+  int k = k_;
+  double search_radius = search_radius_;
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "k_search")
+      k = param.as_int ();
+    else if (param.get_name () == "radius_search")
+      search_radius = param.as_double ();
+  }
+
+  rcl_interfaces::msg::SetParametersResult result;
+  // PCL refuses to search with both or none
+  if ((k > 0) == (search_radius > 0.0))
+  {
+    result.successful = false;
+    result.reason = "Exactly one of k_search and radius_search must be non-zero (set them together to switch).";
+    return result;
+  }
+
+  if (k_ != k)
+  {
+    k_ = k;
+    RCLCPP_DEBUG (get_logger(), "Setting the number of K nearest neighbors to use for each point: %d.", k_);
+  }
+  if (search_radius_ != search_radius)
+  {
+    search_radius_ = search_radius;
+    RCLCPP_DEBUG (get_logger(), "Setting the nearest neighbors search radius for each point: %f.", search_radius_);
+  }
+
+  result.successful = true;
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::Feature::prepareInputs (const PointCloud2::ConstSharedPtr &cloud, const PointCloud2::ConstSharedPtr &surface,
+                                 PointCloudInConstPtr &cloud_out, PointCloudInConstPtr &surface_out)
+{
+  // The neighbors are searched in the surface, or in the input without surface
+  SearchCache::EntryConstPtr entry;
+  if (use_search_cache_)
+    entry = SearchCache::instance ().get (surface ? surface : cloud);
+  tree_ = entry ? entry->search : KdTreePtr ();
+
+  if (entry && !surface)
+    cloud_out = entry->cloud;
+  else
+  {
+    PointCloudInPtr converted (new PointCloudIn);
+    pcl::fromROSMsg (*cloud, *converted);
+    cloud_out = converted;
+  }
 
+  if (!surface)
+    surface_out.reset ();
+  else if (entry)
+    surface_out = entry->cloud;
+  else
+  {
+    PointCloudInPtr converted (new PointCloudIn);
+    pcl::fromROSMsg (*surface, *converted);
+    surface_out = converted;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::Feature::declareOutputPointNormals ()
+{
+  rcl_interfaces::msg::ParameterDescriptor desc;
+  desc.name = "output_point_normals";
+  desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  desc.description = "Publish the normals with their points (pcl::PointNormal), for the point_normals input of the descriptor nodes.";
+  desc.read_only = true;
+  output_point_normals_ = declare_parameter (desc.name, output_point_normals_, desc);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::Feature::publishNormals (const PointCloudInConstPtr &cloud, const IndicesPtr &indices,
+                                  const pcl::PointCloud<pcl::Normal> &normals)
+{
+  if (!output_point_normals_)
+  {
+    publishOutput (normals);
+    return;
+  }
+
+  pcl::PointCloud<pcl::PointNormal> output;
+  output.header = normals.header;
+  output.points.resize (normals.points.size ());
+  for (size_t i = 0; i < normals.points.size (); ++i)
+  {
+    const pcl::PointXYZ &p = cloud->points[indices ? (*indices)[i] : i];
+    const pcl::Normal &n = normals.points[i];
+    pcl::PointNormal &out = output.points[i];
+    out.x = p.x; out.y = p.y; out.z = p.z;
+    out.normal_x = n.normal_x; out.normal_y = n.normal_y; out.normal_z = n.normal_z;
+    out.curvature = n.curvature;
+  }
+  output.width = normals.width;
+  output.height = normals.height;
+  output.is_dense = normals.is_dense && cloud->is_dense;
+  publishOutput (output);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -93,20 +225,20 @@ pcl_ros::Feature::subscribe ()
   {
     // Create the objects here
     if (approximate_sync_)
-      sync_input_surface_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudIn, PointIndices> > >(max_queue_size_);
+      sync_input_surface_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointCloud2, PointIndices> > >(inputQueueSize());
     else
-      sync_input_surface_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudIn, PointIndices> > >(max_queue_size_);
+      sync_input_surface_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointCloud2, PointIndices> > >(inputQueueSize());
 
     // Subscribe to the input using a filter
-    sub_input_filter_.subscribe (this->shared_from_this (), "input");
+    sub_input_filter_.subscribe (this, "input", cloudQoS ().get_rmw_qos_profile ());
     if (use_indices_)
     {
       // If indices are enabled, subscribe to the indices
-      sub_indices_filter_.subscribe (this->shared_from_this (), "indices");
+      sub_indices_filter_.subscribe (this, "indices", indicesQoS ().get_rmw_qos_profile ());
       if (use_surface_)     // Use both indices and surface
       {
         // If surface is enabled, subscribe to the surface, connect the input-indices-surface trio and register
-        sub_surface_filter_.subscribe (this->shared_from_this (), "surface");
+        sub_surface_filter_.subscribe (this, "surface", cloudQoS ().get_rmw_qos_profile ());
         if (approximate_sync_)
           sync_input_surface_indices_a_->connectInput (sub_input_filter_, sub_surface_filter_, sub_indices_filter_);
         else
@@ -126,7 +258,7 @@ pcl_ros::Feature::subscribe ()
     {
       sub_input_filter_.registerCallback (std::bind (&Feature::input_callback, this, std::placeholders::_1));
       // indices not enabled, connect the input-surface duo and register
-      sub_surface_filter_.subscribe (this->shared_from_this (), "surface");
+      sub_surface_filter_.subscribe (this, "surface", cloudQoS ().get_rmw_qos_profile ());
       if (approximate_sync_)
         sync_input_surface_indices_a_->connectInput (sub_input_filter_, sub_surface_filter_, nf_pi_);
       else
@@ -139,11 +271,14 @@ pcl_ros::Feature::subscribe ()
       sync_input_surface_indices_e_->registerCallback (std::bind (&Feature::input_surface_indices_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
   }
   else
-    // Subscribe in an old fashion to input only (no filters)
-    // Type masquerading not yet supported
-    // sub_input_ = this->create_subscription<PointCloudIn> ("input", std::bind (&Feature::input_surface_indices_callback, this, std::placeholders::_1, PointCloudInConstPtr (), PointIndicesConstPtr ()));
-    std::cout << "Type masquerading not yet supported" << std::endl;
+  {
+    // Workaround ros2/rclcpp#766
+    std::function<void(PointCloud2::ConstSharedPtr)> callback =
+        std::bind (&Feature::input_surface_indices_callback, this, std::placeholders::_1, nullptr, nullptr);
 
+    // Subscribe in an old fashion to input only (no filters)
+    sub_input_ = this->create_subscription<PointCloud2> ("input", cloudQoS (), callback);
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////
@@ -163,36 +298,40 @@ pcl_ros::Feature::unsubscribe ()
       sub_surface_filter_.unsubscribe ();
   }
   else
-    // FIXME
-    std::cout << "shutdown" << std::endl;
-    //sub_input_.shutdown ();
+    sub_input_.reset ();
 }
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 void
-pcl_ros::Feature::input_surface_indices_callback (const PointCloudInConstPtr &cloud, 
-    const PointCloudInConstPtr &cloud_surface, const PointIndicesConstPtr &indices)
+pcl_ros::Feature::input_surface_indices_callback (const PointCloud2::ConstSharedPtr &cloud,
+    const PointCloud2::ConstSharedPtr &cloud_surface, const PointIndicesConstPtr &indices)
 {
-  // No subscribers, no work
-  /*
-   count_subscribers not implemented ROS2
-   if (pub_output_->count_subscribers () <= 0)
+  NodeStatistics::Frame frame (statistics_.get ());
+
+  // Skip the frames that waited too long in the queue
+  if (isStale (cloud->header))
+  {
+    frame.dropped ("stale");
     return;
- */
+  }
+
   // If cloud is given, check if it's valid
   if (!isValid (cloud))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_surface_indices_callback] Invalid input!", this->get_name ());
-    emptyPublish (cloud);
+    frame.dropped ("invalid_input");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
 
   // If surface is given, check if it's valid
-  if (cloud_surface && !isValid (cloud_surface, "surface"))
+  const PointCloud2::ConstSharedPtr surface = optional (cloud_surface);
+  if (surface && !isValid (surface, "surface"))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_surface_indices_callback] Invalid input surface!", this->get_name ());
-    emptyPublish (cloud);
+    frame.dropped ("invalid_surface");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
     
@@ -200,52 +339,47 @@ pcl_ros::Feature::input_surface_indices_callback (const PointCloudInConstPtr &cl
   if (indices && !isValid (indices))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_surface_indices_callback] Invalid input indices!", this->get_name ());
-    emptyPublish (cloud);
+    frame.dropped ("invalid_indices");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
 
   /// DEBUG
-  if (cloud_surface)
-    if (indices)
-      RCLCPP_DEBUG (this->get_logger(), "[input_surface_indices_callback]\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                         - PointIndices with %zu values, stamp %f, and frame %s on topic %s received.",
-                 cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                 cloud_surface->width * cloud_surface->height, pcl::getFieldsList (*cloud_surface).c_str (), fromPCL(cloud_surface->header).stamp.sec, cloud_surface->header.frame_id.c_str (), "surface",
-                 indices->indices.size (), indices->header.stamp.sec, indices->header.frame_id.c_str (), "indices");
-    else
-      RCLCPP_DEBUG (this->get_logger(), "[input_surface_indices_callback]\n"
-                     "                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.",
-                     cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                     cloud_surface->width * cloud_surface->height, pcl::getFieldsList (*cloud_surface).c_str (), fromPCL(cloud_surface->header).stamp.sec, cloud_surface->header.frame_id.c_str (), "surface");
-
-  else
-    if (indices)
-      RCLCPP_DEBUG (this->get_logger(), "[input_surface_indices_callback]\n"
-                     "                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                 - PointIndices with %zu values, stamp %f, and frame %s on topic %s received.",
-                     cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                     indices->indices.size (), indices->header.stamp.sec, indices->header.frame_id.c_str (), "indices");
-    else
-      RCLCPP_DEBUG (this->get_logger(), "[input_surface_indices_callback] PointCloud with %d data points, stamp %f, and frame %s on topic %s received.", cloud->width * cloud->height, fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input");
+  RCLCPP_DEBUG (this->get_logger(), "[input_surface_indices_callback]\n"
+                 "                                 - PointCloud with %d data points (%s), stamp %d, and frame %s on topic %s received.\n"
+                 "                                 - PointCloud with %d data points, and frame %s on topic %s received.\n"
+                 "                                 - PointIndices with %zu values, and frame %s on topic %s received.",
+                 cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), cloud->header.stamp.sec, cloud->header.frame_id.c_str (), "input",
+                 surface ? surface->width * surface->height : 0, surface ? surface->header.frame_id.c_str () : "", "surface",
+                 indices ? indices->indices.size () : 0, indices ? indices->header.frame_id.c_str () : "", "indices");
   ///
 
-
+  std::lock_guard<std::mutex> lock (mutex_);
   if ((int)(cloud->width * cloud->height) < k_)
   {
     RCLCPP_ERROR (this->get_logger(), "[input_surface_indices_callback] Requested number of k-nearest neighbors (%d) is larger than the PointCloud size (%d)!", k_, (int)(cloud->width * cloud->height));
-    emptyPublish (cloud);
+    frame.dropped ("invalid_k");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
 
   // If indices given...
   IndicesPtr vindices;
   if (indices && !indices->header.frame_id.empty ())
-    vindices.reset (new std::vector<int> (indices->indices));
-
-  computePublish (cloud, cloud_surface, vindices);
+    vindices = indicesFromMsg (indices);
+
+  // Use a smaller neighborhood when over the processing budget
+  quality_level_ = qualityLevel ();
+  const auto start = std::chrono::steady_clock::now ();
+  PointCloudInConstPtr cloud_in, surface_in;
+  prepareInputs (cloud, surface, cloud_in, surface_in);
+  const size_t nr_points = vindices ? vindices->size () : cloud->width * cloud->height;
+  frame.startCompute (nr_points);
+  computePublish (cloud_in, surface_in, vindices);
+  // One feature per input point
+  frame.endCompute (nr_points);
+  frame.published ();
+  updateQuality (quality_level_, std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ());
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -253,48 +387,131 @@ pcl_ros::Feature::input_surface_indices_callback (const PointCloudInConstPtr &cl
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-pcl_ros::FeatureFromNormals::FeatureFromNormals (std::string node_name, const rclcpp::NodeOptions& options) : Feature(node_name, options), normals_()
+pcl_ros::FeatureFromNormals::FeatureFromNormals (std::string node_name, const rclcpp::NodeOptions& options)
+: Feature(node_name, options), normals_()
 {
-  // Allow each individual class that inherits from us to declare their own Publisher
-  // This is useful for Publisher<pcl::PointCloud<T> >, as NormalEstimation can publish PointCloud<Normal>, etc
-  //pub_output_ = this->template advertise<PointCloud2> ("output", max_queue_size_);
-
-  // ---[ Mandatory parameters
-  if (!this->get_parameter ("k_search", k_) && !this->get_parameter ("radius_search", search_radius_))
-  {
-    RCLCPP_ERROR (this->get_logger(), "[%s::onConstructor] Neither 'k_search' nor 'radius_search' set! Need to set at least one of these parameters before continuing.", this->get_name ());
-    return;
+  rcl_interfaces::msg::ParameterDescriptor keypoint_method_desc;
+  keypoint_method_desc.name = "keypoint_method";
+  keypoint_method_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  keypoint_method_desc.description = "Compute the descriptors at keypoints only: none (every input point), uniform_sampling, voxel_centroid or iss3d.";
+  declare_parameter (keypoint_method_desc.name, rclcpp::ParameterValue(keypoint_method_), keypoint_method_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor keypoint_radius_desc;
+  keypoint_radius_desc.name = "keypoint_radius";
+  keypoint_radius_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  keypoint_radius_desc.description = "Voxel size of uniform_sampling and voxel_centroid, salient radius of iss3d.";
+  rcl_interfaces::msg::FloatingPointRange keypoint_radius_range;
+  keypoint_radius_range.from_value = 0.001;
+  keypoint_radius_range.to_value = 10.0;
+  keypoint_radius_desc.floating_point_range.push_back (keypoint_radius_range);
+  declare_parameter (keypoint_radius_desc.name, rclcpp::ParameterValue(keypoint_radius_), keypoint_radius_desc);
+
+  pub_keypoints_ = this->create_publisher<PointIndices> ("keypoints", outputQoS ());
+
+  keypoints_callback_handle_ = add_on_set_parameters_callback (std::bind (&FeatureFromNormals::keypoints_callback, this, std::placeholders::_1));
+
+  std::vector<std::string> param_names{
+    keypoint_method_desc.name,
+    keypoint_radius_desc.name,
+  };
+  auto result = keypoints_callback (get_parameters (param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
   }
-  if (!this->get_parameter ("spatial_locator", spatial_locator_type_))
+
+  rcl_interfaces::msg::ParameterDescriptor point_normals_desc;
+  point_normals_desc.name = "point_normals";
+  point_normals_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  point_normals_desc.description = "Receive the points and normals bundled in one pcl::PointNormal cloud on the input topic (no synchronization, no surface).";
+  point_normals_desc.read_only = true;
+  point_normals_ = declare_parameter (point_normals_desc.name, point_normals_, point_normals_desc);
+  if (point_normals_ && use_surface_)
+    RCLCPP_WARN (get_logger(), "The surface is not used with point_normals, the neighbors are searched in the input.");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::FeatureFromNormals::keypoints_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  for (const rclcpp::Parameter &param : params)
   {
-    RCLCPP_ERROR (this->get_logger(), "[%s::onConstructor] Need a 'spatial_locator' parameter to be set before continuing!", this->get_name ());
-    return;
+    if (param.get_name () == "keypoint_method")
+    {
+      const std::string &method = param.as_string ();
+      if (method != "none" && method != "uniform_sampling" && method != "voxel_centroid" && method != "iss3d")
+      {
+        result.successful = false;
+        result.reason = "Invalid keypoint_method '" + method + "', expected 'none', 'uniform_sampling', 'voxel_centroid' or 'iss3d'.";
+        return result;
+      }
+      if (keypoint_method_ != method)
+      {
+        keypoint_method_ = method;
+        RCLCPP_DEBUG (get_logger(), "Setting the keypoint selection method to: %s.", keypoint_method_.c_str ());
+      }
+    }
+    if (param.get_name () == "keypoint_radius")
+    {
+      if (keypoint_radius_ != param.as_double ())
+      {
+        keypoint_radius_ = param.as_double ();
+        RCLCPP_DEBUG (get_logger(), "Setting the keypoint radius to: %f.", keypoint_radius_);
+      }
+    }
   }
-  // ---[ Optional parameters
-  this->get_parameter ("use_surface", use_surface_);
-
-  RCLCPP_DEBUG (this->get_logger(), "[%s::onConstructor] Node successfully created with the following parameters:\n"
-                 " - use_surface    : %s\n"
-                 " - k_search       : %d\n"
-                 " - radius_search  : %f\n"
-                 " - spatial_locator: %d",
-                this->get_name (),
-                 (use_surface_) ? "true" : "false", k_, search_radius_, spatial_locator_type_);
+  return result;
+}
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::Feature::IndicesPtr
+pcl_ros::FeatureFromNormals::selectKeypoints (const PointCloudInConstPtr &cloud, const PointCloudInConstPtr &surface,
+                                              const IndicesPtr &indices)
+{
+  IndicesPtr keypoints (new std::vector<int>);
+  if (keypoint_method_ == "iss3d")
+    issKeypoints (cloud, surface, indices, keypoint_radius_, *keypoints);
+  else
+    voxelKeypoints (*cloud, indices.get (), static_cast<float> (keypoint_radius_), keypoint_method_ == "voxel_centroid",
+                    *keypoints);
+  return (keypoints);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl_ros::FeatureFromNormals::subscribe ()
 {
-  sub_input_filter_.subscribe (this->shared_from_this (), "input");
-  sub_normals_filter_.subscribe (this->shared_from_this (), "normals");
+  // A single bundled input: nothing to synchronize, the latest indices are used
+  if (point_normals_)
+  {
+    if (use_indices_)
+    {
+      sub_indices_ = this->create_subscription<PointIndices> ("indices", indicesQoS (),
+          [this] (const PointIndicesConstPtr indices)
+          {
+            std::lock_guard<std::mutex> lock (latest_indices_mutex_);
+            latest_indices_ = indices;
+          });
+    }
+
+    // Workaround ros2/rclcpp#766
+    std::function<void(PointCloud2::ConstSharedPtr)> callback =
+        std::bind (&FeatureFromNormals::input_point_normals_callback, this, std::placeholders::_1);
+    sub_input_ = this->create_subscription<PointCloud2> ("input", cloudQoS (), callback);
+    return;
+  }
+
+  sub_input_filter_.subscribe (this, "input", cloudQoS ().get_rmw_qos_profile ());
+  sub_normals_filter_.subscribe (this, "normals", cloudQoS ().get_rmw_qos_profile ());
 
   // Create the objects here
   if (approximate_sync_)
-    sync_input_normals_surface_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > (max_queue_size_);
+    sync_input_normals_surface_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointCloud2, PointCloud2, PointIndices> > > (inputQueueSize ());
   else
-    sync_input_normals_surface_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > (max_queue_size_);
+    sync_input_normals_surface_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointCloud2, PointCloud2, PointIndices> > > (inputQueueSize ());
 
   // If we're supposed to look for PointIndices (indices) or PointCloud (surface) messages
   if (use_indices_ || use_surface_)
@@ -302,11 +519,11 @@ pcl_ros::FeatureFromNormals::subscribe ()
     if (use_indices_)
     {
       // If indices are enabled, subscribe to the indices
-      sub_indices_filter_.subscribe (this->shared_from_this(), "indices");
+      sub_indices_filter_.subscribe (this, "indices", indicesQoS ().get_rmw_qos_profile ());
       if (use_surface_)     // Use both indices and surface
       {
         // If surface is enabled, subscribe to the surface, connect the input-indices-surface trio and register
-        sub_surface_filter_.subscribe (this->shared_from_this (), "surface");
+        sub_surface_filter_.subscribe (this, "surface", cloudQoS ().get_rmw_qos_profile ());
         if (approximate_sync_)
           sync_input_normals_surface_indices_a_->connectInput (sub_input_filter_, sub_normals_filter_, sub_surface_filter_, sub_indices_filter_);
         else
@@ -326,7 +543,7 @@ pcl_ros::FeatureFromNormals::subscribe ()
     else                    // Use only surface
     {
       // indices not enabled, connect the input-surface duo and register
-      sub_surface_filter_.subscribe (this->shared_from_this (), "surface");
+      sub_surface_filter_.subscribe (this, "surface", cloudQoS ().get_rmw_qos_profile ());
 
       sub_input_filter_.registerCallback (std::bind (&FeatureFromNormals::input_callback, this, std::placeholders::_1));
       if (approximate_sync_)
@@ -356,6 +573,13 @@ pcl_ros::FeatureFromNormals::subscribe ()
 void
 pcl_ros::FeatureFromNormals::unsubscribe ()
 {
+  if (point_normals_)
+  {
+    sub_input_.reset ();
+    sub_indices_.reset ();
+    return;
+  }
+
   sub_input_filter_.unsubscribe ();
   sub_normals_filter_.unsubscribe ();
   if (use_indices_ || use_surface_)
@@ -374,29 +598,34 @@ pcl_ros::FeatureFromNormals::unsubscribe ()
 //////////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl_ros::FeatureFromNormals::input_normals_surface_indices_callback (
-   const PointCloudInConstPtr &cloud, const PointCloudNConstPtr &cloud_normals,
-   const PointCloudInConstPtr &cloud_surface, const PointIndicesConstPtr &indices)
+   const PointCloud2::ConstSharedPtr &cloud, const PointCloud2::ConstSharedPtr &cloud_normals,
+   const PointCloud2::ConstSharedPtr &cloud_surface, const PointIndicesConstPtr &indices)
 {
-  // No subscribers, no work
-  /*
-   count_subscribers not implemented ROS2
-  if (pub_output_.count_subscribers () <= 0)
+  NodeStatistics::Frame frame (statistics_.get ());
+
+  // Skip the frames that waited too long in the queue
+  if (isStale (cloud->header))
+  {
+    frame.dropped ("stale");
     return;
-  */
-  
+  }
+
   // If cloud+normals is given, check if it's valid
-  if (!isValid (cloud))// || !isValid (cloud_normals, "normals"))
+  if (!isValid (cloud) || !isValid (cloud_normals, "normals"))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_normals_surface_indices_callback] Invalid input!", this->get_name ());
-    emptyPublish (cloud);
+    frame.dropped ("invalid_input");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
 
   // If surface is given, check if it's valid
-  if (cloud_surface && !isValid (cloud_surface, "surface"))
+  const PointCloud2::ConstSharedPtr surface = optional (cloud_surface);
+  if (surface && !isValid (surface, "surface"))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_normals_surface_indices_callback] Invalid input surface!", this->get_name ());
-    emptyPublish (cloud);
+    frame.dropped ("invalid_surface");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
     
@@ -404,63 +633,94 @@ pcl_ros::FeatureFromNormals::input_normals_surface_indices_callback (
   if (indices && !isValid (indices))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_normals_surface_indices_callback] Invalid input indices!", this->get_name ());
-    emptyPublish (cloud);
+    frame.dropped ("invalid_indices");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
 
   /// DEBUG
-  if (cloud_surface)
-    if (indices)
-      RCLCPP_DEBUG (this->get_logger(), "[%s::input_normals_surface_indices_callback]\n"
-                     "                                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                                 - PointIndices with %zu values, stamp %f, and frame %s on topic %s received.",
-                     this->get_name (),
-                     cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                     cloud_surface->width * cloud_surface->height, pcl::getFieldsList (*cloud_surface).c_str (), fromPCL(cloud_surface->header).stamp.sec, cloud_surface->header.frame_id.c_str (), "surface",
-                     cloud_normals->width * cloud_normals->height, pcl::getFieldsList (*cloud_normals).c_str (), fromPCL(cloud_normals->header).stamp.sec, cloud_normals->header.frame_id.c_str (), "normals",
-                     indices->indices.size (), indices->header.stamp.sec, indices->header.frame_id.c_str (), "indices");
-    else
-      RCLCPP_DEBUG (this->get_logger(), "[%s::input_normals_surface_indices_callback]\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.",
-                     this->get_name (),
-                     cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                     cloud_surface->width * cloud_surface->height, pcl::getFieldsList (*cloud_surface).c_str (), fromPCL(cloud_surface->header).stamp.sec, cloud_surface->header.frame_id.c_str (), "surface",
-                     cloud_normals->width * cloud_normals->height, pcl::getFieldsList (*cloud_normals).c_str (), fromPCL(cloud_normals->header).stamp.sec, cloud_normals->header.frame_id.c_str (), "normals");
-  else
-    if (indices)
-      RCLCPP_DEBUG (this->get_logger(), "[%s::input_normals_surface_indices_callback]\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                         - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                         - PointIndices with %zu values, stamp %f, and frame %s on topic %s received.",
-                     this->get_name (),
-                     cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                     cloud_normals->width * cloud_normals->height, pcl::getFieldsList (*cloud_normals).c_str (), fromPCL(cloud_normals->header).stamp.sec, cloud_normals->header.frame_id.c_str (), "normals",
-                     indices->indices.size (), indices->header.stamp.sec, indices->header.frame_id.c_str (), "indices");
-    else
-      RCLCPP_DEBUG (this->get_logger(), "[%s::input_normals_surface_indices_callback]\n"
-                     "                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                     "                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.",
-                     this->get_name (),
-                     cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input",
-                     cloud_normals->width * cloud_normals->height, pcl::getFieldsList (*cloud_normals).c_str (), fromPCL(cloud_normals->header).stamp.sec, cloud_normals->header.frame_id.c_str (), "normals");
+  RCLCPP_DEBUG (this->get_logger(), "[%s::input_normals_surface_indices_callback]\n"
+                 "                                 - PointCloud with %d data points (%s), stamp %d, and frame %s on topic %s received.\n"
+                 "                                 - PointCloud with %d data points (%s), and frame %s on topic %s received.\n"
+                 "                                 - PointCloud with %d data points, and frame %s on topic %s received.\n"
+                 "                                 - PointIndices with %zu values, and frame %s on topic %s received.",
+                 this->get_name (),
+                 cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), cloud->header.stamp.sec, cloud->header.frame_id.c_str (), "input",
+                 cloud_normals->width * cloud_normals->height, pcl::getFieldsList (*cloud_normals).c_str (), cloud_normals->header.frame_id.c_str (), "normals",
+                 surface ? surface->width * surface->height : 0, surface ? surface->header.frame_id.c_str () : "", "surface",
+                 indices ? indices->indices.size () : 0, indices ? indices->header.frame_id.c_str () : "", "indices");
   ///
 
+  std::lock_guard<std::mutex> lock (mutex_);
   if ((int)(cloud->width * cloud->height) < k_)
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_normals_surface_indices_callback] Requested number of k-nearest neighbors (%d) is larger than the PointCloud size (%d)!", this->get_name (), k_, (int)(cloud->width * cloud->height));
-    emptyPublish (cloud);
+    frame.dropped ("invalid_k");
+    emptyPublish (emptyCloud (*cloud));
     return;
   }
 
   // If indices given...
   IndicesPtr vindices;
   if (indices && !indices->header.frame_id.empty ())
-    vindices.reset (new std::vector<int> (indices->indices));
+    vindices = indicesFromMsg (indices);
+
+  // Use a smaller neighborhood when over the processing budget
+  quality_level_ = qualityLevel ();
+  const auto start = std::chrono::steady_clock::now ();
+  PointCloudInConstPtr cloud_in, surface_in;
+  prepareInputs (cloud, surface, cloud_in, surface_in);
+  PointCloudNPtr normals (new PointCloudN);
+  pcl::fromROSMsg (*cloud_normals, *normals);
+
+  // Describe the keypoints only, published along with the descriptors
+  if (keypoint_method_ != "none")
+  {
+    vindices = selectKeypoints (cloud_in, surface_in, vindices);
+    auto keypoints = std::make_unique<PointIndices> ();
+    keypoints->header = cloud->header;
+    keypoints->indices = *vindices;
+    pub_keypoints_->publish (std::move (keypoints));
+  }
 
-  computePublish (cloud, cloud_normals, cloud_surface, vindices);
+  const size_t nr_points = vindices ? vindices->size () : cloud->width * cloud->height;
+  frame.startCompute (nr_points);
+  computePublish (cloud_in, normals, surface_in, vindices);
+  // One feature per input point
+  frame.endCompute (nr_points);
+  frame.published ();
+  updateQuality (quality_level_, std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ());
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::FeatureFromNormals::input_point_normals_callback (const PointCloud2::ConstSharedPtr &cloud)
+{
+  PointIndicesConstPtr indices;
+  if (use_indices_)
+  {
+    {
+      std::lock_guard<std::mutex> lock (latest_indices_mutex_);
+      indices = latest_indices_;
+    }
+    if (!indices)
+    {
+      RCLCPP_WARN_THROTTLE (this->get_logger(), *this->get_clock(), 5000, "No indices received yet, dropping the input clouds.");
+      NodeStatistics::Frame frame (statistics_.get ());
+      frame.dropped ("no_indices");
+      return;
+    }
+  }
+
+  if (pcl::getFieldIndex (*cloud, "normal_x") == -1)
+  {
+    RCLCPP_ERROR (this->get_logger(), "[%s::input_point_normals_callback] The input has no normals (%s)!", this->get_name (), pcl::getFieldsList (*cloud).c_str ());
+    NodeStatistics::Frame frame (statistics_.get ());
+    frame.dropped ("invalid_input");
+    emptyPublish (emptyCloud (*cloud));
+    return;
+  }
+
+  // The same message holds the points and the normals, each converted by field name
+  input_normals_surface_indices_callback (cloud, cloud, nullptr, indices);
+}
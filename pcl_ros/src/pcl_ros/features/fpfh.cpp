@@ -36,12 +36,18 @@
  */
 
 #include "pcl_ros/features/fpfh.hpp"
+
+pcl_ros::FPFHEstimation::FPFHEstimation (const rclcpp::NodeOptions& options) : FeatureFromNormals("FPFHEstimationNode", options)
+{
+  subscribe ();
+}
+
 void 
 pcl_ros::FPFHEstimation::emptyPublish (const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishOutput (output);
 }
 
 void 
@@ -51,13 +57,14 @@ pcl_ros::FPFHEstimation::computePublish (const PointCloudInConstPtr &cloud,
                                          const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch (k_);
-  impl_.setRadiusSearch (search_radius_);
+  impl_.setKSearch (searchK ());
+  impl_.setRadiusSearch (searchRadius ());
 
   // Set the inputs
   impl_.setInputCloud (cloud);
   impl_.setIndices (indices);
   impl_.setSearchSurface (surface);
+  impl_.setSearchMethod (tree_);
   impl_.setInputNormals (normals);
   // Estimate the feature
   PointCloudOut output;
@@ -66,7 +73,7 @@ pcl_ros::FPFHEstimation::computePublish (const PointCloudInConstPtr &cloud,
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishOutput (output);
 }
 
 typedef pcl_ros::FPFHEstimation FPFHEstimation;
@@ -0,0 +1,217 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <pcl/common/io.h>
+#include "pcl_ros/features/integral_image_normal.hpp"
+
+pcl_ros::IntegralImageNormalEstimation::IntegralImageNormalEstimation (const rclcpp::NodeOptions& options)
+: Feature("IntegralImageNormalEstimationNode", options)
+{
+  declareOutputPointNormals ();
+
+  rcl_interfaces::msg::ParameterDescriptor method_desc;
+  method_desc.name = "normal_estimation_method";
+  method_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  method_desc.description = "Normal estimation method of organized clouds: covariance_matrix, average_3d_gradient or average_depth_change.";
+  declare_parameter (method_desc.name, rclcpp::ParameterValue("average_3d_gradient"), method_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor border_policy_desc;
+  border_policy_desc.name = "border_policy";
+  border_policy_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  border_policy_desc.description = "Handling of the image borders: ignore (no normals) or mirror.";
+  declare_parameter (border_policy_desc.name, rclcpp::ParameterValue("ignore"), border_policy_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor depth_smoothing_desc;
+  depth_smoothing_desc.name = "depth_dependent_smoothing";
+  depth_smoothing_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  depth_smoothing_desc.description = "Grow the smoothing area with the depth of the points.";
+  declare_parameter (depth_smoothing_desc.name, rclcpp::ParameterValue(false), depth_smoothing_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor depth_change_desc;
+  depth_change_desc.name = "max_depth_change_factor";
+  depth_change_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  depth_change_desc.description = "Depth change, relative to the depth, above which neighboring pixels are not smoothed together (object borders).";
+  rcl_interfaces::msg::FloatingPointRange depth_change_range;
+  depth_change_range.from_value = 0.0;
+  depth_change_range.to_value = 1.0;
+  depth_change_desc.floating_point_range.push_back (depth_change_range);
+  declare_parameter (depth_change_desc.name, rclcpp::ParameterValue(0.02), depth_change_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor smoothing_size_desc;
+  smoothing_size_desc.name = "normal_smoothing_size";
+  smoothing_size_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  smoothing_size_desc.description = "Size of the area, in pixels, used to smooth the normals.";
+  rcl_interfaces::msg::FloatingPointRange smoothing_size_range;
+  smoothing_size_range.from_value = 1.0;
+  smoothing_size_range.to_value = 100.0;
+  smoothing_size_desc.floating_point_range.push_back (smoothing_size_range);
+  declare_parameter (smoothing_size_desc.name, rclcpp::ParameterValue(10.0), smoothing_size_desc);
+
+  integral_callback_handle_ = add_on_set_parameters_callback (std::bind (&IntegralImageNormalEstimation::integral_callback, this, std::placeholders::_1));
+
+  std::vector<std::string> param_names{
+    method_desc.name,
+    border_policy_desc.name,
+    depth_smoothing_desc.name,
+    depth_change_desc.name,
+    smoothing_size_desc.name,
+  };
+  auto result = integral_callback (get_parameters (param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
+
+  subscribe ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::IntegralImageNormalEstimation::integral_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+
+  // Validate the whole set first, so that a rejected set leaves the configuration untouched
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "normal_estimation_method")
+    {
+      const std::string &method = param.as_string ();
+      if (method != "covariance_matrix" && method != "average_3d_gradient" && method != "average_depth_change")
+      {
+        result.successful = false;
+        result.reason = "Invalid normal_estimation_method '" + method + "', expected 'covariance_matrix', 'average_3d_gradient' or 'average_depth_change'.";
+        return result;
+      }
+    }
+    else if (param.get_name () == "border_policy")
+    {
+      const std::string &policy = param.as_string ();
+      if (policy != "ignore" && policy != "mirror")
+      {
+        result.successful = false;
+        result.reason = "Invalid border_policy '" + policy + "', expected 'ignore' or 'mirror'.";
+        return result;
+      }
+    }
+  }
+
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "normal_estimation_method")
+    {
+      const std::string &method = param.as_string ();
+      if (method == "covariance_matrix")
+        impl_.setNormalEstimationMethod (impl_.COVARIANCE_MATRIX);
+      else if (method == "average_3d_gradient")
+        impl_.setNormalEstimationMethod (impl_.AVERAGE_3D_GRADIENT);
+      else
+        impl_.setNormalEstimationMethod (impl_.AVERAGE_DEPTH_CHANGE);
+      RCLCPP_DEBUG (get_logger(), "Setting the normal estimation method to: %s.", method.c_str ());
+    }
+    else if (param.get_name () == "border_policy")
+    {
+      const std::string &policy = param.as_string ();
+      impl_.setBorderPolicy (policy == "ignore" ? impl_.BORDER_POLICY_IGNORE : impl_.BORDER_POLICY_MIRROR);
+      RCLCPP_DEBUG (get_logger(), "Setting the border policy to: %s.", policy.c_str ());
+    }
+    else if (param.get_name () == "depth_dependent_smoothing")
+    {
+      impl_.setDepthDependentSmoothing (param.as_bool ());
+      RCLCPP_DEBUG (get_logger(), "Setting the depth dependent smoothing to: %s.", param.as_bool () ? "true" : "false");
+    }
+    else if (param.get_name () == "max_depth_change_factor")
+    {
+      impl_.setMaxDepthChangeFactor (static_cast<float> (param.as_double ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the maximum depth change factor to: %f.", param.as_double ());
+    }
+    else if (param.get_name () == "normal_smoothing_size")
+    {
+      impl_.setNormalSmoothingSize (static_cast<float> (param.as_double ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the normal smoothing size to: %f.", param.as_double ());
+    }
+  }
+  return result;
+}
+
+void
+pcl_ros::IntegralImageNormalEstimation::emptyPublish (const PointCloudInConstPtr &cloud)
+{
+  PointCloudOut output;
+  output.header = cloud->header;
+  publishNormals (cloud, IndicesPtr (), output);
+}
+
+void
+pcl_ros::IntegralImageNormalEstimation::computePublish (const PointCloudInConstPtr &cloud,
+                                                        const PointCloudInConstPtr &surface,
+                                                        const IndicesPtr &indices)
+{
+  PointCloudOut output;
+  if (cloud->isOrganized () && !surface)
+  {
+    // The integral images cover the whole image, the normals of the indices are picked afterwards
+    impl_.setInputCloud (cloud);
+    if (!indices)
+      impl_.compute (output);
+    else
+    {
+      PointCloudOut normals;
+      impl_.compute (normals);
+      pcl::copyPointCloud (normals, *indices, output);
+    }
+  }
+  else
+  {
+    // Unorganized: fall back to the kd-tree search
+    search_impl_.setKSearch (searchK ());
+    search_impl_.setRadiusSearch (searchRadius ());
+    search_impl_.setInputCloud (cloud);
+    search_impl_.setIndices (indices);
+    search_impl_.setSearchSurface (surface);
+    search_impl_.setSearchMethod (tree_);
+    search_impl_.compute (output);
+  }
+
+  // Enforce that the TF frame and the timestamp are copied
+  output.header = cloud->header;
+  publishNormals (cloud, indices, output);
+}
+
+typedef pcl_ros::IntegralImageNormalEstimation IntegralImageNormalEstimation;
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(IntegralImageNormalEstimation)
@@ -0,0 +1,125 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <Eigen/Core>
+
+#include <pcl/common/point_tests.h>
+#include <pcl/keypoints/iss_3d.h>
+
+#include "pcl_ros/features/keypoints.hpp"
+#include "pcl_ros/filters/voxel_hash.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::voxelKeypoints (const pcl::PointCloud<pcl::PointXYZ> &cloud, const std::vector<int> *indices,
+                         float leaf_size, bool centroid, std::vector<int> &keypoints)
+{
+  keypoints.clear ();
+  const size_t nr_points = indices ? indices->size () : cloud.points.size ();
+  const float inverse_leaf_size[3] = {1.0f / leaf_size, 1.0f / leaf_size, 1.0f / leaf_size};
+
+  // First pass: the voxel of each point, and the reference position of each voxel
+  VoxelHashMap voxels (nr_points / 8 + 16);
+  const uint32_t npos = VoxelHashMap::npos;
+  std::vector<uint32_t> voxel_ids (nr_points, npos);
+  std::vector<Eigen::Vector4d> references;
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const pcl::PointXYZ &p = cloud.points[indices ? (*indices)[i] : i];
+    VoxelKey key;
+    if (!pcl::isFinite (p) || !computeVoxelKey (p.x, p.y, p.z, inverse_leaf_size, key))
+      continue;
+    bool inserted;
+    const uint32_t id = voxels.insert (key, inserted);
+    if (inserted)
+    {
+      // Uniform sampling uses the center of the voxel, that the count (w) leaves untouched
+      references.emplace_back (centroid ? Eigen::Vector4d::Zero () :
+                               Eigen::Vector4d ((key.x + 0.5) * leaf_size, (key.y + 0.5) * leaf_size,
+                                                (key.z + 0.5) * leaf_size, 1.0));
+    }
+    if (centroid)
+      references[id] += Eigen::Vector4d (p.x, p.y, p.z, 1.0);
+    voxel_ids[i] = id;
+  }
+  if (centroid)
+    for (Eigen::Vector4d &reference : references)
+      reference /= reference[3];
+
+  // Second pass: the point nearest to the reference position of its voxel
+  std::vector<int> nearest (references.size (), -1);
+  std::vector<double> nearest_distances (references.size (), std::numeric_limits<double>::max ());
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const uint32_t id = voxel_ids[i];
+    if (id == VoxelHashMap::npos)
+      continue;
+    const int index = indices ? (*indices)[i] : static_cast<int> (i);
+    const pcl::PointXYZ &p = cloud.points[index];
+    const double distance = (Eigen::Vector3d (p.x, p.y, p.z) - references[id].head<3> ()).squaredNorm ();
+    if (distance < nearest_distances[id])
+    {
+      nearest_distances[id] = distance;
+      nearest[id] = index;
+    }
+  }
+
+  keypoints.swap (nearest);
+  std::sort (keypoints.begin (), keypoints.end ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::issKeypoints (const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &cloud,
+                       const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &surface,
+                       const std::shared_ptr<std::vector<int> > &indices, double salient_radius,
+                       std::vector<int> &keypoints)
+{
+  pcl::ISSKeypoint3D<pcl::PointXYZ, pcl::PointXYZ> impl;
+  impl.setSalientRadius (salient_radius);
+  impl.setNonMaxRadius (salient_radius * 2.0 / 3.0);
+  impl.setMinNeighbors (5);
+  impl.setInputCloud (cloud);
+  impl.setIndices (indices);
+  if (surface)
+    impl.setSearchSurface (surface);
+
+  pcl::PointCloud<pcl::PointXYZ> points;
+  impl.compute (points);
+  const pcl::PointIndicesConstPtr selected = impl.getKeypointsIndices ();
+  keypoints.assign (selected->indices.begin (), selected->indices.end ());
+}
@@ -42,7 +42,7 @@ pcl_ros::MomentInvariantsEstimation::emptyPublish (const PointCloudInConstPtr &c
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishOutput (output);
 }
 
 void 
@@ -51,13 +51,14 @@ pcl_ros::MomentInvariantsEstimation::computePublish (const PointCloudInConstPtr
                                                      const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch (k_);
-  impl_.setRadiusSearch (search_radius_);
+  impl_.setKSearch (searchK ());
+  impl_.setRadiusSearch (searchRadius ());
 
   // Set the inputs
   impl_.setInputCloud (cloud);
   impl_.setIndices (indices);
   impl_.setSearchSurface (surface);
+  impl_.setSearchMethod (tree_);
   // Estimate the feature
   PointCloudOut output;
   impl_.compute (output);
@@ -65,7 +66,7 @@ pcl_ros::MomentInvariantsEstimation::computePublish (const PointCloudInConstPtr
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishOutput (output);
 }
 
 typedef pcl_ros::MomentInvariantsEstimation MomentInvariantsEstimation;
@@ -37,12 +37,93 @@
 
 #include "pcl_ros/features/normal_3d.hpp"
 
+pcl_ros::NormalEstimation::NormalEstimation (const rclcpp::NodeOptions& options) : Feature("NormalEstimationNode", options)
+{
+  declareOutputPointNormals ();
+
+  rcl_interfaces::msg::ParameterDescriptor cache_desc;
+  cache_desc.name = "normal_cache";
+  cache_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  cache_desc.description = "Reuse the normals of the regions of a quasi-static scene that did not change since the previous frame.";
+  declare_parameter (cache_desc.name, rclcpp::ParameterValue(use_normal_cache_), cache_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor leaf_size_desc;
+  leaf_size_desc.name = "normal_cache_leaf_size";
+  leaf_size_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  leaf_size_desc.description = "Voxel size of the normal cache, at least the extent of the neighborhood of the normals.";
+  rcl_interfaces::msg::FloatingPointRange leaf_size_range;
+  leaf_size_range.from_value = 0.01;
+  leaf_size_range.to_value = 10.0;
+  leaf_size_desc.floating_point_range.push_back (leaf_size_range);
+  declare_parameter (leaf_size_desc.name, rclcpp::ParameterValue(0.1), leaf_size_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor tolerance_desc;
+  tolerance_desc.name = "normal_cache_tolerance";
+  tolerance_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  tolerance_desc.description = "Distance the centroid of the points around a voxel can move by and still reuse its normals.";
+  rcl_interfaces::msg::FloatingPointRange tolerance_range;
+  tolerance_range.from_value = 0.0;
+  tolerance_range.to_value = 1.0;
+  tolerance_desc.floating_point_range.push_back (tolerance_range);
+  declare_parameter (tolerance_desc.name, rclcpp::ParameterValue(0.01), tolerance_desc);
+
+  pub_reused_normals_ = this->create_publisher<std_msgs::msg::Float32> ("~/reused_normals", 1);
+
+  cache_callback_handle_ = add_on_set_parameters_callback (std::bind (&NormalEstimation::cache_callback, this, std::placeholders::_1));
+
+  std::vector<std::string> param_names{
+    cache_desc.name,
+    leaf_size_desc.name,
+    tolerance_desc.name,
+  };
+  auto result = cache_callback (get_parameters (param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
+
+  subscribe ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::NormalEstimation::cache_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "normal_cache")
+    {
+      if (use_normal_cache_ != param.as_bool ())
+      {
+        use_normal_cache_ = param.as_bool ();
+        normal_cache_.clear ();
+        RCLCPP_DEBUG (get_logger(), "Setting the normal cache to: %s.", (use_normal_cache_) ? "true" : "false");
+      }
+    }
+    if (param.get_name () == "normal_cache_leaf_size")
+    {
+      normal_cache_.setLeafSize (static_cast<float> (param.as_double ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the normal cache leaf size to: %f.", param.as_double ());
+    }
+    if (param.get_name () == "normal_cache_tolerance")
+    {
+      normal_cache_.setTolerance (static_cast<float> (param.as_double ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the normal cache tolerance to: %f.", param.as_double ());
+    }
+  }
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  return result;
+}
+
 void 
 pcl_ros::NormalEstimation::emptyPublish (const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishNormals (cloud, IndicesPtr (), output);
 }
 
 void 
@@ -51,21 +132,44 @@ pcl_ros::NormalEstimation::computePublish (const PointCloudInConstPtr &cloud,
                                            const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch (k_);
-  impl_.setRadiusSearch (search_radius_);
+  impl_.setKSearch (searchK ());
+  impl_.setRadiusSearch (searchRadius ());
 
   // Set the inputs
   impl_.setInputCloud (cloud);
-  impl_.setIndices (indices);
   impl_.setSearchSurface (surface);
-  // Estimate the feature
+  impl_.setSearchMethod (tree_);
   PointCloudOut output;
-  impl_.compute (output);
+  if (use_normal_cache_ && !indices && !surface)
+  {
+    // Only estimate the normals of the changed regions, searching the whole cloud
+    IndicesPtr changed (new std::vector<int>);
+    const size_t nr_reused = normal_cache_.lookup (*cloud, output, *changed);
+    if (!changed->empty ())
+    {
+      PointCloudOut changed_normals;
+      impl_.setIndices (changed);
+      impl_.compute (changed_normals);
+      for (size_t i = 0; i < changed->size (); ++i)
+        output.points[(*changed)[i]] = changed_normals.points[i];
+    }
+    normal_cache_.update (*cloud, output);
+
+    std_msgs::msg::Float32 reused;
+    reused.data = cloud->points.empty () ? 0.0f : static_cast<float> (nr_reused) / cloud->points.size ();
+    pub_reused_normals_->publish (reused);
+  }
+  else
+  {
+    // Estimate the feature
+    impl_.setIndices (indices);
+    impl_.compute (output);
+  }
 
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishNormals (cloud, indices, output);
 }
 
 typedef pcl_ros::NormalEstimation NormalEstimation;
@@ -38,12 +38,56 @@
 #include "pcl_ros/features/normal_3d_omp.hpp"
 #include "pcl_ros/ptr_helper.hpp"
 
+pcl_ros::NormalEstimationOMP::NormalEstimationOMP (const rclcpp::NodeOptions& options) : Feature("NormalEstimationOMPNode", options)
+{
+  declareOutputPointNormals ();
+
+  rcl_interfaces::msg::ParameterDescriptor num_threads_desc;
+  num_threads_desc.name = "num_threads";
+  num_threads_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  num_threads_desc.description = "Number of OpenMP threads to compute the feature with, 0 for the number of cores.";
+  rcl_interfaces::msg::IntegerRange num_threads_range;
+  num_threads_range.from_value = 0;
+  num_threads_range.to_value = 64;
+  num_threads_desc.integer_range.push_back (num_threads_range);
+  declare_parameter (num_threads_desc.name, rclcpp::ParameterValue(0), num_threads_desc);
+
+  threads_callback_handle_ = add_on_set_parameters_callback (std::bind (&NormalEstimationOMP::threads_callback, this, std::placeholders::_1));
+  auto result = threads_callback (get_parameters (std::vector<std::string>{num_threads_desc.name}));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
+
+  subscribe ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::NormalEstimationOMP::threads_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "num_threads")
+    {
+      // 0 lets PCL use all the cores
+      impl_.setNumberOfThreads (static_cast<unsigned int> (param.as_int ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the number of OpenMP threads to: %ld.", param.as_int ());
+    }
+  }
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  return result;
+}
+
 void 
 pcl_ros::NormalEstimationOMP::emptyPublish (const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishNormals (cloud, IndicesPtr (), output);
 }
 
 void 
@@ -52,13 +96,14 @@ pcl_ros::NormalEstimationOMP::computePublish (const PointCloudInConstPtr &cloud,
                                               const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch (k_);
-  impl_.setRadiusSearch (search_radius_);
+  impl_.setKSearch (searchK ());
+  impl_.setRadiusSearch (searchRadius ());
 
   // Set the inputs
   impl_.setInputCloud (cloud);
   impl_.setIndices (indices);
   impl_.setSearchSurface (surface);
+  impl_.setSearchMethod (tree_);
   // Estimate the feature
   PointCloudOut output;
   impl_.compute (output);
@@ -66,7 +111,7 @@ pcl_ros::NormalEstimationOMP::computePublish (const PointCloudInConstPtr &cloud,
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish (output);
+  publishNormals (cloud, indices, output);
 }
 
 typedef pcl_ros::NormalEstimationOMP NormalEstimationOMP;
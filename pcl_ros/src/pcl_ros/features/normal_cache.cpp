@@ -0,0 +1,254 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <pcl/common/point_tests.h>
+
+#include "pcl_ros/features/normal_cache.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::NormalCache::unchanged (const VoxelKey &key) const
+{
+  // Compare the 3x3x3 blocks around the voxel, insensitive to the points moving between the voxels of the block
+  int64_t current_count = 0, previous_count = 0;
+  Eigen::Vector3d current_sum = Eigen::Vector3d::Zero (), previous_sum = Eigen::Vector3d::Zero ();
+  for (int dx = -1; dx <= 1; ++dx)
+    for (int dy = -1; dy <= 1; ++dy)
+      for (int dz = -1; dz <= 1; ++dz)
+      {
+        const VoxelKey neighbor = {key.x + dx, key.y + dy, key.z + dz};
+        uint32_t id = current_map_.find (neighbor);
+        if (id != VoxelHashMap::npos)
+        {
+          current_count += current_[id].count;
+          current_sum += current_[id].sum.cast<double> ();
+        }
+        id = previous_map_.find (neighbor);
+        if (id != VoxelHashMap::npos)
+        {
+          previous_count += previous_[id].count;
+          previous_sum += previous_[id].sum.cast<double> ();
+        }
+      }
+  if (previous_count == 0 || current_count == 0)
+    return (false);
+
+  // Within 3 sigma of the sampling noise of the count, sqrt (n) (see the class documentation)
+  const int64_t count_change = current_count - previous_count;
+  const Eigen::Vector3d shift = current_sum / static_cast<double> (current_count) -
+                                previous_sum / static_cast<double> (previous_count);
+  return (count_change * count_change <= 9 * previous_count && shift.squaredNorm () <= tolerance_ * tolerance_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl_ros::NormalCache::nearest (const Voxel &voxel, const Eigen::Vector3f &p)
+{
+  const int axis = voxel.axis;
+  const std::vector<pcl::PointXYZ> &points = voxel.points;
+  size_t upper = std::lower_bound (points.begin (), points.end (), p[axis],
+                                   [axis] (const pcl::PointXYZ &q, float value) { return (q.data[axis] < value); }) -
+                 points.begin ();
+  size_t lower = upper;
+  size_t best = upper < points.size () ? upper : upper - 1;
+  float best_distance = (points[best].getVector3fMap () - p).squaredNorm ();
+  // Stop on each side once the distance along the axis alone is larger than the best distance
+  while (upper < points.size () || lower > 0)
+  {
+    if (upper < points.size ())
+    {
+      const float gap = points[upper].data[axis] - p[axis];
+      if (gap * gap < best_distance)
+      {
+        const float distance = (points[upper].getVector3fMap () - p).squaredNorm ();
+        if (distance < best_distance)
+        {
+          best_distance = distance;
+          best = upper;
+        }
+        ++upper;
+      }
+      else
+        upper = points.size ();
+    }
+    if (lower > 0)
+    {
+      const float gap = p[axis] - points[lower - 1].data[axis];
+      if (gap * gap < best_distance)
+      {
+        const float distance = (points[lower - 1].getVector3fMap () - p).squaredNorm ();
+        if (distance < best_distance)
+        {
+          best_distance = distance;
+          best = lower - 1;
+        }
+        --lower;
+      }
+      else
+        lower = 0;
+    }
+  }
+  return (best);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+size_t
+pcl_ros::NormalCache::lookup (const pcl::PointCloud<pcl::PointXYZ> &cloud, pcl::PointCloud<pcl::Normal> &normals,
+                              std::vector<int> &changed)
+{
+  const size_t nr_points = cloud.points.size ();
+  const float inverse_leaf_size[3] = {1.0f / leaf_size_, 1.0f / leaf_size_, 1.0f / leaf_size_};
+
+  // Bin the frame
+  current_map_.clear ();
+  current_.clear ();
+  const uint32_t npos = VoxelHashMap::npos;
+  point_voxels_.assign (nr_points, npos);
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const pcl::PointXYZ &p = cloud.points[i];
+    VoxelKey key;
+    if (!pcl::isFinite (p) || !computeVoxelKey (p.x, p.y, p.z, inverse_leaf_size, key))
+      continue;
+    bool inserted;
+    const uint32_t id = current_map_.insert (key, inserted);
+    if (inserted)
+    {
+      current_.emplace_back ();
+      current_.back ().key = key;
+    }
+    ++current_[id].count;
+    current_[id].sum += p.getVector3fMap ();
+    point_voxels_[i] = id;
+  }
+
+  // A voxel is reusable if it has points from the previous frame, and its neighborhood is unchanged
+  std::vector<uint32_t> reusable (current_.size (), npos);
+  for (size_t v = 0; v < current_.size (); ++v)
+  {
+    const uint32_t previous = previous_map_.find (current_[v].key);
+    if (previous != npos && unchanged (current_[v].key))
+      reusable[v] = previous;
+  }
+  // The same sensor: the pixels of the previous frame match those of this one
+  const bool same_pixels = cloud.height > 1 && cloud.width == previous_width_ && cloud.height == previous_height_;
+
+  // Copy the normal of the nearest previous point, or mark the point as changed
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  pcl::Normal invalid;
+  invalid.normal_x = invalid.normal_y = invalid.normal_z = invalid.curvature = nan;
+  normals.points.assign (nr_points, invalid);
+  normals.width = cloud.width;
+  normals.height = cloud.height;
+  normals.is_dense = false;
+  changed.clear ();
+  size_t nr_reused = 0;
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const uint32_t v = point_voxels_[i];
+    if (v == npos)
+      continue;
+    if (reusable[v] == npos)
+    {
+      changed.push_back (static_cast<int> (i));
+      continue;
+    }
+    const Voxel &previous = previous_[reusable[v]];
+    if (same_pixels && previous_point_voxels_[i] == reusable[v])
+      normals.points[i] = previous.normals[previous_point_slots_[i]];
+    else
+      normals.points[i] = previous.normals[nearest (previous, cloud.points[i].getVector3fMap ())];
+    ++nr_reused;
+  }
+  return (nr_reused);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::NormalCache::update (const pcl::PointCloud<pcl::PointXYZ> &cloud, const pcl::PointCloud<pcl::Normal> &normals)
+{
+  // Group the points by voxel (counting sort)
+  const uint32_t npos = VoxelHashMap::npos;
+  std::vector<uint32_t> begin (current_.size () + 1, 0);
+  for (size_t v = 0; v < current_.size (); ++v)
+    begin[v + 1] = begin[v] + current_[v].count;
+  std::vector<uint32_t> order (begin.back ());
+  {
+    std::vector<uint32_t> next (begin.begin (), begin.end () - 1);
+    for (size_t i = 0; i < point_voxels_.size (); ++i)
+    {
+      if (point_voxels_[i] != npos)
+        order[next[point_voxels_[i]]++] = static_cast<uint32_t> (i);
+    }
+  }
+
+  // Sort the points of each voxel along the axis they are the most spread on, for nearest ()
+  point_slots_.assign (point_voxels_.size (), 0);
+  for (size_t v = 0; v < current_.size (); ++v)
+  {
+    Voxel &voxel = current_[v];
+    const auto first = order.begin () + begin[v], last = order.begin () + begin[v + 1];
+    Eigen::Vector3f min_p = Eigen::Vector3f::Constant (std::numeric_limits<float>::max ());
+    Eigen::Vector3f max_p = -min_p;
+    for (auto it = first; it != last; ++it)
+    {
+      min_p = min_p.cwiseMin (cloud.points[*it].getVector3fMap ());
+      max_p = max_p.cwiseMax (cloud.points[*it].getVector3fMap ());
+    }
+    Eigen::Vector3f::Index axis;
+    (max_p - min_p).maxCoeff (&axis);
+    voxel.axis = static_cast<int> (axis);
+    std::sort (first, last, [&cloud, axis] (uint32_t a, uint32_t b)
+               { return (cloud.points[a].data[axis] < cloud.points[b].data[axis]); });
+
+    voxel.points.reserve (voxel.count);
+    voxel.normals.reserve (voxel.count);
+    for (auto it = first; it != last; ++it)
+    {
+      point_slots_[*it] = static_cast<uint32_t> (voxel.points.size ());
+      voxel.points.push_back (cloud.points[*it]);
+      voxel.normals.push_back (normals.points[*it]);
+    }
+  }
+  std::swap (previous_map_, current_map_);
+  std::swap (previous_, current_);
+  std::swap (previous_point_voxels_, point_voxels_);
+  std::swap (previous_point_slots_, point_slots_);
+  previous_width_ = cloud.width;
+  previous_height_ = cloud.height;
+}
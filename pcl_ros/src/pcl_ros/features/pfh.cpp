@@ -37,11 +37,16 @@
 
 #include "pcl_ros/features/pfh.hpp"
 
+pcl_ros::PFHEstimation::PFHEstimation(const rclcpp::NodeOptions &options) : FeatureFromNormals("PFHEstimationNode", options)
+{
+  subscribe ();
+}
+
 void pcl_ros::PFHEstimation::emptyPublish(const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 void pcl_ros::PFHEstimation::computePublish(const PointCloudInConstPtr &cloud,
@@ -50,13 +55,14 @@ void pcl_ros::PFHEstimation::computePublish(const PointCloudInConstPtr &cloud,
                                             const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch(k_);
-  impl_.setRadiusSearch(search_radius_);
+  impl_.setKSearch(searchK());
+  impl_.setRadiusSearch(searchRadius());
 
   // Set the inputs
   impl_.setInputCloud(cloud);
   impl_.setIndices(indices);
   impl_.setSearchSurface(surface);
+  impl_.setSearchMethod(tree_);
   impl_.setInputNormals(normals);
   // Estimate the feature
   PointCloudOut output;
@@ -65,7 +71,7 @@ void pcl_ros::PFHEstimation::computePublish(const PointCloudInConstPtr &cloud,
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 typedef pcl_ros::PFHEstimation PFHEstimation;
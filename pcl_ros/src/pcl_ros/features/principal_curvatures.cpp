@@ -35,14 +35,13 @@
  *
  */
 
-#include "class_loader/register_macro.hpp"
 #include "pcl_ros/features/principal_curvatures.hpp"
 
 void pcl_ros::PrincipalCurvaturesEstimation::emptyPublish(const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 void pcl_ros::PrincipalCurvaturesEstimation::computePublish(const PointCloudInConstPtr &cloud,
@@ -51,13 +50,14 @@ void pcl_ros::PrincipalCurvaturesEstimation::computePublish(const PointCloudInCo
                                                             const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch(k_);
-  impl_.setRadiusSearch(search_radius_);
+  impl_.setKSearch(searchK());
+  impl_.setRadiusSearch(searchRadius());
 
   // Set the inputs
   impl_.setInputCloud(cloud);
   impl_.setIndices(indices);
   impl_.setSearchSurface(surface);
+  impl_.setSearchMethod(tree_);
   impl_.setInputNormals(normals);
   // Estimate the feature
   PointCloudOut output;
@@ -66,7 +66,7 @@ void pcl_ros::PrincipalCurvaturesEstimation::computePublish(const PointCloudInCo
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 typedef pcl_ros::PrincipalCurvaturesEstimation PrincipalCurvaturesEstimation;
@@ -39,14 +39,14 @@
 
 pcl_ros::SHOTEstimation::SHOTEstimation(const rclcpp::NodeOptions &options) : FeatureFromNormals("SHOTEstimationNode", options)
 {
-  pub_output_ = this->create_publisher<PointCloudOut>("output", max_queue_size_);
+  subscribe ();
 }
 
 void pcl_ros::SHOTEstimation::emptyPublish(const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 void pcl_ros::SHOTEstimation::computePublish(const PointCloudInConstPtr &cloud,
@@ -55,13 +55,14 @@ void pcl_ros::SHOTEstimation::computePublish(const PointCloudInConstPtr &cloud,
                                              const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch(k_);
-  impl_.setRadiusSearch(search_radius_);
+  impl_.setKSearch(searchK());
+  impl_.setRadiusSearch(searchRadius());
 
   // Set the inputs
   impl_.setInputCloud(cloud);
   impl_.setIndices(indices);
   impl_.setSearchSurface(surface);
+  impl_.setSearchMethod(tree_);
   impl_.setInputNormals(normals);
   // Estimate the feature
   PointCloudOut output;
@@ -70,7 +71,7 @@ void pcl_ros::SHOTEstimation::computePublish(const PointCloudInConstPtr &cloud,
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 typedef pcl_ros::SHOTEstimation SHOTEstimation;
@@ -35,15 +35,19 @@
  *
  */
 
-#include "class_loader/register_macro.hpp"
 #include "pcl_ros/features/vfh.hpp"
 #include "pcl_ros/ptr_helper.hpp"
 
+pcl_ros::VFHEstimation::VFHEstimation(const rclcpp::NodeOptions &options) : FeatureFromNormals("VFHEstimationNode", options)
+{
+  subscribe ();
+}
+
 void pcl_ros::VFHEstimation::emptyPublish(const PointCloudInConstPtr &cloud)
 {
   PointCloudOut output;
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 void pcl_ros::VFHEstimation::computePublish(const PointCloudInConstPtr &cloud,
@@ -52,13 +56,14 @@ void pcl_ros::VFHEstimation::computePublish(const PointCloudInConstPtr &cloud,
                                             const IndicesPtr &indices)
 {
   // Set the parameters
-  impl_.setKSearch(k_);
-  impl_.setRadiusSearch(search_radius_);
+  impl_.setKSearch(searchK());
+  impl_.setRadiusSearch(searchRadius());
 
   // Set the inputs
   impl_.setInputCloud(cloud);
   impl_.setIndices(indices);
   impl_.setSearchSurface(surface);
+  impl_.setSearchMethod(tree_);
   impl_.setInputNormals(normals);
   // Estimate the feature
   PointCloudOut output;
@@ -67,7 +72,7 @@ void pcl_ros::VFHEstimation::computePublish(const PointCloudInConstPtr &cloud,
   // Publish a shared ptr const data
   // Enforce that the TF frame and the timestamp are copied
   output.header = cloud->header;
-  pub_output_->publish(output);
+  publishOutput(output);
 }
 
 typedef pcl_ros::VFHEstimation VFHEstimation;
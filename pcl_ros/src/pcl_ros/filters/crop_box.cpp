@@ -36,10 +36,18 @@
  *
  */
 
+#include <tf2/exceptions.h>
+#include "pcl_ros/transforms.hpp"
 #include "pcl_ros/filters/crop_box.hpp"
 
+namespace
+{
+  /** \brief How long to wait for the transformation to the box frame, in seconds. */
+  const double kBoxTransformTimeout = 0.1;
+}  // namespace
+
 pcl_ros::CropBox::CropBox(const rclcpp::NodeOptions & options)
-: Filter("CropBoxNode", options)
+: Filter("CropBoxNode", options, true)
 {
   rcl_interfaces::msg::ParameterDescriptor min_x_desc;
   min_x_desc.name = "min_x";
@@ -113,6 +121,24 @@ pcl_ros::CropBox::CropBox(const rclcpp::NodeOptions & options)
   neg_desc.description = "If True the box will be empty Else the remaining points will be the ones in the box";
   declare_parameter (neg_desc.name, rclcpp::ParameterValue(false), neg_desc);
 
+  rcl_interfaces::msg::ParameterDescriptor translation_desc;
+  translation_desc.name = "translation";
+  translation_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE_ARRAY;
+  translation_desc.description = "The position [x, y, z] of the box in the box frame (see box_frame). The minimum and maximum points are relative to this pose.";
+  declare_parameter (translation_desc.name, rclcpp::ParameterValue(std::vector<double>{0.0, 0.0, 0.0}), translation_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor rotation_desc;
+  rotation_desc.name = "rotation";
+  rotation_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE_ARRAY;
+  rotation_desc.description = "The orientation [roll, pitch, yaw] of the box in the box frame (see box_frame), in radians.";
+  declare_parameter (rotation_desc.name, rclcpp::ParameterValue(std::vector<double>{0.0, 0.0, 0.0}), rotation_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor box_frame_desc;
+  box_frame_desc.name = "box_frame";
+  box_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  box_frame_desc.description = "The TF frame the box pose is given in, if different from the input frame. The points are cropped in this frame without transforming the cloud.";
+  declare_parameter (box_frame_desc.name, rclcpp::ParameterValue(""), box_frame_desc);
+
   rcl_interfaces::msg::ParameterDescriptor input_frame_desc;
   input_frame_desc.name = "input_frame";
   input_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
@@ -136,6 +162,9 @@ pcl_ros::CropBox::CropBox(const rclcpp::NodeOptions & options)
     max_z_desc.name,
     keep_organized_desc.name,
     neg_desc.name,
+    translation_desc.name,
+    rotation_desc.name,
+    box_frame_desc.name,
     input_frame_desc.name,
     output_frame_desc.name
   };
@@ -145,49 +174,161 @@ pcl_ros::CropBox::CropBox(const rclcpp::NodeOptions & options)
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::CropBox::lookupBoxTransform (const PointCloud2 &input, Eigen::Affine3f &transform)
+{
+  std::string box_frame;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    box_frame = box_frame_;
+  }
+
+  transform = Eigen::Affine3f::Identity ();
+  if (box_frame.empty () || box_frame == input.header.frame_id)
+    return (true);
+  try
+  {
+    geometry_msgs::msg::TransformStamped transform_stamped =
+      tf_buffer_.lookupTransform (box_frame, input.header.frame_id, tf2_ros::fromMsg (input.header.stamp),
+                                 tf2::durationFromSec (kBoxTransformTimeout));
+    pcl_ros::transformAsMatrix (transform_stamped, transform.matrix ());
+  }
+  catch (const tf2::TransformException &e)
+  {
+    RCLCPP_ERROR_THROTTLE (get_logger (), *get_clock (), 5000, "Cannot transform the input from %s to the box frame %s: %s",
+                           input.header.frame_id.c_str (), box_frame.c_str (), e.what ());
+    return (false);
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::CropBox::acceptInput (const PointCloud2 &input, std::string &reason)
+{
+  Eigen::Affine3f transform;
+  if (!lookupBoxTransform (input, transform))
+  {
+    reason = "tf";
+    return (false);
+  }
+  std::lock_guard<std::mutex> lock(box_transforms_mutex_);
+  box_transforms_[&input] = transform.matrix ();
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::CropBox::takeBoxTransform (const PointCloud2 &input, Eigen::Affine3f &transform)
+{
+  {
+    std::lock_guard<std::mutex> lock(box_transforms_mutex_);
+    auto it = box_transforms_.find (&input);
+    if (it != box_transforms_.end ())
+    {
+      transform.matrix () = it->second;
+      box_transforms_.erase (it);
+      return (true);
+    }
+  }
+  // Not called through Filter::computePublish ()
+  return (lookupBoxTransform (input, transform));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::CropBox::filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                          PointCloud2 &output)
+{
+  // Crop in the box frame by moving the points on the fly, rather than transforming the whole cloud first
+  Eigen::Affine3f transform;
+  if (!takeBoxTransform (*input, transform))
+  {
+    output.header = input->header;
+    output.fields = input->fields;
+    output.point_step = input->point_step;
+    output.height = 1;
+    return;
+  }
+
+  pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+  pcl_conversions::toPCL (*(input), *(pcl_input));
+  auto impl = impl_pool_.acquire();
+  impl->setTransform (transform);
+  impl->setInputCloud (pcl_input);
+  impl->setIndices(indices);
+  pcl::PCLPointCloud2 pcl_output;
+  impl->filter (pcl_output);
+  pcl_conversions::moveFromPCL(pcl_output, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::CropBox::filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                 std::vector<int> &output)
+{
+  Eigen::Affine3f transform;
+  if (!takeBoxTransform (*input, transform))
+    return (false);
+
+  pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+  pcl_conversions::toPCL (*(input), *(pcl_input));
+  auto impl = impl_pool_.acquire();
+  impl->setTransform (transform);
+  impl->setInputCloud (pcl_input);
+  impl->setIndices(indices);
+  impl->filter (output);
+  return (true);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 rcl_interfaces::msg::SetParametersResult
 pcl_ros::CropBox::config_callback (const std::vector<rclcpp::Parameter> & params)
 {
   std::lock_guard<std::mutex> lock(mutex_);
 
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+
   Eigen::Vector4f min_point,max_point;
   min_point = impl_.getMin();
   max_point = impl_.getMax();
 
-  double min_x = min_point(0);
-  double min_y = min_point(1);
-  double min_z = min_point(2);
-  double max_x = max_point(0);
-  double max_y = max_point(1);
-  double max_z = max_point(2);
-
+  // Validate the whole set first, so that a rejected set leaves the configuration untouched
+  Eigen::Vector4f new_min_point = min_point, new_max_point = max_point;
   for (const rclcpp::Parameter &param : params)
   {
-    if (param.get_name () == "min_x")
-    {
-      min_x = param.as_double ();
-    }
-    if (param.get_name () == "max_x")
-    {
-      max_x = param.as_double ();
-    }
-    if (param.get_name () == "min_y")
+    const std::string &name = param.get_name ();
+    if (name == "min_x" || name == "min_y" || name == "min_z")
     {
-      min_y = param.as_double ();
+      new_min_point(name[4] - 'x') = param.as_double ();
     }
-    if (param.get_name () == "max_y")
+    else if (name == "max_x" || name == "max_y" || name == "max_z")
     {
-      max_y = param.as_double ();
+      new_max_point(name[4] - 'x') = param.as_double ();
     }
-    if (param.get_name () == "min_z")
+    else if ((name == "translation" || name == "rotation") && param.as_double_array ().size () != 3)
     {
-      min_z = param.as_double ();
+      result.successful = false;
+      result.reason = "Parameter '" + name + "' must have 3 values.";
+      return result;
     }
-    if (param.get_name () == "max_z")
+  }
+  new_min_point(3) = new_max_point(3) = 0.0;
+  for (int i = 0; i < 3; ++i)
+  {
+    if (new_min_point(i) > new_max_point(i))
     {
-      max_z = param.as_double ();
+      const char axis = static_cast<char> ('x' + i);
+      result.successful = false;
+      result.reason = std::string ("Parameter 'min_") + axis + "' must not be greater than 'max_" + axis + "'.";
+      return result;
     }
+  }
+
+  for (const rclcpp::Parameter &param : params)
+  {
     if (param.get_name () == "keep_organized")
     {
       // Check the current value for keep_organized
@@ -198,7 +339,7 @@ pcl_ros::CropBox::config_callback (const std::vector<rclcpp::Parameter> & params
         impl_.setKeepOrganized (param.as_bool ());
       }
     }
-    if (param.get_name () == "negative")
+    else if (param.get_name () == "negative")
     {
       // Check the current value for the negative flag
       if (impl_.getNegative() != param.as_bool ())
@@ -208,7 +349,25 @@ pcl_ros::CropBox::config_callback (const std::vector<rclcpp::Parameter> & params
         impl_.setNegative(param.as_bool ());
       }
     }
-    if (param.get_name () == "input_frame")
+    else if (param.get_name () == "translation" || param.get_name () == "rotation")
+    {
+      const std::vector<double> value = param.as_double_array ();
+      const Eigen::Vector3f v (value[0], value[1], value[2]);
+      RCLCPP_DEBUG(get_logger(), "Setting the box %s to: %f %f %f.", param.get_name ().c_str (), v(0), v(1), v(2));
+      if (param.get_name () == "translation")
+        impl_.setTranslation (v);
+      else
+        impl_.setRotation (v);
+    }
+    else if (param.get_name () == "box_frame")
+    {
+      if (box_frame_ != param.as_string ())
+      {
+        box_frame_ = param.as_string ();
+        RCLCPP_DEBUG (get_logger(), "Setting the box TF frame to: %s.", box_frame_.c_str ());
+      }
+    }
+    else if (param.get_name () == "input_frame")
     {
       // The following parameters are updated automatically for all PCL_ROS Nodelet Filters as they are inexistent in PCL
       if (tf_input_frame_ != param.as_string ())
@@ -217,7 +376,7 @@ pcl_ros::CropBox::config_callback (const std::vector<rclcpp::Parameter> & params
         RCLCPP_DEBUG (get_logger(), "Setting the input TF frame to: %s.", tf_input_frame_.c_str ());
       }
     }
-    if (param.get_name () == "output_frame")
+    else if (param.get_name () == "output_frame")
     {
       if (tf_output_frame_ != param.as_string ())
       {
@@ -227,10 +386,6 @@ pcl_ros::CropBox::config_callback (const std::vector<rclcpp::Parameter> & params
     }
   }
 
-  Eigen::Vector4f new_min_point, new_max_point;
-  new_min_point << min_x, min_y, min_z, 0.0;
-  new_max_point << max_x, max_y, max_z, 0.0;
-
   // Check the current values for minimum point
   if (min_point != new_min_point)
   {
@@ -238,17 +393,15 @@ pcl_ros::CropBox::config_callback (const std::vector<rclcpp::Parameter> & params
     // Set the filter min point if different
     impl_.setMin(new_min_point);
   }
- // Check the current values for the maximum point
- if (max_point != new_max_point)
+  // Check the current values for the maximum point
+  if (max_point != new_max_point)
   {
     RCLCPP_DEBUG(get_logger(), "Setting the maximum point to: %f %f %f.", new_max_point(0),new_max_point(1),new_max_point(2));
     // Set the filter max point if different
     impl_.setMax(new_max_point);
   }
 
-  // TODO(sloretz) constraint validation
-  rcl_interfaces::msg::SetParametersResult result;
-  result.successful = true;
+  impl_pool_.invalidate();
   return result;
 }
 
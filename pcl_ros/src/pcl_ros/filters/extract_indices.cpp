@@ -78,6 +78,8 @@ pcl_ros::ExtractIndices::config_callback(const std::vector<rclcpp::Parameter> &p
         }
     }
 
+    impl_pool_.invalidate();
+
     // TODO(sloretz) constraint validation
     rcl_interfaces::msg::SetParametersResult result;
     result.successful = true;
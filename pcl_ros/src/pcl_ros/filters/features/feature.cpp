@@ -79,9 +79,9 @@ use_surface_(false), spatial_locator_type_(-1)
   {
     // Create the objects here
     if (approximate_sync_)
-      sync_input_surface_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudIn, PointIndices> > >(max_queue_size_);
+      sync_input_surface_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudIn, PointIndices> > >(inputQueueSize());
     else
-      sync_input_surface_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudIn, PointIndices> > >(max_queue_size_);
+      sync_input_surface_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudIn, PointIndices> > >(inputQueueSize());
 
     // Subscribe to the input using a filter
     sub_input_filter_.subscribe (this->shared_from_this (), "input");
@@ -249,9 +249,9 @@ pcl_ros::FeatureFromNormals::FeatureFromNormals (std::string node_name, const rc
 
   // Create the objects here
   if (approximate_sync_)
-    sync_input_normals_surface_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > (max_queue_size_);
+    sync_input_normals_surface_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > (inputQueueSize ());
   else
-    sync_input_normals_surface_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > (max_queue_size_);
+    sync_input_normals_surface_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloudIn, PointCloudN, PointCloudIn, PointIndices> > > (inputQueueSize ());
 
   // If we're supposed to look for PointIndices (indices) or PointCloud (surface) messages
   if (use_indices_ || use_surface_)
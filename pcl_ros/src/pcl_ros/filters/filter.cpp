@@ -35,6 +35,8 @@
  *
  */
 
+#include <cstring>
+#include <stdexcept>
 #include <pcl/common/io.h>
 #include "pcl_ros/transforms.hpp"
 #include "pcl_ros/filters/filter.hpp"
@@ -56,9 +58,34 @@
 //#include "voxel_grid.cpp"
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-pcl_ros::Filter::Filter(std::string node_name, const rclcpp::NodeOptions &options) : PCLNode(node_name, options)
+pcl_ros::Filter::Filter(std::string node_name, const rclcpp::NodeOptions &options, bool supports_output_indices)
+: PCLNode(node_name, options)
 {
-  pub_output_ = this->create_publisher<PointCloud2>("output", cloudQoS());
+  rcl_interfaces::msg::ParameterDescriptor output_indices_desc;
+  output_indices_desc.name = "output_indices";
+  output_indices_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  output_indices_desc.description = "Publish the indices of the points passing the filter on output_indices instead of the filtered cloud on output. Only supported by the CropBox, MultiCropBox, RadiusOutlierRemoval and StatisticalOutlierRemoval filters.";
+  output_indices_desc.read_only = true;
+  output_indices_ = declare_parameter(output_indices_desc.name, output_indices_, output_indices_desc);
+  if (output_indices_ && !supports_output_indices)
+  {
+    throw std::runtime_error("Parameter 'output_indices' is not supported by " + node_name + ".");
+  }
+
+  if (output_indices_)
+  {
+    pub_indices_ = this->create_publisher<PointIndices>("output_indices", outputQoS());
+  }
+  else
+  {
+    pub_output_ = this->create_publisher<PointCloud2>("output", outputQoS());
+  }
+
+  if (num_workers_ > 1)
+  {
+    sequencer_.reset(new FrameSequencer);
+    gate_.reset(new AdmissionGate(num_workers_));
+  }
 
   // TODO(sloretz) subscribe only when there is a subscriber to our output
   subscribe();
@@ -66,52 +93,127 @@ pcl_ros::Filter::Filter(std::string node_name, const rclcpp::NodeOptions &option
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void pcl_ros::Filter::computePublish(const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices)
+void pcl_ros::Filter::computePublish(const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                     const std::string &input_orig_frame,
+                                     NodeStatistics::Frame &frame, FrameSequencer::Ticket &ticket)
 {
-  PointCloud2 output;
+  std::string reason;
+  if (!acceptInput(*input, reason))
+  {
+    frame.dropped(reason);
+    return;
+  }
+
+  if (output_indices_)
+  {
+    auto output = std::make_unique<PointIndices>();
+    frame.startCompute(indices ? indices->size() : input->width * input->height);
+    if (!filterIndices(input, indices, output->indices))
+    {
+      RCLCPP_ERROR_THROTTLE(this->get_logger(), *this->get_clock(), 5000, "Could not compute the output indices!");
+      frame.dropped("filter_failed");
+      return;
+    }
+    frame.endCompute(output->indices.size());
+
+    // The indices do not depend on the frame, report the one of the original input
+    output->header = input->header;
+    output->header.frame_id = input_orig_frame;
+
+    ticket.waitTurn();
+    pub_indices_->publish(std::move(output));
+    frame.published();
+    return;
+  }
+
+  // The output is handed over to the middleware when published, the points are never copied
+  auto output = std::make_unique<PointCloud2>();
   // Call the virtual method in the child
-  filter(input, indices, output);
+  frame.startCompute(indices ? indices->size() : input->width * input->height);
+  filter(input, indices, *output);
+  frame.endCompute(output->width * output->height);
 
-  PointCloud2::SharedPtr cloud_tf(new PointCloud2(output)); // set the output by default
   // Check whether the user has given a different output TF frame
-  if (!tf_output_frame_.empty() && output.header.frame_id != tf_output_frame_)
+  if (!tf_output_frame_.empty() && output->header.frame_id != tf_output_frame_)
   {
-    RCLCPP_DEBUG(this->get_logger(), "Transforming output dataset from %s to %s.", output.header.frame_id.c_str(), tf_output_frame_.c_str());
+    RCLCPP_DEBUG(this->get_logger(), "Transforming output dataset from %s to %s.", output->header.frame_id.c_str(), tf_output_frame_.c_str());
     // Convert the cloud into the different frame
-    PointCloud2 cloud_transformed;
-    if (!pcl_ros::transformPointCloud(tf_output_frame_, output, cloud_transformed, tf_buffer_))
+    auto cloud_transformed = std::make_unique<PointCloud2>();
+    if (!pcl_ros::transformPointCloud(tf_output_frame_, *output, *cloud_transformed, tf_buffer_))
     {
-      RCLCPP_ERROR(this->get_logger(), "Error converting output dataset from %s to %s.", output.header.frame_id.c_str(), tf_output_frame_.c_str());
+      RCLCPP_ERROR(this->get_logger(), "Error converting output dataset from %s to %s.", output->header.frame_id.c_str(), tf_output_frame_.c_str());
+      frame.dropped("tf_output");
       return;
     }
-    cloud_tf.reset(new PointCloud2(cloud_transformed));
+    output = std::move(cloud_transformed);
   }
-  if (tf_output_frame_.empty() && output.header.frame_id != tf_input_orig_frame_)
+  if (tf_output_frame_.empty() && output->header.frame_id != input_orig_frame)
   // no tf_output_frame given, transform the dataset to its original frame
   {
-    RCLCPP_DEBUG(this->get_logger(), "Transforming output dataset from %s back to %s.", output.header.frame_id.c_str(), tf_input_orig_frame_.c_str());
+    RCLCPP_DEBUG(this->get_logger(), "Transforming output dataset from %s back to %s.", output->header.frame_id.c_str(), input_orig_frame.c_str());
     // Convert the cloud into the different frame
-    PointCloud2 cloud_transformed;
-    if (!pcl_ros::transformPointCloud(tf_input_orig_frame_, output, cloud_transformed, tf_buffer_))
+    auto cloud_transformed = std::make_unique<PointCloud2>();
+    if (!pcl_ros::transformPointCloud(input_orig_frame, *output, *cloud_transformed, tf_buffer_))
     {
-      RCLCPP_ERROR(this->get_logger(), "Error converting output dataset from %s back to %s.", output.header.frame_id.c_str(), tf_input_orig_frame_.c_str());
+      RCLCPP_ERROR(this->get_logger(), "Error converting output dataset from %s back to %s.", output->header.frame_id.c_str(), input_orig_frame.c_str());
+      frame.dropped("tf_output");
       return;
     }
-    cloud_tf.reset(new PointCloud2(cloud_transformed));
+    output = std::move(cloud_transformed);
   }
 
   // Copy timestamp to keep it
-  cloud_tf->header.stamp = input->header.stamp;
+  output->header.stamp = input->header.stamp;
+
+  // Publish, after the frames received before this one
+  ticket.waitTurn();
+  pub_output_->publish(std::move(output));
+  frame.published();
+}
 
-  // Publish a shared ptr
-  pub_output_->publish(*cloud_tf);
+//////////////////////////////////////////////////////////////////////////////////////////////
+void pcl_ros::Filter::copyPoints(const PointCloud2 &input, const std::vector<int> &indices, PointCloud2 &output)
+{
+  output.header = input.header;
+  output.fields = input.fields;
+  output.is_bigendian = input.is_bigendian;
+  output.point_step = input.point_step;
+  output.height = 1;
+  output.width = static_cast<uint32_t>(indices.size());
+  output.row_step = output.width * output.point_step;
+  output.is_dense = input.is_dense;
+  output.data.resize(indices.size() * input.point_step);
+  uint8_t *point = output.data.data();
+  for (int index : indices)
+  {
+    memcpy(point, &input.data[static_cast<size_t>(index) * input.point_step], input.point_step);
+    point += input.point_step;
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 void pcl_ros::Filter::subscribe()
 {
+  // Frames are only processed concurrently if the callback is allowed to run in parallel with itself
+  rclcpp::SubscriptionOptions options;
+  if (num_workers_ > 1)
+  {
+    options.callback_group = this->create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+  }
+
+  // If we're supposed to look for latched PointIndices (indices), every cloud is processed with the latest ones
+  if (use_indices_ && latched_indices_)
+  {
+    sub_indices_ = this->create_subscription<PointIndices>("indices", indicesQoS(),
+        std::bind(&Filter::indices_callback, this, std::placeholders::_1));
+
+    // Workaround ros2/rclcpp#766
+    std::function<void(PointCloud2::ConstSharedPtr)> callback =
+        std::bind(&Filter::input_latched_indices_callback, this, std::placeholders::_1);
+    sub_input_ = this->create_subscription<PointCloud2>("input", cloudQoS(), callback, options);
+  }
   // If we're supposed to look for PointIndices (indices)
-  if (use_indices_)
+  else if (use_indices_)
   {
     // Subscribe to the input using a filter
     sub_input_filter_.subscribe(this->shared_from_this(), "input", cloudQoS().get_rmw_qos_profile());
@@ -119,14 +221,14 @@ void pcl_ros::Filter::subscribe()
 
     if (approximate_sync_)
     {
-      sync_input_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, pcl_msgs::msg::PointIndices>>>(max_queue_size_);
+      sync_input_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, pcl_msgs::msg::PointIndices>>>(inputQueueSize());
       sync_input_indices_a_->connectInput(sub_input_filter_, sub_indices_filter_);
       auto callback = std::bind(&Filter::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2);
       sync_input_indices_a_->registerCallback(callback);
     }
     else
     {
-      sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, pcl_msgs::msg::PointIndices>>>(max_queue_size_);
+      sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, pcl_msgs::msg::PointIndices>>>(inputQueueSize());
       sync_input_indices_e_->connectInput(sub_input_filter_, sub_indices_filter_);
       auto callback = std::bind(&Filter::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2);
       sync_input_indices_e_->registerCallback(callback);
@@ -139,14 +241,19 @@ void pcl_ros::Filter::subscribe()
         std::bind(&Filter::input_indices_callback, this, std::placeholders::_1, nullptr);
 
     // Subscribe in an old fashion to input only (no filters)
-    sub_input_ = this->create_subscription<PointCloud2>("input", cloudQoS(), callback);
+    sub_input_ = this->create_subscription<PointCloud2>("input", cloudQoS(), callback, options);
   }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 void pcl_ros::Filter::unsubscribe()
 {
-  if (use_indices_)
+  if (use_indices_ && latched_indices_)
+  {
+    sub_input_.reset();
+    sub_indices_.reset();
+  }
+  else if (use_indices_)
   {
     sub_input_filter_.unsubscribe();
     sub_indices_filter_.unsubscribe();
@@ -157,19 +264,66 @@ void pcl_ros::Filter::unsubscribe()
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+void pcl_ros::Filter::indices_callback(const PointIndicesConstPtr indices)
+{
+  std::lock_guard<std::mutex> lock(latest_indices_mutex_);
+  latest_indices_ = indices;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void pcl_ros::Filter::input_latched_indices_callback(const PointCloud2::ConstSharedPtr cloud)
+{
+  PointIndicesConstPtr indices;
+  {
+    std::lock_guard<std::mutex> lock(latest_indices_mutex_);
+    indices = latest_indices_;
+  }
+
+  if (!indices)
+  {
+    RCLCPP_WARN_THROTTLE(this->get_logger(), *this->get_clock(), 5000, "No indices received yet, dropping the input clouds.");
+    NodeStatistics::Frame frame(statistics_.get());
+    frame.dropped("no_indices");
+    return;
+  }
+
+  input_indices_callback(cloud, indices);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 void pcl_ros::Filter::input_indices_callback(const PointCloud2::ConstSharedPtr cloud, const pcl_msgs::msg::PointIndices::ConstSharedPtr indices)
 {
+  NodeStatistics::Frame frame(statistics_.get());
+
+  // Turn the frame away if all the workers are busy, before it takes a place in the output order
+  AdmissionGate::Pass pass(gate_.get());
+  if (!pass)
+  {
+    frame.dropped("busy");
+    return;
+  }
+  FrameSequencer::Ticket ticket(sequencer_.get());
+
+  // Skip the frames that waited too long in the queue
+  if (isStale(cloud->header))
+  {
+    frame.dropped("stale");
+    return;
+  }
+
   // If cloud is given, check if it's valid
   if (!isValid(cloud))
   {
     RCLCPP_ERROR(this->get_logger(), "Invalid input!");
+    frame.dropped("invalid_input");
     return;
   }
   // If indices are given, check if they are valid
   if (indices && !isValid(indices))
   {
     RCLCPP_ERROR(this->get_logger(), "Invalid indices!");
+    frame.dropped("invalid_indices");
     return;
   }
 
@@ -189,17 +343,16 @@ void pcl_ros::Filter::input_indices_callback(const PointCloud2::ConstSharedPtr c
   ///
 
   // Check whether the user has given a different input TF frame
-  tf_input_orig_frame_ = cloud->header.frame_id;
   PointCloud2::ConstSharedPtr cloud_tf;
   if (!tf_input_frame_.empty() && cloud->header.frame_id != tf_input_frame_)
   {
     RCLCPP_DEBUG(this->get_logger(), "Transforming input dataset from %s to %s.", cloud->header.frame_id.c_str(), tf_input_frame_.c_str());
-    // Save the original frame ID
     // Convert the cloud into the different frame
     PointCloud2 cloud_transformed;
     if (!pcl_ros::transformPointCloud(tf_input_frame_, *cloud, cloud_transformed, tf_buffer_))
     {
       RCLCPP_ERROR(this->get_logger(), "Error converting input dataset from %s to %s.", cloud->header.frame_id.c_str(), tf_input_frame_.c_str());
+      frame.dropped("tf_input");
       return;
     }
     cloud_tf = std::make_shared<PointCloud2>(cloud_transformed);
@@ -213,8 +366,9 @@ void pcl_ros::Filter::input_indices_callback(const PointCloud2::ConstSharedPtr c
   IndicesPtr vindices;
   if (indices)
   {
-    vindices.reset(new std::vector<int>(indices->indices));
+    vindices = indicesFromMsg(indices);
   }
 
-  computePublish(cloud_tf, vindices);
+  // The original frame ID travels with the frame, concurrent frames may come from different frames
+  computePublish(cloud_tf, vindices, cloud->header.frame_id, frame, ticket);
 }
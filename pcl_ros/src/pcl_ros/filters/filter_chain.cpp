@@ -0,0 +1,478 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#include <pcl/common/io.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/filters/passthrough.h>
+#include <pcl/filters/radius_outlier_removal.h>
+#include <pcl/filters/statistical_outlier_removal.h>
+#include <pcl/filters/voxel_grid.h>
+#include "pcl_ros/filters/filter_chain.hpp"
+
+typedef pcl::PCLPointCloud2 PCLPointCloud2;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::FilterChain::FilterChain(const rclcpp::NodeOptions &options)
+: Filter("FilterChainNode", options)
+{
+  rcl_interfaces::msg::ParameterDescriptor stages_desc;
+  stages_desc.name = "stages";
+  stages_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING_ARRAY;
+  stages_desc.description = "Ordered list of filter stage names. Every stage needs a '<name>.type' parameter.";
+  stages_desc.read_only = true;
+  const std::vector<std::string> stage_names = declare_parameter(
+    stages_desc.name, rclcpp::ParameterValue(std::vector<std::string>()), stages_desc).get<std::vector<std::string>>();
+
+  std::vector<std::string> param_names;
+  for (const std::string &stage_name : stage_names)
+  {
+    rcl_interfaces::msg::ParameterDescriptor type_desc;
+    type_desc.name = stage_name + ".type";
+    type_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+    type_desc.description = "The stage type: passthrough, crop_box, voxel_grid, statistical_outlier_removal or radius_outlier_removal.";
+    type_desc.read_only = true;
+    const std::string type = declare_parameter(type_desc.name, rclcpp::ParameterValue(""), type_desc).get<std::string>();
+
+    stages_.push_back(createStage(stage_name, type, param_names));
+  }
+
+  rcl_interfaces::msg::ParameterDescriptor input_frame_desc;
+  input_frame_desc.name = "input_frame";
+  input_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  input_frame_desc.description = "The input TF frame the data should be transformed into before processing, if input.header.frame_id is different.";
+  declare_parameter (input_frame_desc.name, rclcpp::ParameterValue(""), input_frame_desc);
+  param_names.push_back(input_frame_desc.name);
+
+  rcl_interfaces::msg::ParameterDescriptor output_frame_desc;
+  output_frame_desc.name = "output_frame";
+  output_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  output_frame_desc.description = "The output TF frame the data should be transformed into after processing, if input.header.frame_id is different.";
+  declare_parameter (output_frame_desc.name, rclcpp::ParameterValue(""), output_frame_desc);
+  param_names.push_back(output_frame_desc.name);
+
+  callback_handle_ = add_on_set_parameters_callback (std::bind (&FilterChain::config_callback, this, std::placeholders::_1));
+  auto result = config_callback(get_parameters(param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
+
+  RCLCPP_DEBUG (get_logger(), "Filter chain created with %zu stages.", stages_.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::FilterChain::Stage
+pcl_ros::FilterChain::createStage (const std::string &name, const std::string &type, std::vector<std::string> &param_names)
+{
+  auto declare_double = [this, &name, &param_names] (const std::string &param, double value, double from, double to, const std::string &description)
+  {
+    rcl_interfaces::msg::ParameterDescriptor desc;
+    desc.name = name + "." + param;
+    desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+    desc.description = description;
+    rcl_interfaces::msg::FloatingPointRange range;
+    range.from_value = from;
+    range.to_value = to;
+    desc.floating_point_range.push_back (range);
+    declare_parameter (desc.name, rclcpp::ParameterValue(value), desc);
+    param_names.push_back (desc.name);
+  };
+  auto declare_int = [this, &name, &param_names] (const std::string &param, int value, int from, int to, const std::string &description)
+  {
+    rcl_interfaces::msg::ParameterDescriptor desc;
+    desc.name = name + "." + param;
+    desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+    desc.description = description;
+    rcl_interfaces::msg::IntegerRange range;
+    range.from_value = from;
+    range.to_value = to;
+    desc.integer_range.push_back (range);
+    declare_parameter (desc.name, rclcpp::ParameterValue(value), desc);
+    param_names.push_back (desc.name);
+  };
+  auto declare_bool = [this, &name, &param_names] (const std::string &param, bool value, const std::string &description)
+  {
+    rcl_interfaces::msg::ParameterDescriptor desc;
+    desc.name = name + "." + param;
+    desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+    desc.description = description;
+    declare_parameter (desc.name, rclcpp::ParameterValue(value), desc);
+    param_names.push_back (desc.name);
+  };
+
+  Stage stage;
+  stage.name = name;
+  stage.type = type;
+
+  if (type == "passthrough")
+  {
+    auto impl = std::make_shared<pcl::PassThrough<PCLPointCloud2> > ();
+    stage.impl = stage.indices_impl = impl;
+
+    rcl_interfaces::msg::ParameterDescriptor ffn_desc;
+    ffn_desc.name = name + ".filter_field_name";
+    ffn_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+    ffn_desc.description = "The field name used for filtering";
+    declare_parameter (ffn_desc.name, rclcpp::ParameterValue("z"), ffn_desc);
+    param_names.push_back (ffn_desc.name);
+
+    declare_double ("filter_limit_min", 0.0, -100000.0, 100000.0, "The minimum allowed field value a point will be considered from");
+    declare_double ("filter_limit_max", 1.0, -100000.0, 100000.0, "The maximum allowed field value a point will be considered from");
+    declare_bool ("filter_limit_negative", false, "Set to true if we want to return the data outside [filter_limit_min; filter_limit_max].");
+  }
+  else if (type == "crop_box")
+  {
+    auto impl = std::make_shared<pcl::CropBox<PCLPointCloud2> > ();
+    stage.impl = stage.indices_impl = impl;
+
+    declare_double ("min_x", -1.0, -1000.0, 1000.0, "X coordinate of the minimum point of the box.");
+    declare_double ("max_x", 1.0, -1000.0, 1000.0, "X coordinate of the maximum point of the box.");
+    declare_double ("min_y", -1.0, -1000.0, 1000.0, "Y coordinate of the minimum point of the box.");
+    declare_double ("max_y", 1.0, -1000.0, 1000.0, "Y coordinate of the maximum point of the box.");
+    declare_double ("min_z", -1.0, -1000.0, 1000.0, "Z coordinate of the minimum point of the box.");
+    declare_double ("max_z", 1.0, -1000.0, 1000.0, "Z coordinate of the maximum point of the box.");
+    declare_bool ("negative", false, "If True the box will be empty Else the remaining points will be the ones in the box");
+  }
+  else if (type == "voxel_grid")
+  {
+    stage.impl = std::make_shared<pcl::VoxelGrid<PCLPointCloud2> > ();
+
+    declare_double ("leaf_size", 0.01, 0.001, 1.0, "The size of a leaf (on x,y,z) used for downsampling.");
+  }
+  else if (type == "statistical_outlier_removal")
+  {
+    auto impl = std::make_shared<pcl::StatisticalOutlierRemoval<PCLPointCloud2> > ();
+    stage.impl = stage.indices_impl = impl;
+
+    declare_int ("mean_k", 2, 2, 100, "The number of points (k) to use for mean distance estimation");
+    declare_double ("stddev", 0.0, 0.0, 5.0, "The standard deviation multiplier threshold. All points outside the mean +- sigma * std_mul will be considered outliers.");
+    declare_bool ("negative", false, "Set whether the inliers should be returned (true) or the outliers (false)");
+  }
+  else if (type == "radius_outlier_removal")
+  {
+    auto impl = std::make_shared<pcl::RadiusOutlierRemoval<PCLPointCloud2> > ();
+    stage.impl = stage.indices_impl = impl;
+
+    declare_double ("radius_search", 0.1, 0.001, 10.0, "Radius of the sphere that will determine which points are neighbors.");
+    declare_int ("min_neighbors", 5, 0, 1000, "The number of neighbors that need to be present in order to be classified as an inlier.");
+    declare_bool ("negative", false, "Set whether the inliers should be returned (false) or the outliers (true)");
+  }
+  else
+  {
+    throw std::runtime_error ("Unknown type '" + type + "' for filter chain stage '" + name + "'.");
+  }
+  return (stage);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::FilterChain::checkStageParameter (const Stage &stage, const std::string &param_name,
+                                           const rclcpp::Parameter &param, std::string &reason) const
+{
+  static const std::map<std::string, std::vector<std::string> > known = {
+    {"passthrough", {"filter_field_name", "filter_limit_min", "filter_limit_max", "filter_limit_negative"}},
+    {"crop_box", {"min_x", "min_y", "min_z", "max_x", "max_y", "max_z", "negative"}},
+    {"voxel_grid", {"leaf_size"}},
+    {"statistical_outlier_removal", {"mean_k", "stddev", "negative"}},
+    {"radius_outlier_removal", {"radius_search", "min_neighbors", "negative"}},
+  };
+  const auto names = known.find (stage.type);
+  if (names == known.end () ||
+      std::find (names->second.begin (), names->second.end (), param_name) == names->second.end ())
+  {
+    reason = "Unknown parameter '" + param_name + "' for " + stage.type + " stage '" + stage.name + "'.";
+    return (false);
+  }
+
+  if (param_name == "filter_field_name" && param.as_string ().empty ())
+  {
+    reason = "Parameter '" + stage.name + "." + param_name + "' must not be empty.";
+    return (false);
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::FilterChain::checkStageLimits (const Stage &stage, const std::map<std::string, double> &values,
+                                        std::string &reason) const
+{
+  // The value set by the batch if any, the current one otherwise
+  auto value = [&values] (const std::string &param_name, double current)
+  {
+    const auto it = values.find (param_name);
+    return (it == values.end () ? current : it->second);
+  };
+
+  if (stage.type == "passthrough")
+  {
+    auto impl = std::static_pointer_cast<pcl::PassThrough<PCLPointCloud2> > (stage.impl);
+    double filter_min, filter_max;
+    impl->getFilterLimits (filter_min, filter_max);
+    if (value ("filter_limit_min", filter_min) > value ("filter_limit_max", filter_max))
+    {
+      reason = "Parameter '" + stage.name + ".filter_limit_min' must not be greater than '" + stage.name + ".filter_limit_max'.";
+      return (false);
+    }
+  }
+  else if (stage.type == "crop_box")
+  {
+    auto impl = std::static_pointer_cast<pcl::CropBox<PCLPointCloud2> > (stage.impl);
+    const Eigen::Vector4f min_point = impl->getMin ();
+    const Eigen::Vector4f max_point = impl->getMax ();
+    static const std::string axes[3] = {"x", "y", "z"};
+    for (int i = 0; i < 3; ++i)
+    {
+      if (value ("min_" + axes[i], min_point (i)) > value ("max_" + axes[i], max_point (i)))
+      {
+        reason = "Parameter '" + stage.name + ".min_" + axes[i] + "' must not be greater than '" + stage.name + ".max_" + axes[i] + "'.";
+        return (false);
+      }
+    }
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::FilterChain::configureStage (Stage &stage, const std::string &param_name, const rclcpp::Parameter &param)
+{
+  if (stage.type == "passthrough")
+  {
+    auto impl = std::static_pointer_cast<pcl::PassThrough<PCLPointCloud2> > (stage.impl);
+    double filter_min, filter_max;
+    impl->getFilterLimits (filter_min, filter_max);
+    if (param_name == "filter_field_name")
+      impl->setFilterFieldName (param.as_string ());
+    else if (param_name == "filter_limit_min")
+      impl->setFilterLimits (param.as_double (), filter_max);
+    else if (param_name == "filter_limit_max")
+      impl->setFilterLimits (filter_min, param.as_double ());
+    else if (param_name == "filter_limit_negative")
+      impl->setNegative (param.as_bool ());
+    else
+      return (false);
+  }
+  else if (stage.type == "crop_box")
+  {
+    auto impl = std::static_pointer_cast<pcl::CropBox<PCLPointCloud2> > (stage.impl);
+    Eigen::Vector4f min_point = impl->getMin ();
+    Eigen::Vector4f max_point = impl->getMax ();
+    if (param_name == "min_x")
+      min_point (0) = param.as_double ();
+    else if (param_name == "min_y")
+      min_point (1) = param.as_double ();
+    else if (param_name == "min_z")
+      min_point (2) = param.as_double ();
+    else if (param_name == "max_x")
+      max_point (0) = param.as_double ();
+    else if (param_name == "max_y")
+      max_point (1) = param.as_double ();
+    else if (param_name == "max_z")
+      max_point (2) = param.as_double ();
+    else if (param_name == "negative")
+      impl->setNegative (param.as_bool ());
+    else
+      return (false);
+    impl->setMin (min_point);
+    impl->setMax (max_point);
+  }
+  else if (stage.type == "voxel_grid")
+  {
+    auto impl = std::static_pointer_cast<pcl::VoxelGrid<PCLPointCloud2> > (stage.impl);
+    if (param_name == "leaf_size")
+      impl->setLeafSize (param.as_double (), param.as_double (), param.as_double ());
+    else
+      return (false);
+  }
+  else if (stage.type == "statistical_outlier_removal")
+  {
+    auto impl = std::static_pointer_cast<pcl::StatisticalOutlierRemoval<PCLPointCloud2> > (stage.impl);
+    if (param_name == "mean_k")
+      impl->setMeanK (param.as_int ());
+    else if (param_name == "stddev")
+      impl->setStddevMulThresh (param.as_double ());
+    else if (param_name == "negative")
+      impl->setNegative (param.as_bool ());
+    else
+      return (false);
+  }
+  else if (stage.type == "radius_outlier_removal")
+  {
+    auto impl = std::static_pointer_cast<pcl::RadiusOutlierRemoval<PCLPointCloud2> > (stage.impl);
+    if (param_name == "radius_search")
+      impl->setRadiusSearch (param.as_double ());
+    else if (param_name == "min_neighbors")
+      impl->setMinNeighborsInRadius (param.as_int ());
+    else if (param_name == "negative")
+      impl->setNegative (param.as_bool ());
+    else
+      return (false);
+  }
+  else
+    return (false);
+
+  RCLCPP_DEBUG (get_logger(), "Setting %s of stage %s to: %s.", param_name.c_str (), stage.name.c_str (), param.value_to_string ().c_str ());
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::FilterChain::filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                              PointCloud2 &output)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Convert once, all the stages work on the same PCL data
+  PCLPointCloud2::Ptr cloud(new PCLPointCloud2);
+  pcl_conversions::toPCL (*(input), *(cloud));
+  IndicesPtr cloud_indices = indices;
+
+  ++nr_runs_;
+  for (Stage &stage : stages_)
+  {
+    const size_t nr_points_in = cloud_indices ? cloud_indices->size () : cloud->width * cloud->height;
+    const auto start = std::chrono::steady_clock::now ();
+
+    stage.impl->setInputCloud (cloud);
+    stage.impl->setIndices (cloud_indices);
+    if (stage.indices_impl)
+    {
+      // Only select points, the data is left untouched for the next stage
+      IndicesPtr selected (new std::vector<int>);
+      stage.indices_impl->filter (*selected);
+      cloud_indices = selected;
+    }
+    else
+    {
+      PCLPointCloud2::Ptr filtered (new PCLPointCloud2);
+      stage.impl->filter (*filtered);
+      cloud = filtered;
+      cloud_indices.reset ();
+    }
+
+    stage.last_duration = std::chrono::steady_clock::now () - start;
+    stage.total_duration += stage.last_duration;
+    RCLCPP_DEBUG (get_logger(), "Stage %s (%s): %zu -> %zu points in %f ms (average %f ms).",
+                  stage.name.c_str (), stage.type.c_str (),
+                  nr_points_in, cloud_indices ? cloud_indices->size () : static_cast<size_t>(cloud->width * cloud->height),
+                  stage.last_duration.count (), stage.total_duration.count () / nr_runs_);
+  }
+
+  // Materialize the remaining selection, if any
+  PCLPointCloud2 pcl_output;
+  if (cloud_indices)
+    pcl::copyPointCloud (*cloud, *cloud_indices, pcl_output);
+  else
+    pcl_output = std::move (*cloud);
+  pcl_conversions::moveFromPCL(pcl_output, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::FilterChain::config_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // Check all the stage parameters before applying any, so a rejected batch leaves the chain unchanged
+  rcl_interfaces::msg::SetParametersResult result;
+  std::vector<std::tuple<Stage *, std::string, const rclcpp::Parameter *> > stage_params;
+  std::map<std::string, std::map<std::string, double> > limits;
+  for (const rclcpp::Parameter &param : params)
+  {
+    // Stage parameters are named <stage>.<parameter>
+    const size_t separator = param.get_name ().find ('.');
+    if (separator == std::string::npos)
+      continue;
+    const std::string stage_name = param.get_name ().substr (0, separator);
+    const std::string param_name = param.get_name ().substr (separator + 1);
+    for (Stage &stage : stages_)
+    {
+      if (stage.name == stage_name && param_name != "type")
+      {
+        if (!checkStageParameter (stage, param_name, param, result.reason))
+        {
+          result.successful = false;
+          return result;
+        }
+        stage_params.emplace_back (&stage, param_name, &param);
+        if (param.get_type () == rclcpp::ParameterType::PARAMETER_DOUBLE)
+          limits[stage.name][param_name] = param.as_double ();
+        break;
+      }
+    }
+  }
+
+  // Then the limits each stage would end up with, from the batch and the current values
+  for (const Stage &stage : stages_)
+  {
+    if (!checkStageLimits (stage, limits[stage.name], result.reason))
+    {
+      result.successful = false;
+      return result;
+    }
+  }
+
+  for (const rclcpp::Parameter &param : params)
+  {
+    // The following parameters are updated automatically for all PCL_ROS Nodelet Filters as they are inexistent in PCL
+    if (param.get_name () == "input_frame")
+    {
+      if (tf_input_frame_ != param.as_string ())
+      {
+        tf_input_frame_ = param.as_string ();
+        RCLCPP_DEBUG (get_logger(), "Setting the input TF frame to: %s.", tf_input_frame_.c_str ());
+      }
+    }
+    else if (param.get_name () == "output_frame")
+    {
+      if (tf_output_frame_ != param.as_string ())
+      {
+        tf_output_frame_ = param.as_string ();
+        RCLCPP_DEBUG (get_logger(), "Setting the output TF frame to: %s.", tf_output_frame_.c_str ());
+      }
+    }
+  }
+  for (const auto &stage_param : stage_params)
+    configureStage (*std::get<0> (stage_param), std::get<1> (stage_param), *std::get<2> (stage_param));
+
+  result.successful = true;
+  return result;
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(pcl_ros::FilterChain)
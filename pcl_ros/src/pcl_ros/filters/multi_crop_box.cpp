@@ -0,0 +1,330 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <pcl/common/eigen.h>
+#include "pcl_ros/filters/multi_crop_box.hpp"
+
+namespace
+{
+  /** \brief Number of points loaded and tested together. */
+  const size_t kBlockSize = 256;
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::MultiCropBox::MultiCropBox(const rclcpp::NodeOptions &options)
+: Filter("MultiCropBoxNode", options, true)
+{
+  rcl_interfaces::msg::ParameterDescriptor boxes_desc;
+  boxes_desc.name = "boxes";
+  boxes_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING_ARRAY;
+  boxes_desc.description = "List of box names. Every box is configured by '<name>.min', '<name>.max', '<name>.translation', '<name>.rotation' and '<name>.mode'.";
+  boxes_desc.read_only = true;
+  const std::vector<std::string> box_names = declare_parameter(
+    boxes_desc.name, rclcpp::ParameterValue(std::vector<std::string>()), boxes_desc).get<std::vector<std::string>>();
+
+  std::vector<std::string> param_names;
+  auto declare_vector = [this, &param_names] (const std::string &name, const std::vector<double> &value, const std::string &description)
+  {
+    rcl_interfaces::msg::ParameterDescriptor desc;
+    desc.name = name;
+    desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE_ARRAY;
+    desc.description = description;
+    declare_parameter (desc.name, rclcpp::ParameterValue(value), desc);
+    param_names.push_back (desc.name);
+  };
+  for (const std::string &box_name : box_names)
+  {
+    Box box;
+    box.name = box_name;
+    boxes_.push_back (box);
+
+    declare_vector (box_name + ".min", {-1.0, -1.0, -1.0}, "The minimum point [x, y, z] of the box, in the box frame.");
+    declare_vector (box_name + ".max", {1.0, 1.0, 1.0}, "The maximum point [x, y, z] of the box, in the box frame.");
+    declare_vector (box_name + ".translation", {0.0, 0.0, 0.0}, "The position [x, y, z] of the box frame in the input frame.");
+    declare_vector (box_name + ".rotation", {0.0, 0.0, 0.0}, "The orientation [roll, pitch, yaw] of the box frame in the input frame, in radians.");
+
+    rcl_interfaces::msg::ParameterDescriptor mode_desc;
+    mode_desc.name = box_name + ".mode";
+    mode_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+    mode_desc.description = "\"include\" to keep the points inside the box, \"exclude\" to remove them.";
+    declare_parameter (mode_desc.name, rclcpp::ParameterValue("include"), mode_desc);
+    param_names.push_back (mode_desc.name);
+  }
+
+  rcl_interfaces::msg::ParameterDescriptor input_frame_desc;
+  input_frame_desc.name = "input_frame";
+  input_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  input_frame_desc.description = "The input TF frame the data should be transformed into before processing, if input.header.frame_id is different.";
+  declare_parameter (input_frame_desc.name, rclcpp::ParameterValue(""), input_frame_desc);
+  param_names.push_back(input_frame_desc.name);
+
+  rcl_interfaces::msg::ParameterDescriptor output_frame_desc;
+  output_frame_desc.name = "output_frame";
+  output_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  output_frame_desc.description = "The output TF frame the data should be transformed into after processing, if input.header.frame_id is different.";
+  declare_parameter (output_frame_desc.name, rclcpp::ParameterValue(""), output_frame_desc);
+  param_names.push_back(output_frame_desc.name);
+
+  callback_handle_ = add_on_set_parameters_callback (std::bind (&MultiCropBox::config_callback, this, std::placeholders::_1));
+  auto result = config_callback(get_parameters(param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
+
+  RCLCPP_DEBUG (get_logger(), "Multi crop box created with %zu boxes.", boxes_.size ());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::MultiCropBox::filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                      std::vector<int> &output)
+{
+  output.clear ();
+
+  std::vector<Box, Eigen::aligned_allocator<Box> > boxes;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    boxes = boxes_;
+  }
+
+  const int x_idx = pcl::getFieldIndex (*input, "x");
+  const int y_idx = pcl::getFieldIndex (*input, "y");
+  const int z_idx = pcl::getFieldIndex (*input, "z");
+  if (x_idx == -1 || y_idx == -1 || z_idx == -1 || input->is_bigendian ||
+      input->fields[x_idx].datatype != sensor_msgs::msg::PointField::FLOAT32 ||
+      input->fields[y_idx].datatype != sensor_msgs::msg::PointField::FLOAT32 ||
+      input->fields[z_idx].datatype != sensor_msgs::msg::PointField::FLOAT32)
+  {
+    RCLCPP_ERROR (get_logger (), "[filterIndices] Input dataset has no little endian FLOAT32 X-Y-Z coordinates!");
+    return (false);
+  }
+  const uint32_t offset[3] = {input->fields[x_idx].offset, input->fields[y_idx].offset, input->fields[z_idx].offset};
+
+  bool has_include = false;
+  for (const Box &box : boxes)
+    has_include |= !box.exclude;
+
+  const size_t nr_points = input->width * input->height;
+  const size_t nr_selected = indices ? indices->size () : nr_points;
+  output.reserve (nr_selected);
+
+  float x[kBlockSize], y[kBlockSize], z[kBlockSize];
+  uint8_t valid[kBlockSize], included[kBlockSize], inside[kBlockSize];
+  int point_index[kBlockSize];
+  for (size_t begin = 0; begin < nr_selected; begin += kBlockSize)
+  {
+    const size_t block_size = std::min (kBlockSize, nr_selected - begin);
+
+    // Load the block
+    for (size_t i = 0; i < block_size; ++i)
+    {
+      const size_t index = indices ? static_cast<size_t> ((*indices)[begin + i]) : begin + i;
+      point_index[i] = static_cast<int> (index);
+      if (index >= nr_points)
+      {
+        x[i] = y[i] = z[i] = std::numeric_limits<float>::quiet_NaN ();
+        continue;
+      }
+      const uint8_t *point = &input->data[index * input->point_step];
+      memcpy (&x[i], point + offset[0], sizeof (float));
+      memcpy (&y[i], point + offset[1], sizeof (float));
+      memcpy (&z[i], point + offset[2], sizeof (float));
+    }
+    for (size_t i = 0; i < block_size; ++i)
+    {
+      valid[i] = std::isfinite (x[i]) & std::isfinite (y[i]) & std::isfinite (z[i]);
+      included[i] = !has_include;
+    }
+
+    // Test the block against every box, in the box frame
+    for (const Box &box : boxes)
+    {
+      const Eigen::Matrix3f r = box.input_to_box.linear ();
+      const Eigen::Vector3f t = box.input_to_box.translation ();
+      const float r00 = r (0, 0), r01 = r (0, 1), r02 = r (0, 2), t0 = t[0];
+      const float r10 = r (1, 0), r11 = r (1, 1), r12 = r (1, 2), t1 = t[1];
+      const float r20 = r (2, 0), r21 = r (2, 1), r22 = r (2, 2), t2 = t[2];
+      const float min0 = box.min_pt[0], min1 = box.min_pt[1], min2 = box.min_pt[2];
+      const float max0 = box.max_pt[0], max1 = box.max_pt[1], max2 = box.max_pt[2];
+      for (size_t i = 0; i < block_size; ++i)
+      {
+        const float bx = r00 * x[i] + r01 * y[i] + r02 * z[i] + t0;
+        const float by = r10 * x[i] + r11 * y[i] + r12 * z[i] + t1;
+        const float bz = r20 * x[i] + r21 * y[i] + r22 * z[i] + t2;
+        inside[i] = (bx >= min0) & (bx <= max0) & (by >= min1) & (by <= max1) & (bz >= min2) & (bz <= max2);
+      }
+      if (box.exclude)
+      {
+        for (size_t i = 0; i < block_size; ++i)
+          valid[i] &= inside[i] ^ 1;
+      }
+      else
+      {
+        for (size_t i = 0; i < block_size; ++i)
+          included[i] |= inside[i];
+      }
+    }
+
+    for (size_t i = 0; i < block_size; ++i)
+    {
+      if (valid[i] & included[i])
+        output.push_back (point_index[i]);
+    }
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::MultiCropBox::filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                               PointCloud2 &output)
+{
+  std::vector<int> kept;
+  if (!filterIndices (input, indices, kept))
+  {
+    // Publish an empty cloud, as the PCL filters do on invalid input
+    output.header = input->header;
+    return;
+  }
+  copyPoints (*input, kept, output);
+  // Non finite points are never kept
+  output.is_dense = true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::MultiCropBox::config_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+
+  // Validate all the parameters on copies first, so that a rejected set leaves the configuration untouched
+  std::vector<Box, Eigen::aligned_allocator<Box> > boxes = boxes_;
+  std::string tf_input_frame = tf_input_frame_;
+  std::string tf_output_frame = tf_output_frame_;
+  for (const rclcpp::Parameter &param : params)
+  {
+    // The following parameters are updated automatically for all PCL_ROS Nodelet Filters as they are inexistent in PCL
+    if (param.get_name () == "input_frame" || param.get_name () == "output_frame")
+    {
+      if (param.get_type () != rclcpp::ParameterType::PARAMETER_STRING)
+      {
+        result.successful = false;
+        result.reason = "Parameter '" + param.get_name () + "' must be a string.";
+        return result;
+      }
+      (param.get_name () == "input_frame" ? tf_input_frame : tf_output_frame) = param.as_string ();
+      continue;
+    }
+
+    // Box parameters, named "<box>.<parameter>"
+    const size_t dot = param.get_name ().rfind ('.');
+    if (dot == std::string::npos)
+      continue;
+    const std::string box_name = param.get_name ().substr (0, dot);
+    const std::string param_name = param.get_name ().substr (dot + 1);
+    for (Box &box : boxes)
+    {
+      if (box.name != box_name)
+        continue;
+
+      if (param_name == "mode")
+      {
+        if (param.get_type () != rclcpp::ParameterType::PARAMETER_STRING ||
+            (param.as_string () != "include" && param.as_string () != "exclude"))
+        {
+          result.successful = false;
+          result.reason = "Invalid mode for box '" + box_name + "', expected 'include' or 'exclude'.";
+          return result;
+        }
+        box.exclude = (param.as_string () == "exclude");
+        continue;
+      }
+      if (param_name != "min" && param_name != "max" && param_name != "translation" && param_name != "rotation")
+        continue;
+
+      if (param.get_type () != rclcpp::ParameterType::PARAMETER_DOUBLE_ARRAY || param.as_double_array ().size () != 3)
+      {
+        result.successful = false;
+        result.reason = "Parameter '" + param.get_name () + "' must have 3 double values.";
+        return result;
+      }
+      const std::vector<double> value = param.as_double_array ();
+      const Eigen::Vector3f v (value[0], value[1], value[2]);
+      if (param_name == "min")
+        box.min_pt = v;
+      else if (param_name == "max")
+        box.max_pt = v;
+      else if (param_name == "translation")
+        box.translation = v;
+      else
+        box.rotation = v;
+    }
+  }
+
+  // Apply
+  if (tf_input_frame_ != tf_input_frame)
+  {
+    tf_input_frame_ = tf_input_frame;
+    RCLCPP_DEBUG (get_logger(), "Setting the input TF frame to: %s.", tf_input_frame_.c_str ());
+  }
+  if (tf_output_frame_ != tf_output_frame)
+  {
+    tf_output_frame_ = tf_output_frame;
+    RCLCPP_DEBUG (get_logger(), "Setting the output TF frame to: %s.", tf_output_frame_.c_str ());
+  }
+  for (Box &box : boxes)
+  {
+    // Same convention as pcl::CropBox
+    Eigen::Affine3f box_to_input;
+    pcl::getTransformation (box.translation[0], box.translation[1], box.translation[2],
+                            box.rotation[0], box.rotation[1], box.rotation[2], box_to_input);
+    box.input_to_box = box_to_input.inverse ();
+    RCLCPP_DEBUG (get_logger(), "Box %s: %s, min %f, %f, %f, max %f, %f, %f.", box.name.c_str (),
+                  box.exclude ? "exclude" : "include", box.min_pt[0], box.min_pt[1], box.min_pt[2],
+                  box.max_pt[0], box.max_pt[1], box.max_pt[2]);
+  }
+  boxes_ = boxes;
+
+  return result;
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(pcl_ros::MultiCropBox)
@@ -0,0 +1,270 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "pcl_ros/filters/organized_neighborhood.hpp"
+
+using sensor_msgs::msg::PointField;
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::OrganizedNeighborhood::setInputCloud (const sensor_msgs::msg::PointCloud2 &cloud)
+{
+  if (cloud.height <= 1 || cloud.is_bigendian)
+    return (false);
+
+  int offset[3] = {-1, -1, -1};
+  for (const PointField &field : cloud.fields)
+  {
+    for (int d = 0; d < 3; ++d)
+    {
+      if (field.name == std::string (1, static_cast<char> ('x' + d)) && field.datatype == PointField::FLOAT32)
+        offset[d] = field.offset;
+    }
+  }
+  if (offset[0] < 0 || offset[1] < 0 || offset[2] < 0)
+    return (false);
+
+  width_ = cloud.width;
+  height_ = cloud.height;
+  const size_t nr_points = static_cast<size_t> (width_) * height_;
+  if (cloud.data.size () < nr_points * cloud.point_step)
+    return (false);
+  x_.resize (nr_points);
+  y_.resize (nr_points);
+  z_.resize (nr_points);
+  valid_.resize (nr_points);
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const uint8_t *point = &cloud.data[i * cloud.point_step];
+    memcpy (&x_[i], point + offset[0], sizeof (float));
+    memcpy (&y_[i], point + offset[1], sizeof (float));
+    memcpy (&z_[i], point + offset[2], sizeof (float));
+    valid_[i] = std::isfinite (x_[i]) && std::isfinite (y_[i]) && std::isfinite (z_[i]);
+    // NaN coordinates make every distance to an invalid point NaN, which the accumulations below reject
+    if (!valid_[i])
+      x_[i] = y_[i] = z_[i] = std::numeric_limits<float>::quiet_NaN ();
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::OrganizedNeighborhood::computeMeanDistances (int half_window, int k, std::vector<float> &mean_distances) const
+{
+  const int width = static_cast<int> (width_), height = static_cast<int> (height_);
+  const int window_size = (2 * half_window + 1) * (2 * half_window + 1);
+  mean_distances.assign (valid_.size (), std::numeric_limits<float>::quiet_NaN ());
+  // Squared distance of every pixel of the row to each of its window neighbors, NaN outside the cloud
+  std::vector<float> sqr_distances (static_cast<size_t> (width) * window_size);
+
+  for (int v = 0; v < height; ++v)
+  {
+    std::fill (sqr_distances.begin (), sqr_distances.end (), std::numeric_limits<float>::quiet_NaN ());
+    const float *x = x_.data () + static_cast<size_t> (v) * width;
+    const float *y = y_.data () + static_cast<size_t> (v) * width;
+    const float *z = z_.data () + static_cast<size_t> (v) * width;
+
+    int offset = 0;
+    for (int dv = -half_window; dv <= half_window; ++dv)
+    {
+      if (v + dv < 0 || v + dv >= height)
+      {
+        offset += 2 * half_window + 1;
+        continue;
+      }
+      const float *nx = x_.data () + static_cast<size_t> (v + dv) * width;
+      const float *ny = y_.data () + static_cast<size_t> (v + dv) * width;
+      const float *nz = z_.data () + static_cast<size_t> (v + dv) * width;
+      for (int du = -half_window; du <= half_window; ++du, ++offset)
+      {
+        if (dv == 0 && du == 0)
+          continue;
+        // Neighbor (u + du, v + dv) of every pixel u of the row, restricted to the image
+        const int u_begin = std::max (0, -du), u_end = std::min (width, width - du);
+        float *sqr_distance = &sqr_distances[offset];
+        for (int u = u_begin; u < u_end; ++u)
+        {
+          const float ex = x[u] - nx[u + du], ey = y[u] - ny[u + du], ez = z[u] - nz[u + du];
+          sqr_distance[static_cast<size_t> (u) * window_size] = ex * ex + ey * ey + ez * ez;
+        }
+      }
+    }
+
+    // Mean distance to the k nearest neighbors of the window, as the k nearest neighbors of a kd-tree search
+    float *mean = &mean_distances[static_cast<size_t> (v) * width];
+    for (int u = 0; u < width; ++u)
+    {
+      if (!valid_[static_cast<size_t> (v) * width + u])
+        continue;
+      float *begin = &sqr_distances[static_cast<size_t> (u) * window_size];
+      float *end = std::partition (begin, begin + window_size, [] (float d) { return (d == d); });
+      const int nr_neighbors = std::min (k, static_cast<int> (end - begin));
+      if (nr_neighbors == 0)
+      {
+        mean[u] = std::numeric_limits<float>::infinity ();
+        continue;
+      }
+      std::nth_element (begin, begin + nr_neighbors - 1, end);
+      float sum = 0.0f;
+      for (int n = 0; n < nr_neighbors; ++n)
+        sum += std::sqrt (begin[n]);
+      mean[u] = sum / static_cast<float> (nr_neighbors);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::OrganizedNeighborhood::computeRadiusCounts (int half_window, float radius, std::vector<uint16_t> &counts) const
+{
+  const int width = static_cast<int> (width_), height = static_cast<int> (height_);
+  const float sqr_radius = radius * radius;
+  counts.assign (valid_.size (), 0);
+
+  for (int v = 0; v < height; ++v)
+  {
+    const float *x = x_.data () + static_cast<size_t> (v) * width;
+    const float *y = y_.data () + static_cast<size_t> (v) * width;
+    const float *z = z_.data () + static_cast<size_t> (v) * width;
+    uint16_t *count = counts.data () + static_cast<size_t> (v) * width;
+
+    for (int dv = -half_window; dv <= half_window; ++dv)
+    {
+      if (v + dv < 0 || v + dv >= height)
+        continue;
+      const float *nx = x_.data () + static_cast<size_t> (v + dv) * width;
+      const float *ny = y_.data () + static_cast<size_t> (v + dv) * width;
+      const float *nz = z_.data () + static_cast<size_t> (v + dv) * width;
+      for (int du = -half_window; du <= half_window; ++du)
+      {
+        if (dv == 0 && du == 0)
+          continue;
+        const int u_begin = std::max (0, -du), u_end = std::min (width, width - du);
+        for (int u = u_begin; u < u_end; ++u)
+        {
+          const float ex = x[u] - nx[u + du], ey = y[u] - ny[u + du], ez = z[u] - nz[u + du];
+          // False for NaN
+          count[u] += static_cast<uint16_t> (ex * ex + ey * ey + ez * ez <= sqr_radius);
+        }
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+int
+pcl_ros::OrganizedNeighborhood::halfWindowForK (int k)
+{
+  int half_window = 1;
+  while ((2 * half_window + 1) * (2 * half_window + 1) - 1 < k)
+    ++half_window;
+  return (half_window);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::organizedStatisticalOutlierRemoval (const OrganizedNeighborhood &neighborhood, int mean_k,
+                                             double stddev_mult, bool negative,
+                                             const std::shared_ptr<std::vector<int> > &indices,
+                                             std::vector<int> &output)
+{
+  std::vector<float> mean_distances;
+  neighborhood.computeMeanDistances (OrganizedNeighborhood::halfWindowForK (mean_k), mean_k, mean_distances);
+
+  selectStatisticalInliers (mean_distances, stddev_mult, negative, indices, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::selectStatisticalInliers (const std::vector<float> &mean_distances, double stddev_mult, bool negative,
+                                   const std::shared_ptr<std::vector<int> > &indices, std::vector<int> &output)
+{
+  const size_t nr_points = mean_distances.size ();
+  const size_t nr_selected = indices ? indices->size () : nr_points;
+  auto index_of = [&indices] (size_t n) { return (indices ? static_cast<size_t> ((*indices)[n]) : n); };
+
+  // Distribution of the mean distances, as pcl::StatisticalOutlierRemoval
+  double sum = 0, sqr_sum = 0;
+  size_t count = 0;
+  for (size_t n = 0; n < nr_selected; ++n)
+  {
+    const size_t index = index_of (n);
+    if (index >= nr_points || !std::isfinite (mean_distances[index]))
+      continue;
+    sum += mean_distances[index];
+    sqr_sum += mean_distances[index] * mean_distances[index];
+    ++count;
+  }
+  const double mean = count > 0 ? sum / count : 0.0;
+  const double variance = count > 1 ? (sqr_sum - sum * sum / count) / (count - 1) : 0.0;
+  const double threshold = mean + stddev_mult * std::sqrt (std::max (variance, 0.0));
+
+  output.clear ();
+  output.reserve (nr_selected);
+  for (size_t n = 0; n < nr_selected; ++n)
+  {
+    const size_t index = index_of (n);
+    // Invalid points are neither inliers nor outliers
+    if (index >= nr_points || std::isnan (mean_distances[index]))
+      continue;
+    const bool inlier = mean_distances[index] <= threshold;
+    if (inlier != negative)
+      output.push_back (static_cast<int> (index));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::organizedRadiusOutlierRemoval (const OrganizedNeighborhood &neighborhood, int half_window,
+                                        double radius, int min_neighbors,
+                                        const std::shared_ptr<std::vector<int> > &indices, std::vector<int> &output)
+{
+  std::vector<uint16_t> counts;
+  neighborhood.computeRadiusCounts (half_window, static_cast<float> (radius), counts);
+
+  const size_t nr_points = neighborhood.size ();
+  const size_t nr_selected = indices ? indices->size () : nr_points;
+  output.clear ();
+  output.reserve (nr_selected);
+  for (size_t n = 0; n < nr_selected; ++n)
+  {
+    const size_t index = indices ? static_cast<size_t> ((*indices)[n]) : n;
+    if (index < nr_points && neighborhood.isValid (index) && counts[index] >= min_neighbors)
+      output.push_back (static_cast<int> (index));
+  }
+}
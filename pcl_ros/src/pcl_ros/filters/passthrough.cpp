@@ -189,6 +189,8 @@ pcl_ros::PassThrough::config_callback (const std::vector<rclcpp::Parameter> & pa
       }
     }
   }
+  impl_pool_.invalidate();
+
   // TODO(sloretz) constraint validation
   rcl_interfaces::msg::SetParametersResult result;
   result.successful = true;
@@ -63,7 +63,7 @@ pcl_ros::ProjectInliers::ProjectInliers (const rclcpp::NodeOptions& options) : F
   pub_output_ = this->create_publisher<PointCloud2> ("output", max_queue_size_);
 
   // Subscribe to the input using a filter
-  sub_input_filter_.subscribe (this->shared_from_this (),"input");
+  sub_input_filter_.subscribe (this->shared_from_this (), "input", cloudQoS ().get_rmw_qos_profile ());
 
   RCLCPP_DEBUG (this->get_logger(), "[%s::onConstruct] Node successfully created with the following parameters:\n"
                  " - model_type      : %d\n"
@@ -88,19 +88,19 @@ pcl_ros::ProjectInliers::subscribe ()
   if (use_indices_)
   {*/
 
-  sub_indices_filter_.subscribe (this->shared_from_this (), "indices");
+  sub_indices_filter_.subscribe (this->shared_from_this (), "indices", indicesQoS ().get_rmw_qos_profile ());
 
-  sub_model_.subscribe (this->shared_from_this (), "model");
+  sub_model_.subscribe (this->shared_from_this (), "model", cloudQoS ().get_rmw_qos_profile ());
 
   if (approximate_sync_)
   {
-    sync_input_indices_model_a_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<PointCloud2, PointIndices, ModelCoefficients> > > (max_queue_size_);
+    sync_input_indices_model_a_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<PointCloud2, PointIndices, ModelCoefficients> > > (inputQueueSize ());
     sync_input_indices_model_a_->connectInput (sub_input_filter_, sub_indices_filter_, sub_model_);
     sync_input_indices_model_a_->registerCallback (std::bind (&ProjectInliers::input_indices_model_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
   }
   else
   {
-    sync_input_indices_model_e_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ExactTime<PointCloud2, PointIndices, ModelCoefficients> > > (max_queue_size_);
+    sync_input_indices_model_e_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ExactTime<PointCloud2, PointIndices, ModelCoefficients> > > (inputQueueSize ());
     sync_input_indices_model_e_->connectInput (sub_input_filter_, sub_indices_filter_, sub_model_);
     sync_input_indices_model_e_->registerCallback (std::bind (&ProjectInliers::input_indices_model_callback, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
   }
@@ -125,15 +125,24 @@ pcl_ros::ProjectInliers::input_indices_model_callback (const PointCloud2::ConstS
                                                        const PointIndicesConstPtr &indices,
                                                        const ModelCoefficientsConstPtr &model)
 {
+  NodeStatistics::Frame frame (statistics_.get ());
+
   /*
    No count_subscribers functionality yet in ROS2
    if (pub_output_->count_subscribers () <= 0)
     return;
    */
 
+  if (isStale (cloud->header))
+  {
+    frame.dropped ("stale");
+    return;
+  }
+
   if (!isValid (model) || !isValid (indices) || !isValid (cloud))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_indices_model_callback] Invalid input!", this->get_name ());
+    frame.dropped ("invalid_input");
     return;
   }
 
@@ -146,14 +155,15 @@ pcl_ros::ProjectInliers::input_indices_model_callback (const PointCloud2::ConstS
                  indices->indices.size (), indices->header.stamp.sec, indices->header.frame_id.c_str (), "inliers",
                  model->values.size (), model->header.stamp.sec, model->header.frame_id.c_str (), "model");
 
-  tf_input_orig_frame_ = cloud->header.frame_id;
-
   IndicesPtr vindices;
   if (indices)
-    vindices.reset (new std::vector<int> (indices->indices));
+    vindices = indicesFromMsg (indices);
+
+  // Synchronized callbacks are never run concurrently, the output is already in order
+  FrameSequencer::Ticket ticket (nullptr);
 
   model_   = model;
-  computePublish (cloud, vindices);
+  computePublish (cloud, vindices, cloud->header.frame_id, frame, ticket);
 }
 
 typedef pcl_ros::ProjectInliers ProjectInliers;
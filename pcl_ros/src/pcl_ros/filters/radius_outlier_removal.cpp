@@ -35,10 +35,13 @@
  *
  */
 
+#include <pcl/common/point_tests.h>
+#include "pcl_ros/filters/organized_neighborhood.hpp"
 #include "pcl_ros/filters/radius_outlier_removal.hpp"
+#include "pcl_ros/filters/voxel_hash.hpp"
 
 pcl_ros::RadiusOutlierRemoval::RadiusOutlierRemoval(const rclcpp::NodeOptions& options)
-: Filter("RadiusOutlierRemovalNode", options)
+: Filter("RadiusOutlierRemovalNode", options, true)
 {
   rcl_interfaces::msg::ParameterDescriptor radius_search_desc;
   radius_search_desc.name = "radius_search";
@@ -60,11 +63,47 @@ pcl_ros::RadiusOutlierRemoval::RadiusOutlierRemoval(const rclcpp::NodeOptions& o
   min_neighbors_desc.integer_range.push_back (min_neighbors_range);
   declare_parameter(min_neighbors_desc.name, rclcpp::ParameterValue(5), min_neighbors_desc).get<int>();
 
+  rcl_interfaces::msg::ParameterDescriptor use_organized_desc;
+  use_organized_desc.name = "use_organized";
+  use_organized_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  use_organized_desc.description = "Use image-space neighborhoods instead of a kd-tree when the input is organized. Faster, but the neighbors are only searched in a pixel window.";
+  declare_parameter(use_organized_desc.name, rclcpp::ParameterValue(false), use_organized_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor organized_window_desc;
+  organized_window_desc.name = "organized_window";
+  organized_window_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  organized_window_desc.description = "Half size in pixels of the window searched for neighbors when the input is organized.";
+  rcl_interfaces::msg::IntegerRange organized_window_range;
+  organized_window_range.from_value = 1;
+  organized_window_range.to_value = 15;
+  organized_window_desc.integer_range.push_back (organized_window_range);
+  declare_parameter(organized_window_desc.name, rclcpp::ParameterValue(3), organized_window_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor approximate_desc;
+  approximate_desc.name = "approximate";
+  approximate_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  approximate_desc.description = "Count neighbors in the voxels of size radius_search around each point instead of searching a kd-tree (unorganized clouds).";
+  declare_parameter(approximate_desc.name, rclcpp::ParameterValue(false), approximate_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor refine_ratio_desc;
+  refine_ratio_desc.name = "refine_ratio";
+  refine_ratio_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  refine_ratio_desc.description = "With approximate, the neighbors of the points with less than refine_ratio * min_neighbors points in their voxel neighborhood are counted exactly. 1 to never count exactly.";
+  rcl_interfaces::msg::FloatingPointRange refine_ratio_range;
+  refine_ratio_range.from_value = 1.0;
+  refine_ratio_range.to_value = 100.0;
+  refine_ratio_desc.floating_point_range.push_back (refine_ratio_range);
+  declare_parameter(refine_ratio_desc.name, rclcpp::ParameterValue(2.0), refine_ratio_desc);
+
   callback_handle_ = add_on_set_parameters_callback (std::bind (&RadiusOutlierRemoval::config_callback, this, std::placeholders::_1));
 
   std::vector<std::string> param_names{
     radius_search_desc.name,
     min_neighbors_desc.name,
+    use_organized_desc.name,
+    organized_window_desc.name,
+    approximate_desc.name,
+    refine_ratio_desc.name,
   };
   auto result = config_callback(get_parameters(param_names));
   if (!result.successful) {
@@ -72,6 +111,128 @@ pcl_ros::RadiusOutlierRemoval::RadiusOutlierRemoval(const rclcpp::NodeOptions& o
   }
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::RadiusOutlierRemoval::filterOrganized (const PointCloud2 &input, const IndicesPtr &indices,
+                                                 std::vector<int> &output)
+{
+  int half_window;
+  double radius;
+  int min_neighbors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!use_organized_)
+      return (false);
+    half_window = organized_window_;
+    radius = impl_.getRadiusSearch ();
+    min_neighbors = impl_.getMinNeighborsInRadius ();
+  }
+
+  OrganizedNeighborhood neighborhood;
+  if (!neighborhood.setInputCloud (input))
+    return (false);
+  organizedRadiusOutlierRemoval (neighborhood, half_window, radius, min_neighbors, indices, output);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::RadiusOutlierRemoval::filterApproximate (const PointCloud2 &input, const IndicesPtr &indices,
+                                                   std::vector<int> &output)
+{
+  double radius, refine_ratio;
+  int min_neighbors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!approximate_)
+      return (false);
+    radius = impl_.getRadiusSearch ();
+    min_neighbors = impl_.getMinNeighborsInRadius ();
+    refine_ratio = refine_ratio_;
+  }
+  return (voxelRadiusOutlierRemoval (input, indices, radius, min_neighbors, refine_ratio, output));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::RadiusOutlierRemoval::filterSearchCache (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                                   std::vector<int> &output)
+{
+  // The searchers of the cache index all the points of the cloud: with indices, the points left out would count as
+  // neighbors
+  if (!use_search_cache_ || indices)
+    return (false);
+  double radius;
+  int min_neighbors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    radius = impl_.getRadiusSearch ();
+    min_neighbors = impl_.getMinNeighborsInRadius ();
+  }
+
+  const SearchCache::EntryConstPtr entry = SearchCache::instance ().get (input);
+  if (!entry)
+    return (false);
+
+  const SearchCache::Cloud &cloud = *entry->cloud;
+  std::vector<int> nn_indices;
+  std::vector<float> nn_sqr_distances;
+  output.clear ();
+  output.reserve (cloud.size ());
+  for (size_t index = 0; index < cloud.size (); ++index)
+  {
+    if (!pcl::isFinite (cloud.points[index]))
+      continue;
+    // Stop after the point itself and min_neighbors neighbors
+    const int k = entry->search->radiusSearch (static_cast<int> (index), radius, nn_indices, nn_sqr_distances,
+                                               static_cast<unsigned int> (min_neighbors + 1));
+    if (k > min_neighbors)
+      output.push_back (static_cast<int> (index));
+  }
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::RadiusOutlierRemoval::filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                       PointCloud2 &output)
+{
+  std::vector<int> kept;
+  if (filterOrganized (*input, indices, kept) || filterApproximate (*input, indices, kept) ||
+      filterSearchCache (input, indices, kept))
+  {
+    copyPoints (*input, kept, output);
+    return;
+  }
+
+  pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+  pcl_conversions::toPCL (*(input), *(pcl_input));
+  auto impl = impl_pool_.acquire();
+  impl->setInputCloud (pcl_input);
+  impl->setIndices (indices);
+  pcl::PCLPointCloud2 pcl_output;
+  impl->filter (pcl_output);
+  pcl_conversions::moveFromPCL(pcl_output, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::RadiusOutlierRemoval::filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                              std::vector<int> &output)
+{
+  if (filterOrganized (*input, indices, output) || filterApproximate (*input, indices, output) ||
+      filterSearchCache (input, indices, output))
+    return (true);
+
+  pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+  pcl_conversions::toPCL (*(input), *(pcl_input));
+  auto impl = impl_pool_.acquire();
+  impl->setInputCloud (pcl_input);
+  impl->setIndices (indices);
+  impl->filter (output);
+  return (true);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 rcl_interfaces::msg::SetParametersResult
 pcl_ros::RadiusOutlierRemoval::config_callback (const std::vector<rclcpp::Parameter> & params)
@@ -96,7 +257,29 @@ pcl_ros::RadiusOutlierRemoval::config_callback (const std::vector<rclcpp::Parame
         RCLCPP_DEBUG(get_logger(), "Setting the radius to search neighbors: %f.", param.as_double ());
       }
     }
+    else if (param.get_name () == "use_organized")
+    {
+      use_organized_ = param.as_bool ();
+      RCLCPP_DEBUG(get_logger(), "Using image-space neighborhoods for organized clouds: %s.", use_organized_ ? "true" : "false");
+    }
+    else if (param.get_name () == "organized_window")
+    {
+      organized_window_ = param.as_int ();
+      RCLCPP_DEBUG(get_logger(), "Setting the half size of the organized neighbor window to: %d.", organized_window_);
+    }
+    else if (param.get_name () == "approximate")
+    {
+      approximate_ = param.as_bool ();
+      RCLCPP_DEBUG(get_logger(), "Counting neighbors in voxels: %s.", approximate_ ? "true" : "false");
+    }
+    else if (param.get_name () == "refine_ratio")
+    {
+      refine_ratio_ = param.as_double ();
+      RCLCPP_DEBUG(get_logger(), "Setting the exact count ratio to: %f.", refine_ratio_);
+    }
   }
+  impl_pool_.invalidate();
+
   // TODO(sloretz) constraint validation
   rcl_interfaces::msg::SetParametersResult result;
   result.successful = true;
@@ -35,9 +35,211 @@
  *
  */
 
-#include "class_loader/register_macro.hpp"
+#include <cmath>
+#include <limits>
+#include <pcl/common/point_tests.h>
+#include "pcl_ros/filters/organized_neighborhood.hpp"
 #include "pcl_ros/filters/statistical_outlier_removal.hpp"
 
-typedef pcl_ros::StatisticalOutlierRemoval StatisticalOutlierRemoval;
-//CLASS_LOADER_REGISTER_CLASS(StatisticalOutlierRemoval, rclcpp::Node)
+pcl_ros::StatisticalOutlierRemoval::StatisticalOutlierRemoval(const rclcpp::NodeOptions& options)
+: Filter("StatisticalOutlierRemovalNode", options, true)
+{
+  rcl_interfaces::msg::ParameterDescriptor mean_k_desc;
+  mean_k_desc.name = "mean_k";
+  mean_k_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  mean_k_desc.description = "The number of points (k) to use for mean distance estimation.";
+  rcl_interfaces::msg::IntegerRange mean_k_range;
+  mean_k_range.from_value = 2;
+  mean_k_range.to_value = 100;
+  mean_k_desc.integer_range.push_back (mean_k_range);
+  declare_parameter(mean_k_desc.name, rclcpp::ParameterValue(2), mean_k_desc);
 
+  rcl_interfaces::msg::ParameterDescriptor stddev_desc;
+  stddev_desc.name = "stddev";
+  stddev_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  stddev_desc.description = "The standard deviation multiplier threshold. All points outside the mean +- sigma * std_mul will be considered outliers.";
+  rcl_interfaces::msg::FloatingPointRange stddev_range;
+  stddev_range.from_value = 0.0;
+  stddev_range.to_value = 5.0;
+  stddev_desc.floating_point_range.push_back (stddev_range);
+  declare_parameter(stddev_desc.name, rclcpp::ParameterValue(0.0), stddev_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor neg_desc;
+  neg_desc.name = "negative";
+  neg_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  neg_desc.description = "Set whether the inliers should be returned (false) or the outliers (true).";
+  declare_parameter(neg_desc.name, rclcpp::ParameterValue(false), neg_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor use_organized_desc;
+  use_organized_desc.name = "use_organized";
+  use_organized_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  use_organized_desc.description = "Use image-space neighborhoods instead of a kd-tree when the input is organized. Faster, but the neighbors are only searched in a pixel window.";
+  declare_parameter(use_organized_desc.name, rclcpp::ParameterValue(false), use_organized_desc);
+
+  callback_handle_ = add_on_set_parameters_callback (std::bind (&StatisticalOutlierRemoval::config_callback, this, std::placeholders::_1));
+
+  std::vector<std::string> param_names{
+    mean_k_desc.name,
+    stddev_desc.name,
+    neg_desc.name,
+    use_organized_desc.name,
+  };
+  auto result = config_callback(get_parameters(param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::StatisticalOutlierRemoval::filterOrganized (const PointCloud2 &input, const IndicesPtr &indices,
+                                                      std::vector<int> &output)
+{
+  int mean_k;
+  double stddev_mult;
+  bool negative;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!use_organized_)
+      return (false);
+    mean_k = impl_.getMeanK ();
+    stddev_mult = impl_.getStddevMulThresh ();
+    negative = impl_.getNegative ();
+  }
+
+  OrganizedNeighborhood neighborhood;
+  if (!neighborhood.setInputCloud (input))
+    return (false);
+  organizedStatisticalOutlierRemoval (neighborhood, mean_k, stddev_mult, negative, indices, output);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::StatisticalOutlierRemoval::filterSearchCache (const PointCloud2::ConstSharedPtr &input,
+                                                        const IndicesPtr &indices, std::vector<int> &output)
+{
+  // The searchers of the cache index all the points of the cloud: with indices, the points left out would count as
+  // neighbors
+  if (!use_search_cache_ || indices)
+    return (false);
+  int mean_k;
+  double stddev_mult;
+  bool negative;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mean_k = impl_.getMeanK ();
+    stddev_mult = impl_.getStddevMulThresh ();
+    negative = impl_.getNegative ();
+  }
+
+  const SearchCache::EntryConstPtr entry = SearchCache::instance ().get (input);
+  if (!entry)
+    return (false);
+
+  // Mean distance of every point to its mean_k nearest neighbors, as pcl::StatisticalOutlierRemoval
+  const SearchCache::Cloud &cloud = *entry->cloud;
+  std::vector<float> mean_distances (cloud.size (), std::numeric_limits<float>::quiet_NaN ());
+  std::vector<int> nn_indices (mean_k + 1);
+  std::vector<float> nn_sqr_distances (mean_k + 1);
+  for (size_t index = 0; index < cloud.size (); ++index)
+  {
+    if (!pcl::isFinite (cloud.points[index]))
+      continue;
+    // The first neighbor is the point itself
+    const int k = entry->search->nearestKSearch (static_cast<int> (index), mean_k + 1, nn_indices, nn_sqr_distances);
+    double sum = 0.0;
+    for (int i = 1; i < k; ++i)
+      sum += std::sqrt (nn_sqr_distances[i]);
+    mean_distances[index] = k > 1 ? static_cast<float> (sum / (k - 1)) : std::numeric_limits<float>::infinity ();
+  }
+  selectStatisticalInliers (mean_distances, stddev_mult, negative, indices, output);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::StatisticalOutlierRemoval::filter (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                            PointCloud2 &output)
+{
+  std::vector<int> kept;
+  if (filterOrganized (*input, indices, kept) || filterSearchCache (input, indices, kept))
+  {
+    copyPoints (*input, kept, output);
+    return;
+  }
+
+  pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+  pcl_conversions::toPCL(*(input), *(pcl_input));
+  auto impl = impl_pool_.acquire();
+  impl->setInputCloud (pcl_input);
+  impl->setIndices (indices);
+  pcl::PCLPointCloud2 pcl_output;
+  impl->filter (pcl_output);
+  pcl_conversions::moveFromPCL(pcl_output, output);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::StatisticalOutlierRemoval::filterIndices (const PointCloud2::ConstSharedPtr &input, const IndicesPtr &indices,
+                                                   std::vector<int> &output)
+{
+  if (filterOrganized (*input, indices, output) || filterSearchCache (input, indices, output))
+    return (true);
+
+  pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
+  pcl_conversions::toPCL (*(input), *(pcl_input));
+  auto impl = impl_pool_.acquire();
+  impl->setInputCloud (pcl_input);
+  impl->setIndices (indices);
+  impl->filter (output);
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::StatisticalOutlierRemoval::config_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "mean_k")
+    {
+      if (impl_.getMeanK () != param.as_int ())
+      {
+        impl_.setMeanK (param.as_int ());
+        RCLCPP_DEBUG(get_logger(), "Setting the number of points (k) to use for mean distance estimation to: %li.", param.as_int ());
+      }
+    }
+    else if (param.get_name () == "stddev")
+    {
+      if (impl_.getStddevMulThresh () != param.as_double ())
+      {
+        impl_.setStddevMulThresh (param.as_double ());
+        RCLCPP_DEBUG(get_logger(), "Setting the standard deviation multiplier threshold to: %f.", param.as_double ());
+      }
+    }
+    else if (param.get_name () == "negative")
+    {
+      if (impl_.getNegative () != param.as_bool ())
+      {
+        impl_.setNegative (param.as_bool ());
+        RCLCPP_DEBUG(get_logger(), "Returning only inliers: %s.", param.as_bool () ? "false" : "true");
+      }
+    }
+    else if (param.get_name () == "use_organized")
+    {
+      use_organized_ = param.as_bool ();
+      RCLCPP_DEBUG(get_logger(), "Using image-space neighborhoods for organized clouds: %s.", use_organized_ ? "true" : "false");
+    }
+  }
+  impl_pool_.invalidate();
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  return result;
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(pcl_ros::StatisticalOutlierRemoval)
@@ -46,14 +46,73 @@ pcl_ros::VoxelGrid::VoxelGrid(const rclcpp::NodeOptions &options)
   leaf_size_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
   leaf_size_desc.description = "The size of a leaf (on x,y,z) used for downsampling.";
   rcl_interfaces::msg::FloatingPointRange leaf_size_range;
-  leaf_size_range.from_value = 0;
-  leaf_size_range.to_value = 1.0;
+  leaf_size_range.from_value = 0.001;
+  leaf_size_range.to_value = 100.0;
   leaf_size_desc.floating_point_range.push_back(leaf_size_range);
   declare_parameter(leaf_size_desc.name, rclcpp::ParameterValue(0.01), leaf_size_desc);
 
   std::vector<std::string> param_names{
       leaf_size_desc.name,
   };
+
+  for (const std::string axis : {"x", "y", "z"})
+  {
+    rcl_interfaces::msg::ParameterDescriptor leaf_size_axis_desc;
+    leaf_size_axis_desc.name = "leaf_size_" + axis;
+    leaf_size_axis_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+    leaf_size_axis_desc.description = "The size of a leaf on " + axis + ", overriding leaf_size if set.";
+    leaf_size_axis_desc.floating_point_range.push_back(leaf_size_range);
+    // Not set by default: leaf_size applies
+    leaf_size_axis_desc.dynamic_typing = true;
+    declare_parameter(leaf_size_axis_desc.name, rclcpp::ParameterValue(), leaf_size_axis_desc);
+    param_names.push_back(leaf_size_axis_desc.name);
+  }
+
+  rcl_interfaces::msg::ParameterDescriptor min_points_per_voxel_desc;
+  min_points_per_voxel_desc.name = "min_points_per_voxel";
+  min_points_per_voxel_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  min_points_per_voxel_desc.description = "The minimum number of points in a voxel for it to be output.";
+  rcl_interfaces::msg::IntegerRange min_points_per_voxel_range;
+  min_points_per_voxel_range.from_value = 0;
+  min_points_per_voxel_range.to_value = 100000;
+  min_points_per_voxel_desc.integer_range.push_back(min_points_per_voxel_range);
+  declare_parameter(min_points_per_voxel_desc.name, rclcpp::ParameterValue(0), min_points_per_voxel_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor downsample_all_data_desc;
+  downsample_all_data_desc.name = "downsample_all_data";
+  downsample_all_data_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  downsample_all_data_desc.description = "Set to false to only output the x, y and z fields.";
+  declare_parameter(downsample_all_data_desc.name, rclcpp::ParameterValue(true), downsample_all_data_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor output_mode_desc;
+  output_mode_desc.name = "output_mode";
+  output_mode_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  output_mode_desc.description = "The point output for each voxel: \"centroid\", \"nearest\" (the input point nearest to the centroid) or \"first\" (the first input point). \"nearest\" and \"first\" require the hash method.";
+  declare_parameter(output_mode_desc.name, rclcpp::ParameterValue("centroid"), output_mode_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor method_desc;
+  method_desc.name = "method";
+  method_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  method_desc.description = "The downsampling engine: \"pcl\" (pcl::VoxelGrid) or \"hash\" (multi-threaded voxel hashing on the message buffer).";
+  declare_parameter(method_desc.name, rclcpp::ParameterValue("pcl"), method_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor num_threads_desc;
+  num_threads_desc.name = "num_threads";
+  num_threads_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  num_threads_desc.description = "The maximum number of threads used by the \"hash\" method, 0 for the number of cores.";
+  rcl_interfaces::msg::IntegerRange num_threads_range;
+  num_threads_range.from_value = 0;
+  num_threads_range.to_value = 64;
+  num_threads_desc.integer_range.push_back(num_threads_range);
+  declare_parameter(num_threads_desc.name, rclcpp::ParameterValue(0), num_threads_desc);
+
+  param_names.insert(param_names.end(), {
+      min_points_per_voxel_desc.name,
+      downsample_all_data_desc.name,
+      output_mode_desc.name,
+      method_desc.name,
+      num_threads_desc.name,
+  });
   auto result = config_callback(get_parameters(param_names));
   if (!result.successful)
   {
@@ -66,13 +125,28 @@ void pcl_ros::VoxelGrid::filter(const PointCloud2::ConstSharedPtr &input,
                                 const IndicesPtr &indices,
                                 PointCloud2 &output)
 {
-  std::lock_guard<std::mutex> lock(mutex_);
+  bool use_hash;
+  VoxelHashGrid hash_impl;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    use_hash = use_hash_;
+    hash_impl = hash_impl_;
+  }
+  if (use_hash)
+  {
+    if (hash_impl.filter(*input, indices, output))
+      return;
+    RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000,
+                         "[filter] The hash method needs a little endian cloud with FLOAT32 x, y and z fields! Falling back to pcl::VoxelGrid (centroid).");
+  }
+
   pcl::PCLPointCloud2::Ptr pcl_input(new pcl::PCLPointCloud2);
   pcl_conversions::toPCL(*(input), *(pcl_input));
-  impl_.setInputCloud(pcl_input);
-  impl_.setIndices(indices);
+  auto impl = impl_pool_.acquire();
+  impl->setInputCloud(pcl_input);
+  impl->setIndices(indices);
   pcl::PCLPointCloud2 pcl_output;
-  impl_.filter(pcl_output);
+  impl->filter(pcl_output);
   pcl_conversions::moveFromPCL(pcl_output, output);
 }
 
@@ -82,24 +156,114 @@ pcl_ros::VoxelGrid::config_callback(const std::vector<rclcpp::Parameter> &params
 {
   std::lock_guard<std::mutex> lock(mutex_);
 
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+
+  // Validate all the parameters first, nothing is applied if any is rejected
+  bool use_hash = use_hash_;
+  VoxelHashGrid::Representative representative = hash_impl_.getRepresentative();
+  for (const rclcpp::Parameter &param : params)
+  {
+    for (int d = 0; d < 3; ++d)
+    {
+      if (param.get_name() == std::string("leaf_size_") + static_cast<char>('x' + d) &&
+          param.get_type() != rclcpp::ParameterType::PARAMETER_NOT_SET &&
+          param.get_type() != rclcpp::ParameterType::PARAMETER_DOUBLE)
+      {
+        result.successful = false;
+        result.reason = param.get_name() + " must be a double.";
+        return result;
+      }
+    }
+    if (param.get_name() == "output_mode")
+    {
+      const std::string output_mode = param.as_string();
+      if (output_mode == "centroid")
+        representative = VoxelHashGrid::CENTROID;
+      else if (output_mode == "nearest")
+        representative = VoxelHashGrid::NEAREST;
+      else if (output_mode == "first")
+        representative = VoxelHashGrid::FIRST;
+      else
+      {
+        result.successful = false;
+        result.reason = "Unknown output mode \"" + output_mode + "\", expected \"centroid\", \"nearest\" or \"first\".";
+        return result;
+      }
+    }
+    if (param.get_name() == "method")
+    {
+      const std::string method = param.as_string();
+      if (method != "pcl" && method != "hash")
+      {
+        result.successful = false;
+        result.reason = "Unknown method \"" + method + "\", expected \"pcl\" or \"hash\".";
+        return result;
+      }
+      use_hash = (method == "hash");
+    }
+  }
+  if (!use_hash && representative != VoxelHashGrid::CENTROID)
+  {
+    result.successful = false;
+    result.reason = "pcl::VoxelGrid only outputs centroids, output_mode \"nearest\" and \"first\" require method \"hash\".";
+    return result;
+  }
+
   for (const rclcpp::Parameter &param : params)
   {
     if (param.get_name() == "leaf_size")
     {
-      const double current_size = impl_.getLeafSize()[0];
-      const double new_size = param.as_double();
-      if (current_size != new_size)
+      leaf_size_ = param.as_double();
+    }
+    for (int d = 0; d < 3; ++d)
+    {
+      if (param.get_name() == std::string("leaf_size_") + static_cast<char>('x' + d))
       {
-        impl_.setLeafSize(new_size, new_size, new_size);
-        RCLCPP_DEBUG(get_logger(), "Setting the leaf size to: %f.", new_size);
+        leaf_size_xyz_[d] = param.get_type() == rclcpp::ParameterType::PARAMETER_DOUBLE ? param.as_double() : 0.0;
       }
     }
+    if (param.get_name() == "min_points_per_voxel")
+    {
+      impl_.setMinimumPointsNumberPerVoxel(static_cast<unsigned int>(param.as_int()));
+      hash_impl_.setMinimumPointsNumberPerVoxel(static_cast<unsigned int>(param.as_int()));
+      RCLCPP_DEBUG(get_logger(), "Setting the minimum number of points per voxel to: %ld.", param.as_int());
+    }
+    if (param.get_name() == "downsample_all_data")
+    {
+      impl_.setDownsampleAllData(param.as_bool());
+      hash_impl_.setDownsampleAllData(param.as_bool());
+      RCLCPP_DEBUG(get_logger(), "Setting downsample all data to: %s.", (param.as_bool() ? "true" : "false"));
+    }
+    if (param.get_name() == "num_threads")
+    {
+      hash_impl_.setNumberOfThreads(static_cast<unsigned int>(param.as_int()));
+      RCLCPP_DEBUG(get_logger(), "Setting the number of threads to: %ld.", param.as_int());
+    }
   }
-  // TODO(sloretz) constraint validation
-  rcl_interfaces::msg::SetParametersResult result;
-  result.successful = true;
+  if (representative != hash_impl_.getRepresentative())
+  {
+    hash_impl_.setRepresentative(representative);
+    RCLCPP_DEBUG(get_logger(), "Setting the output mode to: %d.", static_cast<int>(representative));
+  }
+  if (use_hash_ != use_hash)
+  {
+    use_hash_ = use_hash;
+    RCLCPP_DEBUG(get_logger(), "Setting the downsampling method to: %s.", use_hash_ ? "hash" : "pcl");
+  }
+
+  // The axis specific leaf sizes override leaf_size
+  float leaf_size[3];
+  for (int d = 0; d < 3; ++d)
+    leaf_size[d] = static_cast<float>(leaf_size_xyz_[d] > 0 ? leaf_size_xyz_[d] : leaf_size_);
+  const Eigen::Vector3f current_size = impl_.getLeafSize();
+  if (current_size != Eigen::Vector3f(leaf_size[0], leaf_size[1], leaf_size[2]))
+  {
+    impl_.setLeafSize(leaf_size[0], leaf_size[1], leaf_size[2]);
+    hash_impl_.setLeafSize(leaf_size[0], leaf_size[1], leaf_size[2]);
+    RCLCPP_DEBUG(get_logger(), "Setting the leaf size to: %f, %f, %f.", leaf_size[0], leaf_size[1], leaf_size[2]);
+  }
+  impl_pool_.invalidate();
+
   return result;
 }
-
-#include "rclcpp_components/register_node_macro.hpp"
-RCLCPP_COMPONENTS_REGISTER_NODE(pcl_ros::VoxelGrid)
@@ -0,0 +1,574 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <thread>
+#include "pcl_ros/filters/voxel_hash.hpp"
+
+// Out of line definition, npos is bound to references (C++14)
+constexpr uint32_t pcl_ros::VoxelHashMap::npos;
+
+using sensor_msgs::msg::PointField;
+
+namespace
+{
+  /** \brief Minimum number of points worth an additional thread. */
+  const size_t kMinPointsPerThread = 50000;
+
+  /** \brief How a field of the voxel point is computed from the field of its points. */
+  enum Reduction
+  {
+    AVERAGE,      // FLOAT32 and FLOAT64 fields
+    AVERAGE_RGB,  // packed rgb/rgba, averaged per byte
+    FIRST         // anything else
+  };
+
+  struct FieldPlan
+  {
+    uint32_t offset;
+    uint8_t datatype;
+    uint32_t count;
+    Reduction reduction;
+    /** \brief Index of the first accumulator of the field. */
+    size_t accumulator;
+    /** \brief Offset of the field in the output points. */
+    uint32_t output_offset;
+  };
+
+  /** \brief The voxels of one partition, as accumulated by one thread. */
+  struct Partial
+  {
+    pcl_ros::VoxelHashMap map;
+    std::vector<pcl_ros::VoxelKey> keys;
+    std::vector<double> sums;
+    std::vector<uint32_t> counts;
+    /** \brief Index of the first point of each voxel in the input. */
+    std::vector<uint32_t> first;
+  };
+
+  /** \brief Run f (task) for task in [0; nr_tasks), on nr_threads threads. */
+  template <typename F> void
+  parallelFor (size_t nr_tasks, size_t nr_threads, const F &f)
+  {
+    if (nr_threads <= 1)
+    {
+      for (size_t task = 0; task < nr_tasks; ++task)
+        f (task);
+      return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve (nr_threads);
+    for (size_t thread = 0; thread < nr_threads; ++thread)
+    {
+      threads.emplace_back ([&f, thread, nr_tasks, nr_threads]
+      {
+        for (size_t task = thread; task < nr_tasks; task += nr_threads)
+          f (task);
+      });
+    }
+    for (std::thread &thread : threads)
+      thread.join ();
+  }
+
+  inline void
+  accumulate (const uint8_t *point, const std::vector<FieldPlan> &plan, double *sum)
+  {
+    for (const FieldPlan &field : plan)
+    {
+      const uint8_t *data = point + field.offset;
+      double *field_sum = sum + field.accumulator;
+      if (field.reduction == AVERAGE && field.datatype == PointField::FLOAT32)
+      {
+        for (uint32_t c = 0; c < field.count; ++c)
+        {
+          float value;
+          memcpy (&value, data + c * sizeof (float), sizeof (float));
+          field_sum[c] += value;
+        }
+      }
+      else if (field.reduction == AVERAGE)
+      {
+        for (uint32_t c = 0; c < field.count; ++c)
+        {
+          double value;
+          memcpy (&value, data + c * sizeof (double), sizeof (double));
+          field_sum[c] += value;
+        }
+      }
+      else if (field.reduction == AVERAGE_RGB)
+      {
+        for (int c = 0; c < 4; ++c)
+          field_sum[c] += data[c];
+      }
+    }
+  }
+
+  inline void
+  average (const double *sum, uint32_t count, const std::vector<FieldPlan> &plan, uint8_t *point)
+  {
+    const double inverse_count = 1.0 / count;
+    for (const FieldPlan &field : plan)
+    {
+      uint8_t *data = point + field.output_offset;
+      const double *field_sum = sum + field.accumulator;
+      if (field.reduction == AVERAGE && field.datatype == PointField::FLOAT32)
+      {
+        for (uint32_t c = 0; c < field.count; ++c)
+        {
+          const float value = static_cast<float> (field_sum[c] * inverse_count);
+          memcpy (data + c * sizeof (float), &value, sizeof (float));
+        }
+      }
+      else if (field.reduction == AVERAGE)
+      {
+        for (uint32_t c = 0; c < field.count; ++c)
+        {
+          const double value = field_sum[c] * inverse_count;
+          memcpy (data + c * sizeof (double), &value, sizeof (double));
+        }
+      }
+      else if (field.reduction == AVERAGE_RGB)
+      {
+        for (int c = 0; c < 4; ++c)
+          data[c] = static_cast<uint8_t> (field_sum[c] * inverse_count + 0.5);
+      }
+    }
+  }
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::VoxelHashGrid::filter (const sensor_msgs::msg::PointCloud2 &input,
+                                const std::shared_ptr<const std::vector<int> > &indices,
+                                sensor_msgs::msg::PointCloud2 &output) const
+{
+  if (input.is_bigendian || !(leaf_size_[0] > 0 && leaf_size_[1] > 0 && leaf_size_[2] > 0))
+    return (false);
+
+  // Build the reduction plan of every field. Only the centroid of all the data needs every field, the other modes
+  // accumulate x, y and z at most.
+  const bool average_all = (representative_ == CENTROID && downsample_all_data_);
+  int xyz_offset[3] = {-1, -1, -1};
+  std::vector<FieldPlan> plan;
+  size_t nr_accumulators = 0;
+  for (const PointField &field : input.fields)
+  {
+    const uint32_t count = std::max<uint32_t> (field.count, 1);
+    for (int d = 0; d < 3; ++d)
+    {
+      if (field.name == std::string (1, static_cast<char> ('x' + d)) && field.datatype == PointField::FLOAT32)
+        xyz_offset[d] = field.offset;
+    }
+    if (!average_all)
+      continue;
+    if (field.datatype == PointField::FLOAT32 || field.datatype == PointField::FLOAT64)
+    {
+      const bool packed_rgb = (field.name == "rgb" || field.name == "rgba") && field.datatype == PointField::FLOAT32 && count == 1;
+      plan.push_back ({field.offset, field.datatype, count, packed_rgb ? AVERAGE_RGB : AVERAGE, nr_accumulators,
+                       field.offset});
+      nr_accumulators += packed_rgb ? 4 : count;
+    }
+    else if ((field.name == "rgb" || field.name == "rgba") && field.datatype == PointField::UINT32 && count == 1)
+    {
+      plan.push_back ({field.offset, field.datatype, count, AVERAGE_RGB, nr_accumulators, field.offset});
+      nr_accumulators += 4;
+    }
+  }
+  if (xyz_offset[0] < 0 || xyz_offset[1] < 0 || xyz_offset[2] < 0)
+    return (false);
+  if (!average_all && representative_ != FIRST)
+  {
+    // x, y and z in the first three accumulators
+    for (uint32_t d = 0; d < 3; ++d)
+    {
+      const uint32_t output_offset = downsample_all_data_ ? static_cast<uint32_t> (xyz_offset[d]) : d * sizeof (float);
+      plan.push_back ({static_cast<uint32_t> (xyz_offset[d]), PointField::FLOAT32, 1, AVERAGE, d, output_offset});
+    }
+    nr_accumulators = 3;
+  }
+
+  const size_t nr_points = static_cast<size_t> (input.width) * input.height;
+  const size_t point_step = input.point_step;
+  if (input.data.size () < nr_points * point_step)
+    return (false);
+  const size_t nr_selected = indices ? indices->size () : nr_points;
+  const float inverse_leaf_size[3] = {1.0f / leaf_size_[0], 1.0f / leaf_size_[1], 1.0f / leaf_size_[2]};
+
+  size_t nr_threads = nr_threads_ > 0 ? nr_threads_ : std::max (1u, std::thread::hardware_concurrency ());
+  nr_threads = std::max<size_t> (1, std::min (nr_threads, nr_selected / kMinPointsPerThread));
+  // One partition per thread for the merge
+  const size_t nr_partitions = nr_threads;
+
+  // Call f (index, point, xyz, key, hash) for every valid point of the chunk of a thread
+  auto for_each_point = [&] (size_t thread, const auto &f)
+  {
+    const size_t begin = nr_selected * thread / nr_threads;
+    const size_t end = nr_selected * (thread + 1) / nr_threads;
+    for (size_t n = begin; n < end; ++n)
+    {
+      const size_t index = indices ? static_cast<size_t> ((*indices)[n]) : n;
+      if (index >= nr_points)
+        continue;
+      const uint8_t *point = &input.data[index * point_step];
+
+      float xyz[3];
+      for (int d = 0; d < 3; ++d)
+        memcpy (&xyz[d], point + xyz_offset[d], sizeof (float));
+      VoxelKey key;
+      if (!computeVoxelKey (xyz[0], xyz[1], xyz[2], inverse_leaf_size, key))
+        continue;
+      f (index, point, xyz, key, key.hash ());
+    }
+  };
+  auto partition_of = [nr_partitions] (uint64_t hash)
+  {
+    return (((hash >> 32) * nr_partitions) >> 32);
+  };
+
+  // 1. Accumulate the chunks into per thread, per partition tables
+  std::vector<Partial> partials (nr_threads * nr_partitions);
+  parallelFor (nr_threads, nr_threads, [&] (size_t thread)
+  {
+    Partial *thread_partials = &partials[thread * nr_partitions];
+    for_each_point (thread, [&] (size_t index, const uint8_t *point, const float *, const VoxelKey &key, uint64_t hash)
+    {
+      Partial &partial = thread_partials[partition_of (hash)];
+      bool inserted;
+      const uint32_t id = partial.map.insert (key, hash, inserted);
+      if (inserted)
+      {
+        partial.keys.push_back (key);
+        partial.sums.resize (partial.sums.size () + nr_accumulators, 0.0);
+        partial.counts.push_back (0);
+        partial.first.push_back (static_cast<uint32_t> (index));
+      }
+      accumulate (point, plan, partial.sums.data () + id * nr_accumulators);
+      ++partial.counts[id];
+    });
+  });
+
+  // 2. Merge each partition into the partial of the first thread. The chunks are in order, so the first point of a
+  // voxel is the one of the first thread that saw it.
+  parallelFor (nr_partitions, nr_threads, [&] (size_t partition)
+  {
+    Partial &result = partials[partition];
+    for (size_t thread = 1; thread < nr_threads; ++thread)
+    {
+      const Partial &partial = partials[thread * nr_partitions + partition];
+      for (size_t j = 0; j < partial.keys.size (); ++j)
+      {
+        bool inserted;
+        const uint32_t id = result.map.insert (partial.keys[j], inserted);
+        if (inserted)
+        {
+          result.keys.push_back (partial.keys[j]);
+          result.sums.insert (result.sums.end (), partial.sums.begin () + j * nr_accumulators,
+                              partial.sums.begin () + (j + 1) * nr_accumulators);
+          result.counts.push_back (partial.counts[j]);
+          result.first.push_back (partial.first[j]);
+          continue;
+        }
+        for (size_t k = 0; k < nr_accumulators; ++k)
+          result.sums[id * nr_accumulators + k] += partial.sums[j * nr_accumulators + k];
+        result.counts[id] += partial.counts[j];
+      }
+    }
+  });
+
+  // Global id of the first voxel of each partition, and of the first output point of each partition
+  std::vector<size_t> voxel_offsets (nr_partitions + 1, 0);
+  std::vector<size_t> output_offsets (nr_partitions + 1, 0);
+  for (size_t partition = 0; partition < nr_partitions; ++partition)
+  {
+    const std::vector<uint32_t> &counts = partials[partition].counts;
+    const size_t nr_kept = std::count_if (counts.begin (), counts.end (),
+                                          [this] (uint32_t count) { return (count >= min_points_per_voxel_); });
+    voxel_offsets[partition + 1] = voxel_offsets[partition] + counts.size ();
+    output_offsets[partition + 1] = output_offsets[partition] + nr_kept;
+  }
+
+  // 3. Replace the first point of each voxel by the point nearest to its centroid. Each thread keeps its own nearest
+  // point per voxel; ties go to the earliest point, so the result does not depend on the number of threads.
+  if (representative_ == NEAREST)
+  {
+    const size_t nr_voxels = voxel_offsets.back ();
+    std::vector<std::vector<std::pair<float, uint32_t> > > nearest (nr_threads);
+    parallelFor (nr_threads, nr_threads, [&] (size_t thread)
+    {
+      std::vector<std::pair<float, uint32_t> > &thread_nearest = nearest[thread];
+      thread_nearest.assign (nr_voxels, std::make_pair (std::numeric_limits<float>::max (), 0u));
+      for_each_point (thread, [&] (size_t index, const uint8_t *, const float *xyz, const VoxelKey &key, uint64_t hash)
+      {
+        const size_t partition = partition_of (hash);
+        const Partial &result = partials[partition];
+        const uint32_t id = result.map.find (key, hash);
+        const double *sum = result.sums.data () + id * nr_accumulators;
+        const double inverse_count = 1.0 / result.counts[id];
+        float distance = 0;
+        for (int d = 0; d < 3; ++d)
+        {
+          const float delta = xyz[d] - static_cast<float> (sum[d] * inverse_count);
+          distance += delta * delta;
+        }
+        std::pair<float, uint32_t> &best = thread_nearest[voxel_offsets[partition] + id];
+        if (distance < best.first)
+          best = std::make_pair (distance, static_cast<uint32_t> (index));
+      });
+    });
+    parallelFor (nr_partitions, nr_threads, [&] (size_t partition)
+    {
+      Partial &result = partials[partition];
+      for (size_t j = 0; j < result.counts.size (); ++j)
+      {
+        std::pair<float, uint32_t> best = nearest[0][voxel_offsets[partition] + j];
+        for (size_t thread = 1; thread < nr_threads; ++thread)
+        {
+          if (nearest[thread][voxel_offsets[partition] + j].first < best.first)
+            best = nearest[thread][voxel_offsets[partition] + j];
+        }
+        result.first[j] = best.second;
+      }
+    });
+  }
+
+  // 4. Write one point per voxel
+  const size_t nr_output = output_offsets.back ();
+  const size_t output_step = downsample_all_data_ ? point_step : 4 * sizeof (float);
+  output.header = input.header;
+  if (downsample_all_data_)
+  {
+    output.fields = input.fields;
+  }
+  else
+  {
+    output.fields.resize (3);
+    for (uint32_t d = 0; d < 3; ++d)
+    {
+      output.fields[d].name = std::string (1, static_cast<char> ('x' + d));
+      output.fields[d].offset = d * sizeof (float);
+      output.fields[d].datatype = PointField::FLOAT32;
+      output.fields[d].count = 1;
+    }
+  }
+  output.is_bigendian = false;
+  output.point_step = static_cast<uint32_t> (output_step);
+  output.height = 1;
+  output.width = static_cast<uint32_t> (nr_output);
+  output.row_step = static_cast<uint32_t> (nr_output * output_step);
+  output.is_dense = true;
+  output.data.assign (nr_output * output_step, 0);
+
+  parallelFor (nr_partitions, nr_threads, [&] (size_t partition)
+  {
+    const Partial &result = partials[partition];
+    uint8_t *point = output.data.data () + output_offsets[partition] * output_step;
+    for (size_t j = 0; j < result.counts.size (); ++j)
+    {
+      if (result.counts[j] < min_points_per_voxel_)
+        continue;
+      const uint8_t *source = &input.data[static_cast<size_t> (result.first[j]) * point_step];
+      if (downsample_all_data_)
+      {
+        memcpy (point, source, point_step);
+      }
+      else
+      {
+        for (int d = 0; d < 3; ++d)
+          memcpy (point + d * sizeof (float), source + xyz_offset[d], sizeof (float));
+      }
+      if (representative_ == CENTROID)
+        average (result.sums.data () + j * nr_accumulators, result.counts[j], plan, point);
+      point += output_step;
+    }
+  });
+  return (true);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+bool
+pcl_ros::voxelRadiusOutlierRemoval (const sensor_msgs::msg::PointCloud2 &input,
+                                    const std::shared_ptr<const std::vector<int> > &indices, double radius,
+                                    int min_neighbors, double refine_ratio, std::vector<int> &output)
+{
+  if (input.is_bigendian || !(radius > 0))
+    return (false);
+  int xyz_offset[3] = {-1, -1, -1};
+  for (const PointField &field : input.fields)
+  {
+    for (int d = 0; d < 3; ++d)
+    {
+      if (field.name == std::string (1, static_cast<char> ('x' + d)) && field.datatype == PointField::FLOAT32)
+        xyz_offset[d] = field.offset;
+    }
+  }
+  if (xyz_offset[0] < 0 || xyz_offset[1] < 0 || xyz_offset[2] < 0)
+    return (false);
+
+  const size_t nr_points = static_cast<size_t> (input.width) * input.height;
+  const size_t point_step = input.point_step;
+  if (input.data.size () < nr_points * point_step)
+    return (false);
+  const size_t nr_selected = indices ? indices->size () : nr_points;
+  output.clear ();
+  if (min_neighbors <= 0)
+  {
+    // Every valid point is an inlier, as with a radius search
+    for (size_t n = 0; n < nr_selected; ++n)
+    {
+      const size_t index = indices ? static_cast<size_t> ((*indices)[n]) : n;
+      if (index >= nr_points)
+        continue;
+      const uint8_t *point = &input.data[index * point_step];
+      float xyz[3];
+      for (int d = 0; d < 3; ++d)
+        memcpy (&xyz[d], point + xyz_offset[d], sizeof (float));
+      if (std::isfinite (xyz[0]) && std::isfinite (xyz[1]) && std::isfinite (xyz[2]))
+        output.push_back (static_cast<int> (index));
+    }
+    return (true);
+  }
+
+  // Bin the points
+  const float inverse_leaf_size[3] = {static_cast<float> (1.0 / radius), static_cast<float> (1.0 / radius),
+                                      static_cast<float> (1.0 / radius)};
+  VoxelHashMap map (nr_selected / 4);
+  std::vector<VoxelKey> keys;
+  std::vector<uint32_t> counts;
+  std::vector<uint32_t> point_voxel (nr_selected, VoxelHashMap::npos);
+  std::vector<float> point_xyz (3 * nr_selected);
+  for (size_t n = 0; n < nr_selected; ++n)
+  {
+    const size_t index = indices ? static_cast<size_t> ((*indices)[n]) : n;
+    if (index >= nr_points)
+      continue;
+    const uint8_t *point = &input.data[index * point_step];
+    float *xyz = &point_xyz[3 * n];
+    for (int d = 0; d < 3; ++d)
+      memcpy (&xyz[d], point + xyz_offset[d], sizeof (float));
+    VoxelKey key;
+    if (!(std::isfinite (xyz[0]) && std::isfinite (xyz[1]) && std::isfinite (xyz[2])) ||
+        !computeVoxelKey (xyz[0], xyz[1], xyz[2], inverse_leaf_size, key))
+      continue;
+    bool inserted;
+    const uint32_t voxel = map.insert (key, inserted);
+    if (inserted)
+    {
+      keys.push_back (key);
+      counts.push_back (0);
+    }
+    ++counts[voxel];
+    point_voxel[n] = voxel;
+  }
+
+  // Sort the points by voxel (counting sort), for the exact counts
+  const size_t nr_voxels = keys.size ();
+  std::vector<uint32_t> begin (nr_voxels + 1, 0);
+  for (size_t v = 0; v < nr_voxels; ++v)
+    begin[v + 1] = begin[v] + counts[v];
+  std::vector<float> sorted_xyz (3 * static_cast<size_t> (begin[nr_voxels]));
+  std::vector<uint32_t> sorted_points (begin[nr_voxels]);
+  {
+    std::vector<uint32_t> next (begin.begin (), begin.end () - 1);
+    for (size_t n = 0; n < nr_selected; ++n)
+    {
+      if (point_voxel[n] == VoxelHashMap::npos)
+        continue;
+      const uint32_t slot = next[point_voxel[n]]++;
+      memcpy (&sorted_xyz[3 * static_cast<size_t> (slot)], &point_xyz[3 * n], 3 * sizeof (float));
+      sorted_points[slot] = static_cast<uint32_t> (n);
+    }
+  }
+
+  // Classify the points voxel by voxel
+  const uint64_t threshold = static_cast<uint64_t> (min_neighbors);
+  const double refine_bound = std::max (refine_ratio, 1.0) * min_neighbors;
+  const float sqr_radius = static_cast<float> (radius * radius);
+  std::vector<uint8_t> inlier (nr_selected, 0);
+  uint32_t neighbors[27];
+  for (size_t v = 0; v < nr_voxels; ++v)
+  {
+    int nr_neighbors = 0;
+    uint64_t bound = 0;
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+      for (int dy = -1; dy <= 1; ++dy)
+      {
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+          const VoxelKey key = {keys[v].x + dx, keys[v].y + dy, keys[v].z + dz};
+          const uint32_t neighbor = map.find (key);
+          if (neighbor == VoxelHashMap::npos)
+            continue;
+          neighbors[nr_neighbors++] = neighbor;
+          bound += counts[neighbor];
+        }
+      }
+    }
+    // The point itself is not a neighbor
+    bound -= 1;
+    if (bound < threshold)
+      continue;
+
+    for (uint32_t slot = begin[v]; slot < begin[v + 1]; ++slot)
+    {
+      if (static_cast<double> (bound) >= refine_bound)
+      {
+        inlier[sorted_points[slot]] = 1;
+        continue;
+      }
+      const float *p = &sorted_xyz[3 * static_cast<size_t> (slot)];
+      // Counts the point itself
+      uint64_t found = 0;
+      for (int i = 0; i < nr_neighbors && found <= threshold; ++i)
+      {
+        const uint32_t last = begin[neighbors[i] + 1];
+        for (uint32_t other = begin[neighbors[i]]; other < last; ++other)
+        {
+          const float *q = &sorted_xyz[3 * static_cast<size_t> (other)];
+          const float ex = p[0] - q[0], ey = p[1] - q[1], ez = p[2] - q[2];
+          found += (ex * ex + ey * ey + ez * ez <= sqr_radius);
+        }
+      }
+      inlier[sorted_points[slot]] = (found > threshold);
+    }
+  }
+
+  output.reserve (nr_selected);
+  for (size_t n = 0; n < nr_selected; ++n)
+  {
+    if (inlier[n])
+      output.push_back (indices ? (*indices)[n] : static_cast<int> (n));
+  }
+  return (true);
+}
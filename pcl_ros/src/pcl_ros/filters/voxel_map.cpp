@@ -0,0 +1,321 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <tf2/exceptions.h>
+#include <tf2_ros/buffer.h>
+#include "pcl_ros/transforms.hpp"
+#include "pcl_ros/filters/voxel_map.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::VoxelMap::VoxelMap(const rclcpp::NodeOptions &options)
+    : PCLNode("VoxelMapNode", options)
+{
+  rcl_interfaces::msg::ParameterDescriptor map_frame_desc;
+  map_frame_desc.name = "map_frame";
+  map_frame_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  map_frame_desc.description = "The TF frame the map is built and published in.";
+  map_frame_desc.read_only = true;
+  map_frame_ = declare_parameter(map_frame_desc.name, std::string("map"), map_frame_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor leaf_size_desc;
+  leaf_size_desc.name = "leaf_size";
+  leaf_size_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  leaf_size_desc.description = "The size of the map voxels (on x,y,z).";
+  leaf_size_desc.read_only = true;
+  rcl_interfaces::msg::FloatingPointRange leaf_size_range;
+  leaf_size_range.from_value = 0.001;
+  leaf_size_range.to_value = 100.0;
+  leaf_size_desc.floating_point_range.push_back(leaf_size_range);
+  leaf_size_ = declare_parameter(leaf_size_desc.name, leaf_size_, leaf_size_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor publish_rate_desc;
+  publish_rate_desc.name = "publish_rate";
+  publish_rate_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  publish_rate_desc.description = "The rate the map is published at, in Hz. Eviction runs at the same rate.";
+  publish_rate_desc.read_only = true;
+  rcl_interfaces::msg::FloatingPointRange publish_rate_range;
+  publish_rate_range.from_value = 0.01;
+  publish_rate_range.to_value = 100.0;
+  publish_rate_desc.floating_point_range.push_back(publish_rate_range);
+  const double publish_rate = declare_parameter(publish_rate_desc.name, 1.0, publish_rate_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor max_radius_desc;
+  max_radius_desc.name = "max_radius";
+  max_radius_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  max_radius_desc.description = "Voxels further than this distance from the origin of the latest scan are evicted, 0 to disable.";
+  rcl_interfaces::msg::FloatingPointRange max_radius_range;
+  max_radius_range.from_value = 0.0;
+  max_radius_range.to_value = 100000.0;
+  max_radius_desc.floating_point_range.push_back(max_radius_range);
+  declare_parameter(max_radius_desc.name, rclcpp::ParameterValue(max_radius_), max_radius_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor max_age_desc;
+  max_age_desc.name = "max_age";
+  max_age_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  max_age_desc.description = "Voxels not hit by a scan for this long (in seconds of scan time) are evicted, 0 to disable.";
+  rcl_interfaces::msg::FloatingPointRange max_age_range;
+  max_age_range.from_value = 0.0;
+  max_age_range.to_value = 100000.0;
+  max_age_desc.floating_point_range.push_back(max_age_range);
+  declare_parameter(max_age_desc.name, rclcpp::ParameterValue(max_age_), max_age_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor max_points_per_voxel_desc;
+  max_points_per_voxel_desc.name = "max_points_per_voxel";
+  max_points_per_voxel_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  max_points_per_voxel_desc.description = "The number of points after which the centroid of a voxel is frozen.";
+  rcl_interfaces::msg::IntegerRange max_points_per_voxel_range;
+  max_points_per_voxel_range.from_value = 1;
+  max_points_per_voxel_range.to_value = 1000000;
+  max_points_per_voxel_desc.integer_range.push_back(max_points_per_voxel_range);
+  declare_parameter(max_points_per_voxel_desc.name, rclcpp::ParameterValue(max_points_per_voxel_), max_points_per_voxel_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor transform_timeout_desc;
+  transform_timeout_desc.name = "transform_timeout";
+  transform_timeout_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  transform_timeout_desc.description = "How long to wait for the transform of a scan into the map frame, in seconds.";
+  rcl_interfaces::msg::FloatingPointRange transform_timeout_range;
+  transform_timeout_range.from_value = 0.0;
+  transform_timeout_range.to_value = 10.0;
+  transform_timeout_desc.floating_point_range.push_back(transform_timeout_range);
+  declare_parameter(transform_timeout_desc.name, rclcpp::ParameterValue(transform_timeout_), transform_timeout_desc);
+
+  // Validate initial values using same callback
+  callback_handle_ = add_on_set_parameters_callback(std::bind(&VoxelMap::config_callback, this, std::placeholders::_1));
+  std::vector<std::string> param_names{
+      max_radius_desc.name,
+      max_age_desc.name,
+      max_points_per_voxel_desc.name,
+      transform_timeout_desc.name,
+  };
+  auto result = config_callback(get_parameters(param_names));
+  if (!result.successful)
+  {
+    throw std::runtime_error(result.reason);
+  }
+
+  latest_stamp_ = rclcpp::Time(0, 0, get_clock()->get_clock_type());
+  pub_output_ = create_publisher<PointCloud2>("output", rclcpp::QoS(1).transient_local());
+  sub_input_ = create_subscription<PointCloud2>("input", cloudQoS(),
+                                                std::bind(&VoxelMap::input_callback, this, std::placeholders::_1));
+  publish_timer_ = create_wall_timer(std::chrono::duration<double>(1.0 / publish_rate),
+                                     std::bind(&VoxelMap::publish_callback, this));
+  RCLCPP_DEBUG(get_logger(), "[VoxelMap] Building a map in %s with a leaf size of %f, published at %f Hz.",
+               map_frame_.c_str(), leaf_size_, publish_rate);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void pcl_ros::VoxelMap::input_callback(const PointCloud2::ConstSharedPtr &cloud)
+{
+  NodeStatistics::Frame frame(statistics_.get());
+
+  if (isStale(cloud->header))
+  {
+    frame.dropped("stale");
+    return;
+  }
+  if (!isValid(cloud))
+  {
+    RCLCPP_ERROR(get_logger(), "Invalid input!");
+    frame.dropped("invalid_input");
+    return;
+  }
+
+  const int x_idx = pcl::getFieldIndex(*cloud, "x");
+  const int y_idx = pcl::getFieldIndex(*cloud, "y");
+  const int z_idx = pcl::getFieldIndex(*cloud, "z");
+  if (x_idx == -1 || y_idx == -1 || z_idx == -1 ||
+      cloud->fields[x_idx].datatype != sensor_msgs::msg::PointField::FLOAT32 ||
+      cloud->fields[y_idx].datatype != sensor_msgs::msg::PointField::FLOAT32 ||
+      cloud->fields[z_idx].datatype != sensor_msgs::msg::PointField::FLOAT32 ||
+      cloud->is_bigendian)
+  {
+    RCLCPP_ERROR(get_logger(), "[input_callback] Input dataset has no little endian FLOAT32 X-Y-Z coordinates! Cannot insert it.");
+    frame.dropped("invalid_input");
+    return;
+  }
+
+  double transform_timeout;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    transform_timeout = transform_timeout_;
+  }
+
+  // Transform the points on the fly rather than copying the scan in the map frame
+  Eigen::Matrix4f transform = Eigen::Matrix4f::Identity();
+  if (cloud->header.frame_id != map_frame_)
+  {
+    try
+    {
+      geometry_msgs::msg::TransformStamped transform_stamped =
+          tf_buffer_.lookupTransform(map_frame_, cloud->header.frame_id, tf2_ros::fromMsg(cloud->header.stamp),
+                                     tf2::durationFromSec(transform_timeout));
+      pcl_ros::transformAsMatrix(transform_stamped, transform);
+    }
+    catch (const tf2::TransformException &e)
+    {
+      RCLCPP_WARN_THROTTLE(get_logger(), *get_clock(), 5000, "[input_callback] Cannot transform the scan from %s to %s: %s",
+                           cloud->header.frame_id.c_str(), map_frame_.c_str(), e.what());
+      frame.dropped("tf_input");
+      return;
+    }
+  }
+
+  const size_t nr_points = cloud->width * cloud->height;
+  frame.startCompute(nr_points);
+  const float inverse_leaf_size[3] = {static_cast<float>(1.0 / leaf_size_), static_cast<float>(1.0 / leaf_size_),
+                                      static_cast<float>(1.0 / leaf_size_)};
+  const rclcpp::Time stamp(cloud->header.stamp, get_clock()->get_clock_type());
+  const Eigen::Matrix3f rotation = transform.topLeftCorner<3, 3>();
+  const Eigen::Vector3f translation = transform.topRightCorner<3, 1>();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  const uint32_t max_points_per_voxel = static_cast<uint32_t>(max_points_per_voxel_);
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    const uint8_t *point = &cloud->data[i * cloud->point_step];
+    Eigen::Vector3f p;
+    memcpy(&p[0], point + cloud->fields[x_idx].offset, sizeof(float));
+    memcpy(&p[1], point + cloud->fields[y_idx].offset, sizeof(float));
+    memcpy(&p[2], point + cloud->fields[z_idx].offset, sizeof(float));
+    p = rotation * p + translation;
+
+    VoxelKey key;
+    if (!computeVoxelKey(p[0], p[1], p[2], inverse_leaf_size, key))
+      continue;
+    Voxel &voxel = voxels_[key];
+    voxel.stamp = std::max(voxel.stamp, stamp.nanoseconds());
+    if (voxel.count >= max_points_per_voxel)
+      continue;
+    for (int d = 0; d < 3; ++d)
+      voxel.sum[d] += p[d];
+    ++voxel.count;
+  }
+  // A scan received out of order must not move the window back
+  if (stamp >= latest_stamp_)
+  {
+    origin_ = translation;
+    latest_stamp_ = stamp;
+  }
+  // The map is published on its own timer, this frame produced the points it was given
+  frame.endCompute(nr_points);
+  frame.published();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void pcl_ros::VoxelMap::publish_callback()
+{
+  pcl::PointCloud<pcl::PointXYZ> map;
+  builtin_interfaces::msg::Time stamp;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Evict the voxels out of the window
+    const double max_radius_sqr = max_radius_ * max_radius_;
+    const int64_t min_stamp = latest_stamp_.nanoseconds() - static_cast<int64_t>(max_age_ * 1e9);
+    const size_t nr_voxels = voxels_.size();
+    for (auto it = voxels_.begin(); it != voxels_.end();)
+    {
+      const Voxel &voxel = it->second;
+      const Eigen::Vector3f centroid(voxel.sum[0] / voxel.count, voxel.sum[1] / voxel.count, voxel.sum[2] / voxel.count);
+      if ((max_radius_ > 0 && (centroid - origin_).squaredNorm() > max_radius_sqr) ||
+          (max_age_ > 0 && voxel.stamp < min_stamp))
+        it = voxels_.erase(it);
+      else
+        ++it;
+    }
+    RCLCPP_DEBUG(get_logger(), "[publish_callback] Evicted %zu of %zu voxels.", nr_voxels - voxels_.size(), nr_voxels);
+
+    if (pub_output_->get_subscription_count() == 0)
+      return;
+
+    map.points.reserve(voxels_.size());
+    for (const auto &entry : voxels_)
+    {
+      const Voxel &voxel = entry.second;
+      map.points.emplace_back(static_cast<float>(voxel.sum[0] / voxel.count),
+                              static_cast<float>(voxel.sum[1] / voxel.count),
+                              static_cast<float>(voxel.sum[2] / voxel.count));
+    }
+    stamp = latest_stamp_;
+  }
+  map.width = static_cast<uint32_t>(map.points.size());
+  map.height = 1;
+  map.is_dense = true;
+
+  std::unique_ptr<PointCloud2> output(new PointCloud2);
+  pcl::toROSMsg(map, *output);
+  output->header.stamp = stamp;
+  output->header.frame_id = map_frame_;
+  pub_output_->publish(std::move(output));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::VoxelMap::config_callback(const std::vector<rclcpp::Parameter> &params)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name() == "max_radius")
+    {
+      max_radius_ = param.as_double();
+      RCLCPP_DEBUG(get_logger(), "Setting the maximum radius to: %f.", max_radius_);
+    }
+    if (param.get_name() == "max_age")
+    {
+      max_age_ = param.as_double();
+      RCLCPP_DEBUG(get_logger(), "Setting the maximum age to: %f.", max_age_);
+    }
+    if (param.get_name() == "max_points_per_voxel")
+    {
+      max_points_per_voxel_ = param.as_int();
+      RCLCPP_DEBUG(get_logger(), "Setting the maximum number of points per voxel to: %d.", max_points_per_voxel_);
+    }
+    if (param.get_name() == "transform_timeout")
+    {
+      transform_timeout_ = param.as_double();
+      RCLCPP_DEBUG(get_logger(), "Setting the transform timeout to: %f.", transform_timeout_);
+    }
+  }
+
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  return result;
+}
+
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(pcl_ros::VoxelMap)
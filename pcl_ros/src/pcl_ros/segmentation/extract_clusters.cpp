@@ -35,53 +35,193 @@
  *
  */
 
-#include "class_loader/register_macro.hpp"
+#include <algorithm>
+#include <chrono>
 #include <pcl/common/io.h>
 #include <pcl/PointIndices.h>
 #include "pcl_ros/segmentation/extract_clusters.hpp"
+#include "pcl_ros/segmentation/organized_clustering.hpp"
 
 #include <pcl_conversions/pcl_conversions.hpp>
 
-using pcl_conversions::fromPCL;
 using pcl_conversions::moveFromPCL;
-using pcl_conversions::toPCL;
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-pcl_ros::EuclideanClusterExtraction::EuclideanClusterExtraction (const rclcpp::NodeOptions& options) : PCLNode("EuclideanClusterExtraction", options), publish_indices_ (false), max_clusters_ (std::numeric_limits<int>::max ())
+pcl_ros::EuclideanClusterExtraction::EuclideanClusterExtraction (const rclcpp::NodeOptions& options) : PCLNode("EuclideanClusterExtraction", options)
 {
-  // ---[ Mandatory parameters
-  double cluster_tolerance;
-  if (!this->get_parameter ("cluster_tolerance", cluster_tolerance))
-  {
-    RCLCPP_ERROR (this->get_logger(), "[%s::onConstructor] Need a 'cluster_tolerance' parameter to be set before continuing!", this->get_name ());
-    return;
-  }
-  int spatial_locator;
-  if (!this->get_parameter ("spatial_locator", spatial_locator))
-  {
-    RCLCPP_ERROR (this->get_logger(), "[%s::onConstructor] Need a 'spatial_locator' parameter to be set before continuing!", this->get_name ());
-    return;
-  }
+  rcl_interfaces::msg::ParameterDescriptor cluster_tolerance_desc;
+  cluster_tolerance_desc.name = "cluster_tolerance";
+  cluster_tolerance_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_DOUBLE;
+  cluster_tolerance_desc.description = "The spatial cluster tolerance as a measure in the L2 Euclidean space.";
+  rcl_interfaces::msg::FloatingPointRange cluster_tolerance_range;
+  cluster_tolerance_range.from_value = 0.0;
+  cluster_tolerance_range.to_value = 2.0;
+  cluster_tolerance_desc.floating_point_range.push_back (cluster_tolerance_range);
+  declare_parameter (cluster_tolerance_desc.name, rclcpp::ParameterValue(0.05), cluster_tolerance_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor cluster_min_size_desc;
+  cluster_min_size_desc.name = "cluster_min_size";
+  cluster_min_size_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  cluster_min_size_desc.description = "The minimum number of points that a cluster must contain in order to be accepted.";
+  rcl_interfaces::msg::IntegerRange cluster_min_size_range;
+  cluster_min_size_range.from_value = 0;
+  cluster_min_size_range.to_value = 1000;
+  cluster_min_size_desc.integer_range.push_back (cluster_min_size_range);
+  declare_parameter (cluster_min_size_desc.name, rclcpp::ParameterValue(1), cluster_min_size_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor cluster_max_size_desc;
+  cluster_max_size_desc.name = "cluster_max_size";
+  cluster_max_size_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  cluster_max_size_desc.description = "The maximum number of points that a cluster must contain in order to be accepted.";
+  rcl_interfaces::msg::IntegerRange cluster_max_size_range;
+  cluster_max_size_range.from_value = 0;
+  cluster_max_size_range.to_value = std::numeric_limits<int32_t>::max ();
+  cluster_max_size_desc.integer_range.push_back (cluster_max_size_range);
+  declare_parameter (cluster_max_size_desc.name, rclcpp::ParameterValue(std::numeric_limits<int32_t>::max ()), cluster_max_size_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor max_clusters_desc;
+  max_clusters_desc.name = "max_clusters";
+  max_clusters_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  max_clusters_desc.description = "Maximum number of clusters to publish per frame, the largest first.";
+  rcl_interfaces::msg::IntegerRange max_clusters_range;
+  max_clusters_range.from_value = 0;
+  max_clusters_range.to_value = std::numeric_limits<int32_t>::max ();
+  max_clusters_desc.integer_range.push_back (max_clusters_range);
+  declare_parameter (max_clusters_desc.name, rclcpp::ParameterValue(max_clusters_), max_clusters_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor cluster_method_desc;
+  cluster_method_desc.name = "cluster_method";
+  cluster_method_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_STRING;
+  cluster_method_desc.description = "Clustering engine: euclidean (pcl::EuclideanClusterExtraction), voxel (parallel voxel grid and union-find) or organized (pixel connectivity for organized clouds, euclidean for the others).";
+  declare_parameter (cluster_method_desc.name, rclcpp::ParameterValue(cluster_method_), cluster_method_desc);
 
-  //private_nh.getParam ("use_indices", use_indices_);
-  this->get_parameter ("publish_indices", publish_indices_);
+  rcl_interfaces::msg::ParameterDescriptor cluster_refine_desc;
+  cluster_refine_desc.name = "cluster_refine";
+  cluster_refine_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  cluster_refine_desc.description = "With the voxel method, check the distances between the points of neighboring voxels (exact clusters), or only between their bounding boxes.";
+  declare_parameter (cluster_refine_desc.name, rclcpp::ParameterValue(voxel_impl_.getRefine ()), cluster_refine_desc);
 
-  if (publish_indices_)
-    pub_output_ = advertise<PointIndices> ("output", max_queue_size_);
+  rcl_interfaces::msg::ParameterDescriptor num_threads_desc;
+  num_threads_desc.name = "num_threads";
+  num_threads_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_INTEGER;
+  num_threads_desc.description = "Number of threads of the voxel method, 0 for the number of cores.";
+  rcl_interfaces::msg::IntegerRange num_threads_range;
+  num_threads_range.from_value = 0;
+  num_threads_range.to_value = 64;
+  num_threads_desc.integer_range.push_back (num_threads_range);
+  declare_parameter (num_threads_desc.name, rclcpp::ParameterValue(0), num_threads_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor publish_indices_desc;
+  publish_indices_desc.name = "publish_indices";
+  publish_indices_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  publish_indices_desc.description = "Publish the clusters as PointIndices instead of point clouds.";
+  publish_indices_desc.read_only = true;
+  publish_indices_ = declare_parameter (publish_indices_desc.name, publish_indices_, publish_indices_desc);
+
+  rcl_interfaces::msg::ParameterDescriptor batch_output_desc;
+  batch_output_desc.name = "batch_output";
+  batch_output_desc.type = rcl_interfaces::msg::ParameterType::PARAMETER_BOOL;
+  batch_output_desc.description = "Publish all the clusters of a frame in one pcl::PointXYZL point cloud labeled by cluster, with the stamp of the input. "
+                                  "Takes precedence over publish_indices: the clusters are then published as points, without the indices of the input points.";
+  batch_output_desc.read_only = true;
+  batch_output_ = declare_parameter (batch_output_desc.name, batch_output_, batch_output_desc);
+
+  if (publish_indices_ && !batch_output_)
+    pub_indices_ = this->create_publisher<PointIndices> ("output", outputQoS ());
   else
-    pub_output_ = advertise<PointCloud> ("output", max_queue_size_);
+    pub_output_ = this->create_publisher<PointCloud2> ("output", outputQoS ());
+
+  callback_handle_ = add_on_set_parameters_callback (std::bind (&EuclideanClusterExtraction::config_callback, this, std::placeholders::_1));
+
+  std::vector<std::string> param_names{
+    cluster_tolerance_desc.name,
+    cluster_min_size_desc.name,
+    cluster_max_size_desc.name,
+    max_clusters_desc.name,
+    cluster_method_desc.name,
+    cluster_refine_desc.name,
+    num_threads_desc.name,
+  };
+  auto result = config_callback (get_parameters (param_names));
+  if (!result.successful) {
+    throw std::runtime_error(result.reason);
+  }
 
   RCLCPP_DEBUG (this->get_logger(), "[%s::onConstructor] Node successfully created with the following parameters:\n"
                  " - max_queue_size    : %d\n"
                  " - use_indices       : %s\n"
-                 " - cluster_tolerance : %f\n",
+                 " - cluster_tolerance : %f\n"
+                 " - batch_output      : %s",
                  this->get_name (),
                  max_queue_size_,
-                 (use_indices_) ? "true" : "false", cluster_tolerance);
+                 (use_indices_) ? "true" : "false", impl_.getClusterTolerance (),
+                 (batch_output_) ? "true" : "false");
+
+  subscribe ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+rcl_interfaces::msg::SetParametersResult
+pcl_ros::EuclideanClusterExtraction::config_callback (const std::vector<rclcpp::Parameter> & params)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
 
-  // Set given parameters here
-  impl_.setClusterTolerance (cluster_tolerance);
+  rcl_interfaces::msg::SetParametersResult result;
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "cluster_method" && param.as_string () != "euclidean" && param.as_string () != "voxel" &&
+        param.as_string () != "organized")
+    {
+      result.successful = false;
+      result.reason = "Unknown cluster_method '" + param.as_string () + "', expected euclidean, voxel or organized.";
+      return result;
+    }
+  }
 
+  for (const rclcpp::Parameter &param : params)
+  {
+    if (param.get_name () == "cluster_method")
+    {
+      cluster_method_ = param.as_string ();
+      RCLCPP_DEBUG (get_logger(), "Setting the clustering method to: %s.", param.as_string ().c_str ());
+    }
+    else if (param.get_name () == "cluster_refine")
+    {
+      voxel_impl_.setRefine (param.as_bool ());
+      RCLCPP_DEBUG (get_logger(), "Setting the refinement of the voxel clusters to: %s.", param.as_bool () ? "true" : "false");
+    }
+    else if (param.get_name () == "num_threads")
+    {
+      voxel_impl_.setNumberOfThreads (static_cast<unsigned int> (param.as_int ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the number of threads to: %ld.", param.as_int ());
+    }
+    else if (param.get_name () == "cluster_tolerance" && impl_.getClusterTolerance () != param.as_double ())
+    {
+      impl_.setClusterTolerance (param.as_double ());
+      voxel_impl_.setClusterTolerance (param.as_double ());
+      RCLCPP_DEBUG (get_logger(), "Setting the spatial cluster tolerance to: %f.", param.as_double ());
+    }
+    else if (param.get_name () == "cluster_min_size" && static_cast<int64_t> (impl_.getMinClusterSize ()) != param.as_int ())
+    {
+      impl_.setMinClusterSize (param.as_int ());
+      voxel_impl_.setMinClusterSize (static_cast<int> (param.as_int ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the minimum cluster size to: %ld.", param.as_int ());
+    }
+    else if (param.get_name () == "cluster_max_size" && static_cast<int64_t> (impl_.getMaxClusterSize ()) != param.as_int ())
+    {
+      impl_.setMaxClusterSize (param.as_int ());
+      voxel_impl_.setMaxClusterSize (static_cast<int> (param.as_int ()));
+      RCLCPP_DEBUG (get_logger(), "Setting the maximum cluster size to: %ld.", param.as_int ());
+    }
+    else if (param.get_name () == "max_clusters" && max_clusters_ != param.as_int ())
+    {
+      max_clusters_ = param.as_int ();
+      RCLCPP_DEBUG (get_logger(), "Setting the maximum number of clusters to publish to: %d.", max_clusters_);
+    }
+  }
+
+  result.successful = true;
+  return result;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -92,27 +232,31 @@ pcl_ros::EuclideanClusterExtraction::subscribe ()
   if (use_indices_)
   {
     // Subscribe to the input using a filter
-    sub_input_filter_.subscribe (this->shared_from_this (), "input");
-    sub_indices_filter_.subscribe (this->shared_from_this (), "indices");
+    sub_input_filter_.subscribe (this, "input", cloudQoS ().get_rmw_qos_profile ());
+    sub_indices_filter_.subscribe (this, "indices", indicesQoS ().get_rmw_qos_profile ());
 
     if (approximate_sync_)
     {
-      sync_input_indices_a_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<PointCloud, PointIndices> > > (max_queue_size_);
+      sync_input_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud2, PointIndices> > > (inputQueueSize ());
       sync_input_indices_a_->connectInput (sub_input_filter_, sub_indices_filter_);
       sync_input_indices_a_->registerCallback (std::bind (&EuclideanClusterExtraction::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
     }
     else
     {
-      sync_input_indices_e_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ExactTime<PointCloud, PointIndices> > > (max_queue_size_);
+      sync_input_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud2, PointIndices> > > (inputQueueSize ());
       sync_input_indices_e_->connectInput (sub_input_filter_, sub_indices_filter_);
       sync_input_indices_e_->registerCallback (std::bind (&EuclideanClusterExtraction::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
     }
   }
   else
+  {
+    // Workaround ros2/rclcpp#766
+    std::function<void(PointCloud2::ConstSharedPtr)> callback =
+        std::bind (&EuclideanClusterExtraction::input_indices_callback, this, std::placeholders::_1, nullptr);
+
     // Subscribe in an old fashion to input only (no filters)
-    // Type masquerading not yet supported
-    // sub_input_ = this->create_subscription<PointCloud> ("input", std::bind (&EuclideanClusterExtraction::input_indices_callback, this, std::placeholders::_1, PointIndicesConstPtr ()));
-    std::cout << "Type masquerading not supported" << std::endl;
+    sub_input_ = this->create_subscription<PointCloud2> ("input", cloudQoS (), callback);
+  }
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -125,72 +269,125 @@ pcl_ros::EuclideanClusterExtraction::unsubscribe ()
     sub_indices_filter_.unsubscribe ();
   }
   else
-    std::cout << "shutdown" << std::endl;
-    //sub_input_.shutdown ();
+    sub_input_.reset ();
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 void
 pcl_ros::EuclideanClusterExtraction::input_indices_callback (
-      const PointCloudConstPtr &cloud, const PointIndicesConstPtr &indices)
+      const PointCloud2::ConstSharedPtr &cloud, const PointIndicesConstPtr &indices)
 {
-  // No subscribers, no work
-  /*
-   count_subscribers not yet implemented ROS2
-  if (pub_output_.count_subscribers () <= 0)
+  NodeStatistics::Frame frame (statistics_.get ());
+
+  // Skip the frames that waited too long in the queue
+  if (isStale (cloud->header))
+  {
+    frame.dropped ("stale");
     return;
-   */
+  }
 
   // If cloud is given, check if it's valid
   if (!isValid (cloud))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_indices_callback] Invalid input!", this->get_name ());
+    frame.dropped ("invalid_input");
     return;
   }
   // If indices are given, check if they are valid
   if (indices && !isValid (indices))
   {
     RCLCPP_ERROR (this->get_logger(), "[%s::input_indices_callback] Invalid indices!", this->get_name ());
+    frame.dropped ("invalid_indices");
     return;
   }
 
   /// DEBUG
   if (indices) {
-    std_msgs::msg::Header cloud_header = fromPCL(cloud->header);
-    std_msgs::msg::Header indices_header = indices->header;
     RCLCPP_DEBUG (this->get_logger(), "[%s::input_indices_callback]\n"
-                   "                                 - PointCloud with %d data points (%s), stamp %f, and frame %s on topic %s received.\n"
-                   "                                 - PointIndices with %zu values, stamp %f, and frame %s on topic %s received.",
+                   "                                 - PointCloud with %d data points (%s), stamp %d, and frame %s on topic %s received.\n"
+                   "                                 - PointIndices with %zu values, stamp %d, and frame %s on topic %s received.",
                    this->get_name (),
-                   cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), cloud_header.stamp.sec, cloud_header.frame_id.c_str (), "input",
-                   indices->indices.size (), indices_header.stamp.sec, indices_header.frame_id.c_str (), "indices");
+                   cloud->width * cloud->height, pcl::getFieldsList (*cloud).c_str (), cloud->header.stamp.sec, cloud->header.frame_id.c_str (), "input",
+                   indices->indices.size (), indices->header.stamp.sec, indices->header.frame_id.c_str (), "indices");
   } else {
-    RCLCPP_DEBUG (this->get_logger(), "[%s::input_callback] PointCloud with %d data points, stamp %f, and frame %s on topic %s received.", this->get_name (), cloud->width * cloud->height, fromPCL(cloud->header).stamp.sec, cloud->header.frame_id.c_str (), "input");
+    RCLCPP_DEBUG (this->get_logger(), "[%s::input_callback] PointCloud with %d data points, stamp %d, and frame %s on topic %s received.", this->get_name (), cloud->width * cloud->height, cloud->header.stamp.sec, cloud->header.frame_id.c_str (), "input");
   }
   ///
 
+  PointCloud::Ptr cloud_in (new PointCloud);
+  pcl::fromROSMsg (*cloud, *cloud_in);
+
   IndicesPtr indices_ptr;
   if (indices)
-    indices_ptr.reset (new std::vector<int> (indices->indices));
+    indices_ptr = indicesFromMsg (indices);
+
+  std::lock_guard<std::mutex> lock (mutex_);
 
-  impl_.setInputCloud (cloud);
-  impl_.setIndices (indices_ptr.get());
+  // Over the processing budget, every point is still clustered, but with the voxel method and only the bounding
+  // boxes of neighboring voxels compared (cluster_refine off): the clusters may merge across gaps slightly wider
+  // than the tolerance. The organized method is linear already and is never degraded.
+  const bool organized = (cluster_method_ == "organized" && cloud_in->height > 1);
+  const int quality_level = organized ? 0 : qualityLevel ();
 
   std::vector<pcl::PointIndices> clusters;
-  impl_.extract (clusters);
+  const size_t nr_points = indices_ptr ? indices_ptr->size () : cloud_in->points.size ();
+  const auto start = std::chrono::steady_clock::now ();
+  frame.startCompute (nr_points);
+  if (organized)
+    extractOrganizedClusters (cloud_in, indices_ptr, static_cast<float> (impl_.getClusterTolerance ()),
+                              static_cast<int> (impl_.getMinClusterSize ()),
+                              static_cast<int> (impl_.getMaxClusterSize ()), clusters);
+  else if (quality_level > 0)
+  {
+    const bool refine = voxel_impl_.getRefine ();
+    voxel_impl_.setRefine (false);
+    voxel_impl_.extract (*cloud_in, indices_ptr, clusters);
+    voxel_impl_.setRefine (refine);
+  }
+  else if (cluster_method_ == "voxel")
+    voxel_impl_.extract (*cloud_in, indices_ptr, clusters);
+  else
+  {
+    // The searchers of the cache index all the points of the cloud, so they are only used without indices
+    SearchCache::EntryConstPtr entry;
+    if (use_search_cache_ && !indices_ptr)
+      entry = SearchCache::instance ().get (cloud);
+    if (entry)
+    {
+      // impl_.extract () would rebuild the shared searcher over its input cloud, run its clustering directly
+      pcl::extractEuclideanClusters (*entry->cloud, entry->search, static_cast<float> (impl_.getClusterTolerance ()),
+                                     clusters, impl_.getMinClusterSize (), impl_.getMaxClusterSize ());
+      std::sort (clusters.rbegin (), clusters.rend (), pcl::comparePointClusters);
+    }
+    else
+    {
+      impl_.setInputCloud (cloud_in);
+      impl_.setIndices (indices_ptr);
+      impl_.extract (clusters);
+    }
+  }
+  frame.endCompute (nr_points);
+  updateQuality (quality_level, std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ());
 
-  if (publish_indices_)
+  // The clusters are sorted by decreasing size, keep the largest ones
+  if (clusters.size () > static_cast<size_t> (max_clusters_))
+    clusters.resize (max_clusters_);
+
+  if (batch_output_)
+  {
+    publishLabeled (cloud->header, *cloud_in, clusters);
+    RCLCPP_DEBUG (this->get_logger(), "[segmentAndPublish] Published %zu clusters (PointXYZL) on topic %s", clusters.size (), "output");
+  }
+  else if (publish_indices_)
   {
     for (size_t i = 0; i < clusters.size (); ++i)
     {
-      if ((int)i >= max_clusters_)
-        break;
-      // TODO: HACK!!! We need to change the PointCloud2 message to add for an incremental sequence ID number.
-      pcl_msgs::msg::PointIndices ros_pi;
-      moveFromPCL(clusters[i], ros_pi);
-      ros_pi.header.stamp += rclcpp::Duration (i * 0.001);
-      pub_output_->publish (ros_pi);
+      // Every cluster keeps the stamp of the input, to be matched with it
+      auto ros_pi = std::make_unique<PointIndices> ();
+      moveFromPCL (clusters[i], *ros_pi);
+      ros_pi->header = cloud->header;
+      pub_indices_->publish (std::move (ros_pi));
     }
 
     RCLCPP_DEBUG (this->get_logger(), "[segmentAndPublish] Published %zu clusters (PointIndices) on topic %s", clusters.size (), "output");
@@ -199,23 +396,50 @@ pcl_ros::EuclideanClusterExtraction::input_indices_callback (
   {
     for (size_t i = 0; i < clusters.size (); ++i)
     {
-      if ((int)i >= max_clusters_)
-        break;
       PointCloud output;
-      copyPointCloud (*cloud, clusters[i].indices, output);
-
-      //PointCloud output_blob;     // Convert from the templated output to the PointCloud blob
-      //pcl::toROSMsg (output, output_blob);
-      // TODO: HACK!!! We need to change the PointCloud2 message to add for an incremental sequence ID number.
-      std_msgs::msg::Header header = fromPCL(output.header);
-      header.stamp += rclcpp::Duration (i * 0.001);
-      toPCL(header, output.header);
-      // Publish a shared ptr const data
-      pub_output_->publish (output.makeShared ());
-      RCLCPP_DEBUG (this->get_logger(), "[segmentAndPublish] Published cluster %zu (with %zu values and stamp %f) on topic %s",
-                     i, clusters[i].indices.size (), header.stamp.sec, "output");
+      copyPointCloud (*cloud_in, clusters[i].indices, output);
+
+      auto ros_output = std::make_unique<PointCloud2> ();
+      pcl::toROSMsg (output, *ros_output);
+      ros_output->header = cloud->header;
+      pub_output_->publish (std::move (ros_output));
+      RCLCPP_DEBUG (this->get_logger(), "[segmentAndPublish] Published cluster %zu (with %zu values) on topic %s",
+                     i, clusters[i].indices.size (), "output");
+    }
+  }
+  frame.published ();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::EuclideanClusterExtraction::publishLabeled (const std_msgs::msg::Header &header, const PointCloud &cloud,
+                                                     const std::vector<pcl::PointIndices> &clusters)
+{
+  size_t nr_points = 0;
+  for (const pcl::PointIndices &cluster : clusters)
+    nr_points += cluster.indices.size ();
+
+  pcl::PointCloud<pcl::PointXYZL> output;
+  output.points.resize (nr_points);
+  size_t j = 0;
+  for (size_t i = 0; i < clusters.size (); ++i)
+  {
+    for (int index : clusters[i].indices)
+    {
+      const pcl::PointXYZ &p = cloud.points[index];
+      pcl::PointXYZL &out = output.points[j++];
+      out.x = p.x; out.y = p.y; out.z = p.z;
+      out.label = static_cast<uint32_t> (i);
     }
   }
+  output.width = static_cast<uint32_t> (nr_points);
+  output.height = 1;
+  output.is_dense = true;
+
+  auto ros_output = std::make_unique<PointCloud2> ();
+  pcl::toROSMsg (output, *ros_output);
+  ros_output->header = header;
+  pub_output_->publish (std::move (ros_output));
 }
 
 typedef pcl_ros::EuclideanClusterExtraction EuclideanClusterExtraction;
@@ -61,9 +61,9 @@ pcl_ros::ExtractPolygonalPrismData::subscribe ()
 
   // Create the objects here
   if (approximate_sync_)
-    sync_input_hull_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointCloud, PointIndices> > > (max_queue_size_);
+    sync_input_hull_indices_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointCloud, PointIndices> > > (inputQueueSize ());
   else
-    sync_input_hull_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointCloud, PointIndices> > > (max_queue_size_);
+    sync_input_hull_indices_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointCloud, PointIndices> > > (inputQueueSize ());
 
   if (use_indices_)
   {
@@ -170,10 +170,10 @@ pcl_ros::ExtractPolygonalPrismData::input_hull_indices_callback (
 
   IndicesPtr indices_ptr;
   if (indices && !indices->header.frame_id.empty ())
-    indices_ptr.reset (new std::vector<int> (indices->indices));
+    indices_ptr = indicesFromMsg (indices);
 
   impl_.setInputCloud (cloud);
-  impl_.setIndices (indices_ptr.get());
+  impl_.setIndices (indices_ptr);
 
   // Final check if the data is empty (remember that indices are set to the size of the data -- if indices* = NULL)
   if (!cloud->points.empty ()) {
@@ -184,8 +184,9 @@ pcl_ros::ExtractPolygonalPrismData::input_hull_indices_callback (
   }
   // Enforce that the TF frame and the timestamp are copied
   inliers.header = fromPCL(cloud->header);
-  pub_output_->publish (inliers);
   RCLCPP_DEBUG (this->get_logger(), "[%s::input_hull_callback] Publishing %zu indices.", this->get_name (), inliers.indices.size ());
+  // Hand the indices over to the middleware without copying them
+  pub_output_->publish (std::make_unique<PointIndices> (std::move (inliers)));
 }
 
 typedef pcl_ros::ExtractPolygonalPrismData ExtractPolygonalPrismData;
@@ -0,0 +1,93 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <pcl/segmentation/euclidean_cluster_comparator.h>
+#include <pcl/segmentation/organized_connected_component_segmentation.h>
+#include "pcl_ros/segmentation/organized_clustering.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::extractOrganizedClusters (const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &cloud,
+                                   const std::shared_ptr<std::vector<int> > &indices, float tolerance,
+                                   int min_cluster_size, int max_cluster_size,
+                                   std::vector<pcl::PointIndices> &clusters)
+{
+  pcl::PointCloud<pcl::PointXYZ>::ConstPtr input = cloud;
+  if (indices)
+  {
+    // Mask out the points left out of the indices, which never join a cluster
+    pcl::PointCloud<pcl::PointXYZ>::Ptr masked (new pcl::PointCloud<pcl::PointXYZ> (*cloud));
+    std::vector<bool> selected (cloud->points.size (), false);
+    for (int index : *indices)
+    {
+      if (index >= 0 && static_cast<size_t> (index) < selected.size ())
+        selected[index] = true;
+    }
+    const float nan = std::numeric_limits<float>::quiet_NaN ();
+    for (size_t i = 0; i < selected.size (); ++i)
+    {
+      if (!selected[i])
+        masked->points[i].x = masked->points[i].y = masked->points[i].z = nan;
+    }
+    input = masked;
+  }
+
+  pcl::EuclideanClusterComparator<pcl::PointXYZ, pcl::Label>::Ptr comparator (
+    new pcl::EuclideanClusterComparator<pcl::PointXYZ, pcl::Label> ());
+  comparator->setDistanceThreshold (tolerance, false);
+  comparator->setInputCloud (input);
+  pcl::OrganizedConnectedComponentSegmentation<pcl::PointXYZ, pcl::Label> segmentation (comparator);
+  segmentation.setInputCloud (input);
+  pcl::PointCloud<pcl::Label> labels;
+  std::vector<pcl::PointIndices> label_indices;
+  segmentation.segment (labels, label_indices);
+
+  // One entry per label, keep the clusters within the size limits, the largest first
+  clusters.clear ();
+  for (pcl::PointIndices &cluster : label_indices)
+  {
+    const int size = static_cast<int> (cluster.indices.size ());
+    if (size > 0 && size >= min_cluster_size && size <= max_cluster_size)
+    {
+      cluster.header = cloud->header;
+      clusters.push_back (std::move (cluster));
+    }
+  }
+  std::stable_sort (clusters.begin (), clusters.end (), [] (const pcl::PointIndices &a, const pcl::PointIndices &b)
+  {
+    return (a.indices.size () > b.indices.size ());
+  });
+}
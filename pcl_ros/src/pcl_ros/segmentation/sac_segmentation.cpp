@@ -118,38 +118,31 @@ void pcl_ros::SACSegmentation::subscribe()
   {
     // Subscribe to the input using a filter
     sub_input_filter_.subscribe(this->shared_from_this(), "input", cloudQoS().get_rmw_qos_profile());
-    sub_indices_filter_.subscribe(this->shared_from_this(), "indices", cloudQoS().get_rmw_qos_profile());
+    sub_indices_filter_.subscribe(this->shared_from_this(), "indices", indicesQoS().get_rmw_qos_profile());
 
     // when "use_indices" is set to true, and "latched_indices" is set to true,
     // we'll subscribe and get a separate callback for PointIndices that will
-    // save the indices internally, and a PointCloud + PointIndices callback
-    // will take care of meshing the new PointClouds with the old saved indices.
+    // save the indices internally, and a PointCloud callback that will segment
+    // every new PointCloud with the latest saved indices, without synchronizer.
     if (latched_indices_)
     {
       // Subscribe to a callback that saves the indices
-
-      // sub_indices_filter_.registerCallback(std::bind(&SACSegmentation::indices_callback, this, std::placeholders::_1));
-      // Subscribe to a callback that sets the header of the saved indices to the cloud header
-      // sub_input_filter_.registerCallback(std::bind(&SACSegmentation::input_callback, this, std::placeholders::_1));
-
-      // Synchronize the two topics. No need for an approximate synchronizer here, as we'll
-      // match the timestamps exactly
-      sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointIndices>>>(max_queue_size_);
-      sync_input_indices_e_->connectInput(sub_input_filter_, sub_indices_filter_);
-      sync_input_indices_e_->registerCallback(std::bind(&SACSegmentation::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
+      sub_indices_filter_.registerCallback(std::bind(&SACSegmentation::indices_callback, this, std::placeholders::_1));
+      // Subscribe to a callback that segments the cloud with the saved indices
+      sub_input_filter_.registerCallback(std::bind(&SACSegmentation::input_callback, this, std::placeholders::_1));
     }
     // "latched_indices" not set, proceed with regular <input,indices> pairs
     else
     {
       if (approximate_sync_)
       {
-        sync_input_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointIndices>>>(max_queue_size_);
+        sync_input_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointIndices>>>(inputQueueSize());
         sync_input_indices_a_->connectInput(sub_input_filter_, sub_indices_filter_);
         sync_input_indices_a_->registerCallback(std::bind(&SACSegmentation::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
       }
       else
       {
-        sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointIndices>>>(max_queue_size_);
+        sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointIndices>>>(inputQueueSize());
         sync_input_indices_e_->connectInput(sub_input_filter_, sub_indices_filter_);
         sync_input_indices_e_->registerCallback(std::bind(&SACSegmentation::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
       }
@@ -176,8 +169,8 @@ void pcl_ros::SACSegmentation::unsubscribe()
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
-void pcl_ros::SACSegmentation::input_indices_callback(const PointCloudPtr cloud,
-                                                      const PointIndicesPtr indices)
+void pcl_ros::SACSegmentation::input_indices_callback(const PointCloudConstPtr &cloud,
+                                                      const PointIndicesConstPtr &indices)
 {
   std::lock_guard<std::mutex> lock(mutex_);
 
@@ -234,7 +227,7 @@ void pcl_ros::SACSegmentation::input_indices_callback(const PointCloudPtr cloud,
 
   IndicesPtr indices_ptr;
   if (indices && !indices->header.frame_id.empty())
-    indices_ptr.reset(new std::vector<int>(indices->indices));
+    indices_ptr = indicesFromMsg(indices);
 
   impl_.setInputCloud(cloud_tf);
   impl_.setIndices(indices_ptr);
@@ -260,15 +253,15 @@ void pcl_ros::SACSegmentation::input_indices_callback(const PointCloudPtr cloud,
     model.values.clear();
   }
 
-  // Publish
-  pub_indices_->publish(*std::make_shared<const PointIndices>(inliers));
-  pub_model_->publish(*std::make_shared<const ModelCoefficients>(model));
-  RCLCPP_DEBUG(this->get_logger(), "[%s::input_indices_callback] Published PointIndices with %zu values on topic %s, and ModelCoefficients with %zu values on topic %s",
+  RCLCPP_DEBUG(this->get_logger(), "[%s::input_indices_callback] Publishing PointIndices with %zu values on topic %s, and ModelCoefficients with %zu values on topic %s",
                this->get_name(), inliers.indices.size(), "inliers",
                model.values.size(), "model");
-
   if (inliers.indices.empty())
     RCLCPP_WARN(this->get_logger(), "[%s::input_indices_callback] No inliers found!", this->get_name());
+
+  // Publish, handing the indices over to the middleware without copying them
+  pub_indices_->publish(std::make_unique<PointIndices>(std::move(inliers)));
+  pub_model_->publish(std::make_unique<ModelCoefficients>(std::move(model)));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -345,9 +338,9 @@ void pcl_ros::SACSegmentationFromNormals::subscribe()
   sub_axis_ = this->create_subscription<pcl_msgs::msg::ModelCoefficients>("axis", cloudQoS(), std::bind(&SACSegmentationFromNormals::axis_callback, this, std::placeholders::_1));
 
   if (approximate_sync_)
-    sync_input_normals_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointCloudN, PointIndices>>>(max_queue_size_);
+    sync_input_normals_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointCloudN, PointIndices>>>(inputQueueSize());
   else
-    sync_input_normals_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointCloudN, PointIndices>>>(max_queue_size_);
+    sync_input_normals_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointCloudN, PointIndices>>>(inputQueueSize());
 
   // If we're supposed to look for PointIndices (indices)
   if (use_indices_)
@@ -422,24 +415,24 @@ void pcl_ros::SACSegmentationFromNormals::input_normals_indices_callback(
   if (impl_.getModelType() < 0)
   {
     RCLCPP_ERROR(this->get_logger(), "[%s::input_normals_indices_callback] Model type not set!", this->get_name());
-    pub_indices_->publish(*std::make_shared<const PointIndices>(inliers));
-    pub_model_->publish(*std::make_shared<const ModelCoefficients>(model));
+    pub_indices_->publish(std::make_unique<PointIndices>(std::move(inliers)));
+    pub_model_->publish(std::make_unique<ModelCoefficients>(std::move(model)));
     return;
   }
 
   if (!isValid(cloud)) // || !isValid (cloud_normals, "normals"))
   {
     RCLCPP_ERROR(this->get_logger(), "[%s::input_normals_indices_callback] Invalid input!", this->get_name());
-    pub_indices_->publish(*std::make_shared<const PointIndices>(inliers));
-    pub_model_->publish(*std::make_shared<const ModelCoefficients>(model));
+    pub_indices_->publish(std::make_unique<PointIndices>(std::move(inliers)));
+    pub_model_->publish(std::make_unique<ModelCoefficients>(std::move(model)));
     return;
   }
   // If indices are given, check if they are valid
   if (indices && !isValid(indices))
   {
     RCLCPP_ERROR(this->get_logger(), "[%s::input_normals_indices_callback] Invalid indices!", this->get_name());
-    pub_indices_->publish(*std::make_shared<const PointIndices>(inliers));
-    pub_model_->publish(*std::make_shared<const ModelCoefficients>(model));
+    pub_indices_->publish(std::make_unique<PointIndices>(std::move(inliers)));
+    pub_model_->publish(std::make_unique<ModelCoefficients>(std::move(model)));
     return;
   }
 
@@ -468,8 +461,8 @@ void pcl_ros::SACSegmentationFromNormals::input_normals_indices_callback(
   if (cloud_nr_points != cloud_normals_nr_points)
   {
     RCLCPP_ERROR(this->get_logger(), "[%s::input_normals_indices_callback] Number of points in the input dataset (%d) differs from the number of points in the normals (%d)!", this->get_name(), cloud_nr_points, cloud_normals_nr_points);
-    pub_indices_->publish(*std::make_shared<const PointIndices>(inliers));
-    pub_model_->publish(*std::make_shared<const ModelCoefficients>(model));
+    pub_indices_->publish(std::make_unique<PointIndices>(std::move(inliers)));
+    pub_model_->publish(std::make_unique<ModelCoefficients>(std::move(model)));
     return;
   }
 
@@ -478,7 +471,7 @@ void pcl_ros::SACSegmentationFromNormals::input_normals_indices_callback(
 
   IndicesPtr indices_ptr;
   if (indices && !indices->header.frame_id.empty())
-    indices_ptr.reset(new std::vector<int>(indices->indices));
+    indices_ptr = indicesFromMsg(indices);
 
   impl_.setIndices(indices_ptr);
 
@@ -501,14 +494,15 @@ void pcl_ros::SACSegmentationFromNormals::input_normals_indices_callback(
     model.values.clear();
   }
 
-  // Publish
-  pub_indices_->publish(*std::make_shared<const PointIndices>(inliers));
-  pub_model_->publish(*std::make_shared<const ModelCoefficients>(model));
-  RCLCPP_DEBUG(this->get_logger(), "[%s::input_normals_callback] Published PointIndices with %zu values on topic %s, and ModelCoefficients with %zu values on topic %s",
+  RCLCPP_DEBUG(this->get_logger(), "[%s::input_normals_callback] Publishing PointIndices with %zu values on topic %s, and ModelCoefficients with %zu values on topic %s",
                this->get_name(), inliers.indices.size(), "inliers",
                model.values.size(), "model");
   if (inliers.indices.empty())
     RCLCPP_WARN(this->get_logger(), "[%s::input_indices_callback] No inliers found!", this->get_name());
+
+  // Publish, handing the indices over to the middleware without copying them
+  pub_indices_->publish(std::make_unique<PointIndices>(std::move(inliers)));
+  pub_model_->publish(std::make_unique<ModelCoefficients>(std::move(model)));
 }
 
 // typedef pcl_ros::SACSegmentation SACSegmentation;
@@ -60,13 +60,13 @@ pcl_ros::SegmentDifferences::subscribe ()
 
   if (approximate_sync_)
   {
-    sync_input_target_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointCloud> > > (max_queue_size_);
+    sync_input_target_a_ = std::make_shared <message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointCloud> > > (inputQueueSize ());
     sync_input_target_a_->connectInput (sub_input_filter_, sub_target_filter_);
     sync_input_target_a_->registerCallback (std::bind (&SegmentDifferences::input_target_callback, this, std::placeholders::_1, std::placeholders::_2));
   }
   else
   {
-    sync_input_target_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointCloud> > > (max_queue_size_);
+    sync_input_target_e_ = std::make_shared <message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointCloud> > > (inputQueueSize ());
     sync_input_target_e_->connectInput (sub_input_filter_, sub_target_filter_);
     sync_input_target_e_->registerCallback (std::bind (&SegmentDifferences::input_target_callback, this, std::placeholders::_1, std::placeholders::_2));
   }
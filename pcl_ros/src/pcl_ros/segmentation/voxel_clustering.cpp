@@ -0,0 +1,343 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include "pcl_ros/filters/voxel_hash.hpp"
+#include "pcl_ros/segmentation/voxel_clustering.hpp"
+
+namespace
+{
+  /** \brief Minimum number of points worth an additional thread. */
+  const size_t kMinPointsPerThread = 10000;
+
+  /** \brief Number of voxels joined with their neighbors per task. */
+  const size_t kVoxelsPerTask = 1024;
+
+  /** \brief The voxels are slightly smaller than tolerance / sqrt (3), so that the points of a voxel are all within
+    * the tolerance of each other despite rounding. Then the points within the tolerance of a point lie in the 5x5x5
+    * voxels around its own.
+    */
+  const double kLeafScale = 0.999 / std::sqrt (3.0);
+
+  struct Point
+  {
+    float x, y, z;
+  };
+
+  /** \brief The bounding box of the points of a voxel. */
+  struct Bounds
+  {
+    Point min, max;
+  };
+
+  /** \brief Squared distance between two bounding boxes, a lower bound of the distances between their points. */
+  inline float
+  squaredDistance (const Bounds &a, const Bounds &b)
+  {
+    const float dx = std::max (0.0f, std::max (a.min.x - b.max.x, b.min.x - a.max.x));
+    const float dy = std::max (0.0f, std::max (a.min.y - b.max.y, b.min.y - a.max.y));
+    const float dz = std::max (0.0f, std::max (a.min.z - b.max.z, b.min.z - a.max.z));
+    return (dx * dx + dy * dy + dz * dz);
+  }
+
+  /** \brief Run f (task) for task in [0; nr_tasks), on nr_threads threads. */
+  template <typename F> void
+  parallelFor (size_t nr_tasks, size_t nr_threads, const F &f)
+  {
+    if (nr_threads <= 1)
+    {
+      for (size_t task = 0; task < nr_tasks; ++task)
+        f (task);
+      return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve (nr_threads);
+    for (size_t thread = 0; thread < nr_threads; ++thread)
+    {
+      threads.emplace_back ([&f, thread, nr_tasks, nr_threads]
+      {
+        for (size_t task = thread; task < nr_tasks; task += nr_threads)
+          f (task);
+      });
+    }
+    for (std::thread &thread : threads)
+      thread.join ();
+  }
+
+  /** \brief Find the root of the set of x, halving the path on the way. Parents are always smaller than their
+    * children, so concurrent halvings cannot create cycles.
+    */
+  inline uint32_t
+  findRoot (std::atomic<uint32_t> *parent, uint32_t x)
+  {
+    uint32_t p = parent[x].load (std::memory_order_relaxed);
+    while (p != x)
+    {
+      const uint32_t grand_parent = parent[p].load (std::memory_order_relaxed);
+      if (grand_parent != p)
+      {
+        uint32_t expected = p;
+        parent[x].compare_exchange_weak (expected, grand_parent, std::memory_order_relaxed);
+      }
+      x = grand_parent;
+      p = parent[x].load (std::memory_order_relaxed);
+    }
+    return (x);
+  }
+
+  /** \brief Join the sets of a and b, linking the larger root under the smaller one. Lock-free: the link only
+    * succeeds if the root is still a root, otherwise the roots are searched again.
+    */
+  inline void
+  unite (std::atomic<uint32_t> *parent, uint32_t a, uint32_t b)
+  {
+    while (true)
+    {
+      a = findRoot (parent, a);
+      b = findRoot (parent, b);
+      if (a == b)
+        return;
+      if (a < b)
+        std::swap (a, b);
+      uint32_t expected = a;
+      if (parent[a].compare_exchange_strong (expected, b, std::memory_order_relaxed))
+        return;
+    }
+  }
+
+  /** \brief Check whether a point of [a_begin; a_end) is within sqrt (tolerance2) of a point of [b_begin; b_end). */
+  inline bool
+  withinTolerance (const Point *a_begin, const Point *a_end, const Point *b_begin, const Point *b_end,
+                   float tolerance2)
+  {
+    for (const Point *a = a_begin; a != a_end; ++a)
+    {
+      for (const Point *b = b_begin; b != b_end; ++b)
+      {
+        const float dx = a->x - b->x;
+        const float dy = a->y - b->y;
+        const float dz = a->z - b->z;
+        if (dx * dx + dy * dy + dz * dz <= tolerance2)
+          return (true);
+      }
+    }
+    return (false);
+  }
+}  // namespace
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::VoxelClustering::extract (const pcl::PointCloud<pcl::PointXYZ> &cloud,
+                                   const std::shared_ptr<const std::vector<int> > &indices,
+                                   std::vector<pcl::PointIndices> &clusters) const
+{
+  clusters.clear ();
+  if (!(tolerance_ > 0.0))
+    return;
+
+  const size_t nr_selected = indices ? indices->size () : cloud.points.size ();
+  if (nr_selected == 0)
+    return;
+
+  size_t nr_threads = nr_threads_ > 0 ? nr_threads_ : std::max (1u, std::thread::hardware_concurrency ());
+  nr_threads = std::max<size_t> (1, std::min (nr_threads, nr_selected / kMinPointsPerThread));
+
+  const float inverse_leaf_size = static_cast<float> (1.0 / (tolerance_ * kLeafScale));
+  const float inverse_leaf_sizes[3] = {inverse_leaf_size, inverse_leaf_size, inverse_leaf_size};
+  const float tolerance2 = static_cast<float> (tolerance_ * tolerance_);
+  const uint32_t npos = VoxelHashMap::npos;
+
+  // 1. Compute the voxel keys of the points, in parallel
+  std::vector<VoxelKey> keys (nr_selected);
+  std::vector<uint8_t> valid (nr_selected);
+  parallelFor (nr_threads, nr_threads, [&] (size_t thread)
+  {
+    const size_t begin = nr_selected * thread / nr_threads;
+    const size_t end = nr_selected * (thread + 1) / nr_threads;
+    for (size_t j = begin; j < end; ++j)
+    {
+      const pcl::PointXYZ &p = cloud.points[indices ? (*indices)[j] : j];
+      valid[j] = pcl_ros::computeVoxelKey (p.x, p.y, p.z, inverse_leaf_sizes, keys[j]);
+    }
+  });
+
+  // 2. Number the voxels and sort the points by voxel
+  VoxelHashMap map (nr_selected / 4);
+  std::vector<VoxelKey> voxel_keys;
+  std::vector<uint32_t> voxel_of (nr_selected, npos);
+  std::vector<uint32_t> voxel_begin;
+  for (size_t j = 0; j < nr_selected; ++j)
+  {
+    if (!valid[j])
+      continue;
+    bool inserted;
+    const uint32_t voxel = map.insert (keys[j], inserted);
+    if (inserted)
+    {
+      voxel_keys.push_back (keys[j]);
+      voxel_begin.push_back (0);
+    }
+    voxel_of[j] = voxel;
+    ++voxel_begin[voxel];
+  }
+  const size_t nr_voxels = voxel_keys.size ();
+  if (nr_voxels == 0)
+    return;
+
+  // Counts to offsets, voxel v holds the points [voxel_begin[v]; voxel_begin[v + 1])
+  uint32_t offset = 0;
+  for (uint32_t &begin : voxel_begin)
+  {
+    const uint32_t count = begin;
+    begin = offset;
+    offset += count;
+  }
+  voxel_begin.push_back (offset);
+
+  std::vector<Point> points (offset);
+  {
+    std::vector<uint32_t> next (voxel_begin.begin (), voxel_begin.end () - 1);
+    for (size_t j = 0; j < nr_selected; ++j)
+    {
+      if (voxel_of[j] == npos)
+        continue;
+      const pcl::PointXYZ &p = cloud.points[indices ? (*indices)[j] : j];
+      points[next[voxel_of[j]]++] = Point {p.x, p.y, p.z};
+    }
+  }
+
+  std::vector<Bounds> bounds (nr_voxels);
+  parallelFor (nr_threads, nr_threads, [&] (size_t thread)
+  {
+    const size_t end = nr_voxels * (thread + 1) / nr_threads;
+    for (size_t v = nr_voxels * thread / nr_threads; v < end; ++v)
+    {
+      Bounds &b = bounds[v];
+      b.min = b.max = points[voxel_begin[v]];
+      for (uint32_t i = voxel_begin[v] + 1; i < voxel_begin[v + 1]; ++i)
+      {
+        const Point &p = points[i];
+        b.min.x = std::min (b.min.x, p.x); b.min.y = std::min (b.min.y, p.y); b.min.z = std::min (b.min.z, p.z);
+        b.max.x = std::max (b.max.x, p.x); b.max.y = std::max (b.max.y, p.y); b.max.z = std::max (b.max.z, p.z);
+      }
+    }
+  });
+
+  // The forward half of the 5x5x5 neighborhood, each pair of voxels is tested once
+  std::vector<VoxelKey> offsets;
+  for (int dz = -2; dz <= 2; ++dz)
+    for (int dy = -2; dy <= 2; ++dy)
+      for (int dx = -2; dx <= 2; ++dx)
+        if (dz > 0 || (dz == 0 && (dy > 0 || (dy == 0 && dx > 0))))
+          offsets.push_back (VoxelKey {dx, dy, dz});
+
+  // 3. Join the neighboring voxels, in parallel. All the points of a voxel are within the tolerance of each other, so
+  // the union-find runs on voxels.
+  std::unique_ptr<std::atomic<uint32_t>[]> parent (new std::atomic<uint32_t>[nr_voxels]);
+  for (size_t v = 0; v < nr_voxels; ++v)
+    parent[v].store (static_cast<uint32_t> (v), std::memory_order_relaxed);
+
+  const size_t nr_tasks = (nr_voxels + kVoxelsPerTask - 1) / kVoxelsPerTask;
+  parallelFor (nr_tasks, nr_threads, [&] (size_t task)
+  {
+    const size_t end = std::min (nr_voxels, (task + 1) * kVoxelsPerTask);
+    for (size_t v = task * kVoxelsPerTask; v < end; ++v)
+    {
+      const VoxelKey &key = voxel_keys[v];
+      for (const VoxelKey &d : offsets)
+      {
+        // Wrapping around is harmless, the neighbor is just not found
+        const VoxelKey neighbor_key = {static_cast<int32_t> (static_cast<uint32_t> (key.x) + d.x),
+                                       static_cast<int32_t> (static_cast<uint32_t> (key.y) + d.y),
+                                       static_cast<int32_t> (static_cast<uint32_t> (key.z) + d.z)};
+        const uint32_t u = map.find (neighbor_key);
+        if (u == npos)
+          continue;
+        if (squaredDistance (bounds[v], bounds[u]) > tolerance2 ||
+            findRoot (parent.get (), static_cast<uint32_t> (v)) == findRoot (parent.get (), u))
+          continue;
+        if (!refine_ ||
+            withinTolerance (&points[voxel_begin[v]], &points[voxel_begin[v + 1]],
+                             &points[voxel_begin[u]], &points[voxel_begin[u + 1]], tolerance2))
+          unite (parent.get (), static_cast<uint32_t> (v), u);
+      }
+    }
+  });
+
+  // 4. Gather the points of each set, keeping the sets whose size is within the limits
+  std::vector<uint32_t> cluster_of (nr_voxels, npos);
+  std::vector<uint32_t> root_size (nr_voxels, 0);
+  for (size_t v = 0; v < nr_voxels; ++v)
+  {
+    const uint32_t root = findRoot (parent.get (), static_cast<uint32_t> (v));
+    root_size[root] += voxel_begin[v + 1] - voxel_begin[v];
+  }
+  for (size_t v = 0; v < nr_voxels; ++v)
+  {
+    const uint32_t root = findRoot (parent.get (), static_cast<uint32_t> (v));
+    if (cluster_of[root] == npos && root_size[root] >= static_cast<uint32_t> (std::max (0, min_cluster_size_)) &&
+        root_size[root] <= static_cast<uint32_t> (std::max (0, max_cluster_size_)))
+    {
+      cluster_of[root] = static_cast<uint32_t> (clusters.size ());
+      clusters.emplace_back ();
+      clusters.back ().indices.reserve (root_size[root]);
+    }
+    cluster_of[v] = cluster_of[root];
+  }
+
+  for (size_t j = 0; j < nr_selected; ++j)
+  {
+    if (voxel_of[j] == npos)
+      continue;
+    const uint32_t cluster = cluster_of[voxel_of[j]];
+    if (cluster != npos)
+      clusters[cluster].indices.push_back (indices ? (*indices)[j] : static_cast<int> (j));
+  }
+
+  if (indices)
+  {
+    for (pcl::PointIndices &cluster : clusters)
+      std::sort (cluster.indices.begin (), cluster.indices.end ());
+  }
+  std::stable_sort (clusters.begin (), clusters.end (), [] (const pcl::PointIndices &a, const pcl::PointIndices &b)
+  {
+    return (a.indices.size () > b.indices.size ());
+  });
+
+  for (pcl::PointIndices &cluster : clusters)
+    cluster.header = cloud.header;
+}
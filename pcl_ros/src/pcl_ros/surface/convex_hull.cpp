@@ -67,14 +67,14 @@ void pcl_ros::ConvexHull2D::subscribe()
 
     if (approximate_sync_)
     {
-      sync_input_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointIndices>>>(max_queue_size_);
+      sync_input_indices_a_ = std::make_shared<message_filters::Synchronizer<sync_policies::ApproximateTime<PointCloud, PointIndices>>>(inputQueueSize());
       // surface not enabled, connect the input-indices duo and register
       sync_input_indices_a_->connectInput(sub_input_filter_, sub_indices_filter_);
       sync_input_indices_a_->registerCallback(std::bind(&ConvexHull2D::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
     }
     else
     {
-      sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointIndices>>>(max_queue_size_);
+      sync_input_indices_e_ = std::make_shared<message_filters::Synchronizer<sync_policies::ExactTime<PointCloud, PointIndices>>>(inputQueueSize());
       // surface not enabled, connect the input-indices duo and register
       sync_input_indices_e_->connectInput(sub_input_filter_, sub_indices_filter_);
       sync_input_indices_e_->registerCallback(std::bind(&ConvexHull2D::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
@@ -147,7 +147,7 @@ void pcl_ros::ConvexHull2D::input_indices_callback(const PointCloudPtr &cloud,
   // Reset the indices and surface pointers
   IndicesPtr indices_ptr;
   if (indices)
-    indices_ptr.reset(new std::vector<int>(indices->indices));
+    indices_ptr = indicesFromMsg(indices);
 
   impl_.setInputCloud(cloud);
   impl_.setIndices(indices_ptr);
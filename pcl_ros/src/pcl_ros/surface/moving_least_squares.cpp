@@ -80,14 +80,14 @@ pcl_ros::MovingLeastSquares::subscribe ()
 
     if (approximate_sync_)
     {
-      sync_input_indices_a_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<PointCloudIn, PointIndices> > >(max_queue_size_);
+      sync_input_indices_a_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ApproximateTime<PointCloudIn, PointIndices> > >(inputQueueSize());
       // surface not enabled, connect the input-indices duo and register
       sync_input_indices_a_->connectInput (sub_input_filter_, sub_indices_filter_);
       sync_input_indices_a_->registerCallback (std::bind (&MovingLeastSquares::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
     }
     else
     {
-      sync_input_indices_e_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ExactTime<PointCloudIn, PointIndices> > >(max_queue_size_);
+      sync_input_indices_e_ = std::make_shared <message_filters::Synchronizer<message_filters::sync_policies::ExactTime<PointCloudIn, PointIndices> > >(inputQueueSize());
       // surface not enabled, connect the input-indices duo and register
       sync_input_indices_e_->connectInput (sub_input_filter_, sub_indices_filter_);
       sync_input_indices_e_->registerCallback (std::bind (&MovingLeastSquares::input_indices_callback, this, std::placeholders::_1, std::placeholders::_2));
@@ -165,9 +165,9 @@ pcl_ros::MovingLeastSquares::input_indices_callback (const PointCloudInConstPtr
 
   IndicesPtr indices_ptr;
   if (indices)
-    indices_ptr.reset (new std::vector<int> (indices->indices));
+    indices_ptr = indicesFromMsg (indices);
 
-  impl_.setIndices (indices_ptr.get());
+  impl_.setIndices (indices_ptr);
 
   // Initialize the spatial locator
   
@@ -0,0 +1,212 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+
+#include <pcl/search/kdtree.h>
+#include <pcl/search/organized.h>
+#include <pcl_conversions/pcl_conversions.hpp>
+
+#include "pcl_ros/search_cache.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::SearchCache &
+pcl_ros::SearchCache::instance ()
+{
+  static SearchCache cache;
+  return (cache);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::SearchCache::reserve (size_t max_entries, size_t max_bytes)
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+  max_entries_ = std::max (max_entries_, max_entries);
+  max_bytes_ = std::max (max_bytes_, max_bytes);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::SearchCache::EntryConstPtr
+pcl_ros::SearchCache::get (const sensor_msgs::msg::PointCloud2::ConstSharedPtr &cloud, Kind kind)
+{
+  if (!cloud)
+    return (EntryConstPtr ());
+
+  std::promise<EntryConstPtr> promise;
+  uint64_t id = 0;
+  {
+    std::unique_lock<std::mutex> lock (mutex_);
+    for (auto it = slots_.begin (); it != slots_.end (); )
+    {
+      // A released message cannot be asked for again, and its buffer may be reused by the next one
+      if (it->message.expired ())
+      {
+        statistics_.bytes -= it->bytes;
+        it = slots_.erase (it);
+        continue;
+      }
+      if (it->data == cloud->data.data () && it->sec == cloud->header.stamp.sec &&
+          it->nanosec == cloud->header.stamp.nanosec && it->frame_id == cloud->header.frame_id && it->kind == kind)
+      {
+        slots_.splice (slots_.begin (), slots_, it);
+        std::shared_future<EntryConstPtr> entry = slots_.front ().entry;
+        lock.unlock ();
+        // Possibly still being built by another node
+        const EntryConstPtr result = entry.get ();
+        lock.lock ();
+        // A failed build saves nothing
+        if (result)
+        {
+          ++statistics_.hits;
+          statistics_.build_ms_saved += result->build_ms;
+        }
+        return (result);
+      }
+      ++it;
+    }
+
+    ++statistics_.misses;
+    Slot slot;
+    slot.id = id = next_id_++;
+    slot.data = cloud->data.data ();
+    slot.sec = cloud->header.stamp.sec;
+    slot.nanosec = cloud->header.stamp.nanosec;
+    slot.frame_id = cloud->header.frame_id;
+    slot.kind = kind;
+    slot.message = cloud;
+    slot.entry = promise.get_future ().share ();
+    slots_.push_front (slot);
+  }
+
+  EntryConstPtr result;
+  try
+  {
+    result = build (*cloud, kind);
+  }
+  catch (const std::exception &)
+  {
+    // Cached as a failure, the same cloud would fail again
+  }
+  promise.set_value (result);
+
+  std::lock_guard<std::mutex> lock (mutex_);
+  for (Slot &slot : slots_)
+  {
+    if (slot.id != id)
+      continue;
+    slot.built = true;
+    slot.bytes = result ? result->bytes : 0;
+    statistics_.bytes += slot.bytes;
+    break;
+  }
+  evict ();
+  return (result);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::SearchCache::Statistics
+pcl_ros::SearchCache::statistics () const
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+  Statistics statistics = statistics_;
+  statistics.entries = slots_.size ();
+  return (statistics);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::SearchCache::clear ()
+{
+  std::lock_guard<std::mutex> lock (mutex_);
+  // Entries being built are removed once built
+  for (auto it = slots_.begin (); it != slots_.end (); )
+  {
+    if (it->built)
+    {
+      statistics_.bytes -= it->bytes;
+      it = slots_.erase (it);
+    }
+    else
+      ++it;
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+pcl_ros::SearchCache::EntryConstPtr
+pcl_ros::SearchCache::build (const sensor_msgs::msg::PointCloud2 &cloud, Kind kind)
+{
+  const auto start = std::chrono::steady_clock::now ();
+  int nr_xyz = 0;
+  for (const sensor_msgs::msg::PointField &field : cloud.fields)
+    nr_xyz += (field.name == "x" || field.name == "y" || field.name == "z");
+  if (nr_xyz != 3 || (kind == ORGANIZED && cloud.height <= 1))
+    return (EntryConstPtr ());
+
+  Cloud::Ptr xyz (new Cloud);
+  pcl::fromROSMsg (cloud, *xyz);
+  std::shared_ptr<Entry> entry (new Entry);
+  if (kind == ORGANIZED)
+    entry->search.reset (new pcl::search::OrganizedNeighbor<pcl::PointXYZ> ());
+  else
+    entry->search.reset (new pcl::search::KdTree<pcl::PointXYZ> (false));
+  entry->search->setInputCloud (xyz);
+  entry->cloud = xyz;
+
+  entry->build_ms = std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+  // The kd-tree holds a copy of the coordinates, an index map and about one node per leaf of a few points
+  entry->bytes = xyz->size () * sizeof (pcl::PointXYZ);
+  if (kind == KDTREE)
+    entry->bytes += xyz->size () * (3 * sizeof (float) + 2 * sizeof (int));
+  return (entry);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+void
+pcl_ros::SearchCache::evict ()
+{
+  size_t nr_built = 0;
+  for (const Slot &slot : slots_)
+    nr_built += slot.built;
+  for (auto it = slots_.end (); it != slots_.begin () && (nr_built > max_entries_ || statistics_.bytes > max_bytes_); )
+  {
+    --it;
+    if (!it->built)
+      continue;
+    statistics_.bytes -= it->bytes;
+    ++statistics_.evictions;
+    --nr_built;
+    it = slots_.erase (it);
+  }
+}
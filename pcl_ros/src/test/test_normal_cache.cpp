@@ -0,0 +1,292 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <tuple>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/features/normal_3d.h>
+#include <pcl/search/kdtree.h>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/features/normal_cache.hpp"
+#include "test_utils.hpp"
+
+typedef pcl::PointCloud<pcl::PointXYZ> PointCloud;
+typedef pcl::PointCloud<pcl::Normal> Normals;
+
+static const uint32_t kWidth = 40, kHeight = 30;
+static const float kSpacing = 0.02f;
+
+/** \brief An organized view of a plane folded along x = 0.4, with sensor noise. Some points are NaN, on the border
+  * rows and columns too. The points with x < \a raised_x are raised by 0.2 m.
+  */
+static PointCloud
+makeFrame (unsigned int seed, float raised_x = -1.0f)
+{
+  PointCloud cloud;
+  std::mt19937 rng (seed);
+  std::normal_distribution<float> noise (0.0f, 0.001f);
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  for (uint32_t v = 0; v < kHeight; ++v)
+  {
+    for (uint32_t u = 0; u < kWidth; ++u)
+    {
+      const size_t i = v * kWidth + u;
+      if (i % 17 == 0 || (u == kWidth - 1 && v % 5 == 0) || (v == kHeight - 1 && u % 7 == 0))
+      {
+        cloud.points.push_back (pcl::PointXYZ (nan, nan, nan));
+        continue;
+      }
+      const float x = kSpacing * u, y = kSpacing * v;
+      float z = 1.0f + 0.3f * std::max (0.0f, x - 0.4f);
+      if (x < raised_x)
+        z += 0.2f;
+      cloud.points.push_back (pcl::PointXYZ (x + noise (rng), y + noise (rng), z + noise (rng)));
+    }
+  }
+  cloud.width = kWidth;
+  cloud.height = kHeight;
+  cloud.is_dense = false;
+  return (cloud);
+}
+
+/** \brief The normals of a frame computed by pcl::NormalEstimation, as NormalEstimation does for the changed points. */
+static Normals
+referenceNormals (const PointCloud &cloud)
+{
+  pcl::NormalEstimation<pcl::PointXYZ, pcl::Normal> reference;
+  reference.setInputCloud (cloud.makeShared ());
+  reference.setSearchMethod (pcl::search::KdTree<pcl::PointXYZ>::Ptr (new pcl::search::KdTree<pcl::PointXYZ>));
+  reference.setKSearch (10);
+  Normals normals;
+  reference.compute (normals);
+  return (normals);
+}
+
+/** \brief Look a frame up in the cache, check the reused normals against pcl::NormalEstimation, and store the frame
+  * completed with the reference normals of the changed points.
+  * \return the number of reused normals
+  */
+static size_t
+processFrame (pcl_ros::NormalCache &cache, const PointCloud &cloud, std::vector<int> &changed)
+{
+  Normals normals;
+  const size_t nr_reused = cache.lookup (cloud, normals, changed);
+  EXPECT_EQ (normals.points.size (), cloud.points.size ());
+  EXPECT_EQ (normals.width, cloud.width);
+  EXPECT_EQ (normals.height, cloud.height);
+
+  const Normals expected = referenceNormals (cloud);
+  std::vector<uint8_t> is_changed (cloud.points.size ());
+  for (int index : changed)
+  {
+    EXPECT_TRUE (pcl::isFinite (cloud.points[index]));
+    is_changed[index] = 1;
+  }
+  size_t nr_finite = 0;
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    const pcl::Normal &n = normals.points[i];
+    if (!pcl::isFinite (cloud.points[i]))
+    {
+      // Neither reused nor recomputed
+      EXPECT_TRUE (std::isnan (n.normal_x));
+      EXPECT_FALSE (is_changed[i]);
+      continue;
+    }
+    ++nr_finite;
+    if (is_changed[i])
+    {
+      EXPECT_TRUE (std::isnan (n.normal_x));
+      continue;
+    }
+    const pcl::Normal &e = expected.points[i];
+    EXPECT_GT (n.normal_x * e.normal_x + n.normal_y * e.normal_y + n.normal_z * e.normal_z, 0.95f)
+      << "point " << i % kWidth << ", " << i / kWidth;
+  }
+  // Every valid point gets a normal, reused or recomputed
+  EXPECT_EQ (nr_reused + changed.size (), nr_finite);
+
+  for (int index : changed)
+    normals.points[index] = expected.points[index];
+  cache.update (cloud, normals);
+  return (nr_reused);
+}
+
+TEST (NormalCache, reusedNormalsMatchNormalEstimation)
+{
+  pcl_ros::NormalCache cache;
+  cache.setLeafSize (0.1f);
+  cache.setTolerance (0.01f);
+
+  std::vector<int> changed;
+  EXPECT_EQ (processFrame (cache, makeFrame (1), changed), 0u);
+  EXPECT_FALSE (changed.empty ());
+
+  // Static scene: almost everything is reused
+  const size_t nr_reused = processFrame (cache, makeFrame (2), changed);
+  EXPECT_GT (nr_reused, 4 * changed.size ());
+
+  // The raised points are all recomputed
+  const PointCloud raised = makeFrame (3, 0.2f);
+  processFrame (cache, raised, changed);
+  std::vector<uint8_t> is_changed (raised.points.size ());
+  for (int index : changed)
+    is_changed[index] = 1;
+  for (size_t i = 0; i < raised.points.size (); ++i)
+  {
+    if (pcl::isFinite (raised.points[i]) && raised.points[i].x < 0.2f)
+      EXPECT_TRUE (is_changed[i]) << "point " << i % kWidth << ", " << i / kWidth;
+  }
+}
+
+/** \brief Normals that tell the point they belong to: normal_x is its index. */
+static Normals
+indexNormals (const PointCloud &cloud)
+{
+  Normals normals;
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    pcl::Normal n;
+    n.normal_x = static_cast<float> (i);
+    n.normal_y = n.normal_z = n.curvature = 0.0f;
+    normals.points.push_back (n);
+  }
+  normals.width = cloud.width;
+  normals.height = cloud.height;
+  return (normals);
+}
+
+/** \brief The voxel of a point, as NormalCache bins it. */
+static std::tuple<int, int, int>
+voxelOf (const pcl::PointXYZ &p, float leaf_size)
+{
+  const float inverse = 1.0f / leaf_size;
+  return (std::make_tuple (static_cast<int> (std::floor (p.x * inverse)), static_cast<int> (std::floor (p.y * inverse)),
+                           static_cast<int> (std::floor (p.z * inverse))));
+}
+
+/** \brief The finite points of a frame, shuffled, as an unorganized cloud. */
+static PointCloud
+unorganized (const PointCloud &frame, unsigned int seed)
+{
+  PointCloud cloud = pcl_ros::test::finitePoints (frame);
+  std::mt19937 rng (seed);
+  std::shuffle (cloud.points.begin (), cloud.points.end (), rng);
+  return (cloud);
+}
+
+TEST (NormalCache, reusesTheNearestPreviousPoint)
+{
+  const float leaf_size = 0.1f;
+  pcl_ros::NormalCache cache;
+  cache.setLeafSize (leaf_size);
+  cache.setTolerance (0.01f);
+
+  const PointCloud previous = unorganized (makeFrame (1), 1);
+  Normals normals;
+  std::vector<int> changed;
+  cache.lookup (previous, normals, changed);
+  cache.update (previous, indexNormals (previous));
+
+  const PointCloud cloud = unorganized (makeFrame (2), 2);
+  ASSERT_GT (cache.lookup (cloud, normals, changed), 0u);
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    if (std::isnan (normals.points[i].normal_x))
+      continue;
+    // The same distance as the nearest point of the previous frame in the same voxel
+    const Eigen::Vector3f p = cloud.points[i].getVector3fMap ();
+    float best = std::numeric_limits<float>::max ();
+    for (const pcl::PointXYZ &q : previous.points)
+    {
+      if (voxelOf (q, leaf_size) == voxelOf (cloud.points[i], leaf_size))
+        best = std::min (best, (q.getVector3fMap () - p).squaredNorm ());
+    }
+    const size_t reused = static_cast<size_t> (normals.points[i].normal_x);
+    ASSERT_LT (reused, previous.points.size ());
+    EXPECT_EQ (voxelOf (previous.points[reused], leaf_size), voxelOf (cloud.points[i], leaf_size));
+    EXPECT_EQ ((previous.points[reused].getVector3fMap () - p).squaredNorm (), best) << "point " << i;
+  }
+}
+
+TEST (NormalCache, reusesTheSamePixel)
+{
+  const float leaf_size = 0.1f;
+  pcl_ros::NormalCache cache;
+  cache.setLeafSize (leaf_size);
+  cache.setTolerance (0.01f);
+
+  const PointCloud previous = makeFrame (1);
+  Normals normals;
+  std::vector<int> changed;
+  cache.lookup (previous, normals, changed);
+  cache.update (previous, indexNormals (previous));
+
+  const PointCloud cloud = makeFrame (2);
+  ASSERT_GT (cache.lookup (cloud, normals, changed), 0u);
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    if (std::isnan (normals.points[i].normal_x) || !pcl::isFinite (previous.points[i]) ||
+        voxelOf (previous.points[i], leaf_size) != voxelOf (cloud.points[i], leaf_size))
+      continue;
+    EXPECT_EQ (normals.points[i].normal_x, static_cast<float> (i));
+  }
+}
+
+TEST (NormalCache, emptyInput)
+{
+  pcl_ros::NormalCache cache;
+  cache.setLeafSize (0.1f);
+  Normals normals;
+  std::vector<int> changed;
+  EXPECT_EQ (cache.lookup (PointCloud (), normals, changed), 0u);
+  EXPECT_TRUE (normals.points.empty ());
+  EXPECT_TRUE (changed.empty ());
+  cache.update (PointCloud (), normals);
+
+  // An empty frame between two full ones invalidates the cache
+  processFrame (cache, makeFrame (1), changed);
+  cache.lookup (PointCloud (), normals, changed);
+  cache.update (PointCloud (), normals);
+  EXPECT_EQ (processFrame (cache, makeFrame (2), changed), 0u);
+}
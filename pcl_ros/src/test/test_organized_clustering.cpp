@@ -0,0 +1,168 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/segmentation/extract_clusters.h>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/segmentation/organized_clustering.hpp"
+#include "test_utils.hpp"
+
+typedef pcl::PointCloud<pcl::PointXYZ> PointCloud;
+
+static const uint32_t kWidth = 48, kHeight = 32;
+static const float kTolerance = 0.05f;
+
+/** \brief A depth image of a wall at 2 m with two boxes in front of it, at 1 m and 1.5 m, with sensor noise. The
+  * pixels are 0.01 rad apart, so that the points of a surface are 0.01 to 0.02 m apart, well within the tolerance,
+  * and the surfaces are far apart. No two points are exactly at the tolerance: the organized segmentation joins
+  * pixels strictly closer than the tolerance, pcl::EuclideanClusterExtraction joins points at the tolerance too.
+  *
+  * Holes of NaN pixels are cut in the wall and in a box, and on the image borders. None of them disconnects the
+  * pixels of a surface, as a gap narrower than the tolerance would be crossed by pcl::EuclideanClusterExtraction only.
+  */
+static PointCloud
+makeCloud ()
+{
+  PointCloud cloud;
+  std::mt19937 rng (3);
+  std::normal_distribution<float> noise (0.0f, 0.001f);
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  for (uint32_t v = 0; v < kHeight; ++v)
+  {
+    for (uint32_t u = 0; u < kWidth; ++u)
+    {
+      const bool hole = (u >= 2 && u < 5 && v >= 20 && v < 23) || (u >= 13 && u < 15 && v >= 12 && v < 14) ||
+                        (u == 0 && v % 4 == 0) || (v == kHeight - 1 && u % 5 == 0);
+      if (hole)
+      {
+        cloud.points.push_back (pcl::PointXYZ (nan, nan, nan));
+        continue;
+      }
+      float depth = 2.0f;
+      if (u >= 10 && u < 20 && v >= 8 && v < 20)
+        depth = 1.0f;
+      else if (u >= 30 && u < 40 && v >= 5 && v < 25)
+        depth = 1.5f;
+      const float x = 0.01f * (static_cast<float> (u) - kWidth / 2.0f) * depth;
+      const float y = 0.01f * (static_cast<float> (v) - kHeight / 2.0f) * depth;
+      cloud.points.push_back (pcl::PointXYZ (x + noise (rng), y + noise (rng), depth + noise (rng)));
+    }
+  }
+  cloud.width = kWidth;
+  cloud.height = kHeight;
+  cloud.is_dense = false;
+  return (cloud);
+}
+
+/** \brief Cluster with extractOrganizedClusters () and with pcl::EuclideanClusterExtraction, and compare the clusters.
+  */
+static void
+compareWithEuclideanClusterExtraction (const PointCloud &cloud, const std::shared_ptr<std::vector<int> > &indices,
+                                       int min_size, int max_size)
+{
+  pcl::EuclideanClusterExtraction<pcl::PointXYZ> reference;
+  reference.setInputCloud (cloud.makeShared ());
+  reference.setIndices (pcl_ros::test::finiteIndices (cloud, indices));
+  reference.setSearchMethod (pcl::search::KdTree<pcl::PointXYZ>::Ptr (new pcl::search::KdTree<pcl::PointXYZ>));
+  reference.setClusterTolerance (kTolerance);
+  reference.setMinClusterSize (min_size);
+  reference.setMaxClusterSize (max_size);
+  std::vector<pcl::PointIndices> expected;
+  reference.extract (expected);
+  ASSERT_FALSE (expected.empty ());
+
+  std::vector<pcl::PointIndices> actual;
+  pcl_ros::extractOrganizedClusters (cloud.makeShared (), indices, kTolerance, min_size, max_size, actual);
+
+  EXPECT_EQ (pcl_ros::test::normalize (actual), pcl_ros::test::normalize (expected));
+  // Sorted by decreasing size, with increasing indices
+  for (size_t i = 0; i < actual.size (); ++i)
+  {
+    EXPECT_TRUE (std::is_sorted (actual[i].indices.begin (), actual[i].indices.end ()));
+    if (i > 0)
+      EXPECT_GE (actual[i - 1].indices.size (), actual[i].indices.size ());
+  }
+}
+
+TEST (OrganizedClustering, clustersMatchEuclideanClusterExtraction)
+{
+  compareWithEuclideanClusterExtraction (makeCloud (), nullptr, 1, std::numeric_limits<int>::max ());
+}
+
+TEST (OrganizedClustering, sizeLimitsMatchEuclideanClusterExtraction)
+{
+  // Keeps the boxes, not the wall
+  compareWithEuclideanClusterExtraction (makeCloud (), nullptr, 50, 300);
+}
+
+TEST (OrganizedClustering, maskedIndicesMatchEuclideanClusterExtraction)
+{
+  // Mask out a band of columns, wider than the tolerance, that splits the wall in two, and a corner of a box
+  const PointCloud cloud = makeCloud ();
+  std::shared_ptr<std::vector<int> > indices (new std::vector<int>);
+  for (uint32_t v = 0; v < kHeight; ++v)
+  {
+    for (uint32_t u = 0; u < kWidth; ++u)
+    {
+      if ((u >= 24 && u < 27) || (u >= 30 && u < 33 && v >= 5 && v < 9))
+        continue;
+      indices->push_back (static_cast<int> (v * kWidth + u));
+    }
+  }
+  compareWithEuclideanClusterExtraction (cloud, indices, 1, std::numeric_limits<int>::max ());
+
+  std::vector<pcl::PointIndices> clusters;
+  pcl_ros::extractOrganizedClusters (cloud.makeShared (), indices, kTolerance, 1, std::numeric_limits<int>::max (),
+                                     clusters);
+  // The two halves of the wall and the two boxes
+  EXPECT_EQ (clusters.size (), 4u);
+}
+
+TEST (OrganizedClustering, emptyInput)
+{
+  const PointCloud cloud = makeCloud ();
+  std::vector<pcl::PointIndices> clusters (1);
+  pcl_ros::extractOrganizedClusters (cloud.makeShared (), std::shared_ptr<std::vector<int> > (new std::vector<int>),
+                                     kTolerance, 1, std::numeric_limits<int>::max (), clusters);
+  EXPECT_TRUE (clusters.empty ());
+}
@@ -0,0 +1,250 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.hpp>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/filters/organized_neighborhood.hpp"
+#include "test_utils.hpp"
+
+typedef pcl::PointCloud<pcl::PointXYZ> PointCloud;
+
+/** \brief A noisy organized surface of width x height pixels, with a few NaN points, on the borders too. */
+static PointCloud
+makeCloud (uint32_t width, uint32_t height)
+{
+  PointCloud cloud;
+  std::mt19937 rng (42);
+  std::normal_distribution<float> noise (0.0f, 0.02f);
+  std::uniform_int_distribution<int> invalid (0, 9);
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  for (uint32_t v = 0; v < height; ++v)
+  {
+    for (uint32_t u = 0; u < width; ++u)
+    {
+      if (invalid (rng) == 0 || (u == 0 && v == 0) || (u == width - 1 && v == height - 1))
+        cloud.points.push_back (pcl::PointXYZ (nan, nan, nan));
+      else
+        cloud.points.push_back (pcl::PointXYZ (0.05f * u + noise (rng), 0.05f * v + noise (rng), 1.0f + noise (rng)));
+    }
+  }
+  // A few outliers
+  cloud.points[width + 1].z = 3.0f;
+  cloud.points[cloud.points.size () / 2].z = -2.0f;
+  cloud.width = width;
+  cloud.height = height;
+  cloud.is_dense = false;
+  return (cloud);
+}
+
+/** \brief Squared distances of a pixel to the valid points of its window, by brute force. */
+static std::vector<float>
+windowDistances (const PointCloud &cloud, int u, int v, int half_window)
+{
+  std::vector<float> sqr_distances;
+  const pcl::PointXYZ &p = cloud.points[v * cloud.width + u];
+  for (int nv = v - half_window; nv <= v + half_window; ++nv)
+  {
+    for (int nu = u - half_window; nu <= u + half_window; ++nu)
+    {
+      if (nu < 0 || nv < 0 || nu >= static_cast<int> (cloud.width) || nv >= static_cast<int> (cloud.height) ||
+          (nu == u && nv == v))
+        continue;
+      const pcl::PointXYZ &q = cloud.points[nv * cloud.width + nu];
+      if (!pcl::isFinite (q))
+        continue;
+      const float ex = p.x - q.x, ey = p.y - q.y, ez = p.z - q.z;
+      sqr_distances.push_back (ex * ex + ey * ey + ez * ez);
+    }
+  }
+  return (sqr_distances);
+}
+
+static pcl_ros::OrganizedNeighborhood
+load (const PointCloud &cloud)
+{
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg (cloud, msg);
+  pcl_ros::OrganizedNeighborhood neighborhood;
+  EXPECT_TRUE (neighborhood.setInputCloud (msg));
+  return (neighborhood);
+}
+
+TEST (OrganizedNeighborhood, meanDistancesMatchBruteForce)
+{
+  const PointCloud cloud = makeCloud (13, 7);
+  const pcl_ros::OrganizedNeighborhood neighborhood = load (cloud);
+  // The last window is larger than the image
+  for (int half_window : {1, 2, 5})
+  {
+    for (int k : {1, 4, 8, 200})
+    {
+      std::vector<float> mean_distances;
+      neighborhood.computeMeanDistances (half_window, k, mean_distances);
+      ASSERT_EQ (mean_distances.size (), cloud.points.size ());
+      for (int v = 0; v < static_cast<int> (cloud.height); ++v)
+      {
+        for (int u = 0; u < static_cast<int> (cloud.width); ++u)
+        {
+          const float mean = mean_distances[v * cloud.width + u];
+          if (!pcl::isFinite (cloud.points[v * cloud.width + u]))
+          {
+            EXPECT_TRUE (std::isnan (mean));
+            continue;
+          }
+          std::vector<float> sqr_distances = windowDistances (cloud, u, v, half_window);
+          std::sort (sqr_distances.begin (), sqr_distances.end ());
+          const size_t nr_neighbors = std::min (static_cast<size_t> (k), sqr_distances.size ());
+          if (nr_neighbors == 0)
+          {
+            EXPECT_TRUE (std::isinf (mean));
+            continue;
+          }
+          double sum = 0;
+          for (size_t n = 0; n < nr_neighbors; ++n)
+            sum += std::sqrt (sqr_distances[n]);
+          EXPECT_NEAR (mean, sum / nr_neighbors, 1e-5) << "u " << u << " v " << v << " k " << k;
+        }
+      }
+    }
+  }
+}
+
+TEST (OrganizedNeighborhood, radiusCountsMatchBruteForce)
+{
+  const PointCloud cloud = makeCloud (13, 7);
+  const pcl_ros::OrganizedNeighborhood neighborhood = load (cloud);
+  for (int half_window : {1, 2, 5})
+  {
+    for (float radius : {0.03f, 0.08f, 0.2f})
+    {
+      std::vector<uint16_t> counts;
+      neighborhood.computeRadiusCounts (half_window, radius, counts);
+      ASSERT_EQ (counts.size (), cloud.points.size ());
+      for (int v = 0; v < static_cast<int> (cloud.height); ++v)
+      {
+        for (int u = 0; u < static_cast<int> (cloud.width); ++u)
+        {
+          size_t expected = 0;
+          if (pcl::isFinite (cloud.points[v * cloud.width + u]))
+          {
+            for (float sqr_distance : windowDistances (cloud, u, v, half_window))
+              expected += sqr_distance <= radius * radius;
+          }
+          EXPECT_EQ (counts[v * cloud.width + u], expected) << "u " << u << " v " << v;
+        }
+      }
+    }
+  }
+}
+
+TEST (OrganizedNeighborhood, outlierRemovalMatchesBruteForce)
+{
+  const PointCloud cloud = makeCloud (13, 7);
+  const pcl_ros::OrganizedNeighborhood neighborhood = load (cloud);
+  const int mean_k = 8, half_window = pcl_ros::OrganizedNeighborhood::halfWindowForK (mean_k);
+  ASSERT_EQ (half_window, 1);
+
+  // Statistical: the same selection from brute force mean distances
+  std::vector<float> mean_distances (cloud.points.size (), std::numeric_limits<float>::quiet_NaN ());
+  for (size_t i = 0; i < cloud.points.size (); ++i)
+  {
+    if (!pcl::isFinite (cloud.points[i]))
+      continue;
+    std::vector<float> sqr_distances = windowDistances (cloud, i % cloud.width, i / cloud.width, half_window);
+    std::sort (sqr_distances.begin (), sqr_distances.end ());
+    sqr_distances.resize (std::min (sqr_distances.size (), static_cast<size_t> (mean_k)));
+    float sum = 0;
+    for (float sqr_distance : sqr_distances)
+      sum += std::sqrt (sqr_distance);
+    mean_distances[i] = sqr_distances.empty () ? std::numeric_limits<float>::infinity () : sum / sqr_distances.size ();
+  }
+  for (bool negative : {false, true})
+  {
+    std::vector<int> expected, actual;
+    pcl_ros::selectStatisticalInliers (mean_distances, 1.0, negative, nullptr, expected);
+    pcl_ros::organizedStatisticalOutlierRemoval (neighborhood, mean_k, 1.0, negative, nullptr, actual);
+    EXPECT_EQ (actual, expected);
+  }
+  std::vector<int> inliers;
+  pcl_ros::organizedStatisticalOutlierRemoval (neighborhood, mean_k, 1.0, false, nullptr, inliers);
+  EXPECT_EQ (std::count (inliers.begin (), inliers.end (), static_cast<int> (cloud.width + 1)), 0);
+
+  // Radius, on a subset of the points
+  const std::shared_ptr<std::vector<int> > indices = pcl_ros::test::everyNthIndex (cloud.points.size (), 2);
+  const float radius = 0.08f;
+  std::vector<int> expected, actual;
+  for (int index : *indices)
+  {
+    if (!pcl::isFinite (cloud.points[index]))
+      continue;
+    int count = 0;
+    for (float sqr_distance : windowDistances (cloud, index % cloud.width, index / cloud.width, 2))
+      count += sqr_distance <= radius * radius;
+    if (count >= 3)
+      expected.push_back (index);
+  }
+  pcl_ros::organizedRadiusOutlierRemoval (neighborhood, 2, radius, 3, indices, actual);
+  EXPECT_EQ (actual, expected);
+}
+
+TEST (OrganizedNeighborhood, emptyInput)
+{
+  PointCloud cloud;
+  cloud.width = 0;
+  cloud.height = 2;
+  const pcl_ros::OrganizedNeighborhood neighborhood = load (cloud);
+  EXPECT_EQ (neighborhood.size (), 0u);
+  std::vector<int> output;
+  pcl_ros::organizedStatisticalOutlierRemoval (neighborhood, 8, 1.0, false, nullptr, output);
+  EXPECT_TRUE (output.empty ());
+  pcl_ros::organizedRadiusOutlierRemoval (neighborhood, 1, 0.1, 1, nullptr, output);
+  EXPECT_TRUE (output.empty ());
+
+  // Not organized
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg (PointCloud (), msg);
+  pcl_ros::OrganizedNeighborhood unorganized;
+  EXPECT_FALSE (unorganized.setInputCloud (msg));
+}
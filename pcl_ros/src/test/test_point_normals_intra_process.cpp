@@ -0,0 +1,148 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <chrono>
+#include <memory>
+#include <random>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.hpp>
+#include <rclcpp/rclcpp.hpp>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/features/fpfh.hpp"
+#include "pcl_ros/features/normal_3d.hpp"
+
+using sensor_msgs::msg::PointCloud2;
+
+/** \brief NormalEstimation with the connections of its output publisher exposed. */
+class NormalEstimationProbe : public pcl_ros::NormalEstimation
+{
+  public:
+    using pcl_ros::NormalEstimation::NormalEstimation;
+
+    size_t
+    outputIntraProcessSubscriptions () const
+    {
+      return (pub_output_->get_intra_process_subscription_count ());
+    }
+};
+
+/** \brief A noisy 20 x 20 plane. */
+static PointCloud2::UniquePtr
+makeCloud ()
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  std::mt19937 rng (42);
+  std::normal_distribution<float> noise (0.0f, 0.002f);
+  for (int v = 0; v < 20; ++v)
+    for (int u = 0; u < 20; ++u)
+      cloud.points.push_back (pcl::PointXYZ (0.01f * u, 0.01f * v, 1.0f + noise (rng)));
+  cloud.width = static_cast<uint32_t> (cloud.points.size ());
+  cloud.height = 1;
+  cloud.is_dense = true;
+
+  auto msg = std::make_unique<PointCloud2> ();
+  pcl::toROSMsg (cloud, *msg);
+  msg->header.frame_id = "sensor";
+  msg->header.stamp.sec = 42;
+  return (msg);
+}
+
+// NormalEstimation with output_point_normals feeds FPFHEstimation with point_normals, both composed in one process
+// with intra-process communication: the bundled cloud is the only link between them and is handed over in process.
+TEST (PointNormals, intraProcessComposition)
+{
+  rclcpp::NodeOptions normals_options;
+  normals_options.use_intra_process_comms (true);
+  normals_options.arguments ({"--ros-args", "-r", "output:=point_normals"});
+  normals_options.parameter_overrides ({
+    {"k_search", 10},
+    {"radius_search", 0.0},
+    {"output_point_normals", true},
+  });
+  auto normals = std::make_shared<NormalEstimationProbe> (normals_options);
+
+  rclcpp::NodeOptions fpfh_options;
+  fpfh_options.use_intra_process_comms (true);
+  fpfh_options.arguments ({"--ros-args", "-r", "input:=point_normals", "-r", "output:=descriptors"});
+  fpfh_options.parameter_overrides ({
+    {"k_search", 10},
+    {"radius_search", 0.0},
+    {"point_normals", true},
+  });
+  auto fpfh = std::make_shared<pcl_ros::FPFHEstimation> (fpfh_options);
+
+  auto io = std::make_shared<rclcpp::Node> ("io", rclcpp::NodeOptions ().use_intra_process_comms (true));
+  auto pub_input = io->create_publisher<PointCloud2> ("input", 10);
+  PointCloud2::ConstSharedPtr descriptors;
+  auto sub_descriptors = io->create_subscription<PointCloud2> ("descriptors", 10,
+      [&descriptors] (PointCloud2::ConstSharedPtr msg) { descriptors = msg; });
+
+  // Both links are intra-process
+  EXPECT_EQ (pub_input->get_intra_process_subscription_count (), 1u);
+  EXPECT_EQ (normals->outputIntraProcessSubscriptions (), 1u);
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node (normals);
+  executor.add_node (fpfh);
+  executor.add_node (io);
+
+  PointCloud2::UniquePtr input = makeCloud ();
+  const size_t nr_points = input->width * input->height;
+  pub_input->publish (std::move (input));
+
+  const auto deadline = std::chrono::steady_clock::now () + std::chrono::seconds (10);
+  while (!descriptors && std::chrono::steady_clock::now () < deadline)
+    executor.spin_some (std::chrono::milliseconds (10));
+
+  ASSERT_TRUE (descriptors);
+  EXPECT_EQ (descriptors->width * descriptors->height, nr_points);
+  EXPECT_EQ (descriptors->header.stamp.sec, 42);
+  EXPECT_EQ (descriptors->header.frame_id, "sensor");
+  EXPECT_NE (pcl::getFieldIndex (*descriptors, "fpfh"), -1);
+}
+
+int main (int argc, char **argv)
+{
+  testing::InitGoogleTest (&argc, argv);
+  rclcpp::init (argc, argv);
+  const int result = RUN_ALL_TESTS ();
+  rclcpp::shutdown ();
+  return (result);
+}
@@ -0,0 +1,148 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <memory>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl_conversions/pcl_conversions.hpp>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/search_cache.hpp"
+
+typedef sensor_msgs::msg::PointCloud2 PointCloud2;
+
+/** \brief A small unorganized cloud message, told apart from the others by its stamp. */
+static std::shared_ptr<PointCloud2>
+makeMessage (int32_t sec)
+{
+  pcl::PointCloud<pcl::PointXYZ> cloud;
+  for (int i = 0; i < 10; ++i)
+    cloud.points.push_back (pcl::PointXYZ (0.1f * i, 0.2f * i, 0.3f * i));
+  cloud.width = static_cast<uint32_t> (cloud.points.size ());
+  cloud.height = 1;
+  std::shared_ptr<PointCloud2> message (new PointCloud2);
+  pcl::toROSMsg (cloud, *message);
+  message->header.stamp.sec = sec;
+  message->header.frame_id = "sensor";
+  return (message);
+}
+
+/** \brief The cache of the process, emptied. Its counters are cumulative, compare them before and after. */
+static pcl_ros::SearchCache &
+emptyCache ()
+{
+  pcl_ros::SearchCache &cache = pcl_ros::SearchCache::instance ();
+  cache.clear ();
+  return (cache);
+}
+
+TEST (SearchCache, hitAndMiss)
+{
+  pcl_ros::SearchCache &cache = emptyCache ();
+  const std::shared_ptr<PointCloud2> message = makeMessage (1);
+  const pcl_ros::SearchCache::Statistics before = cache.statistics ();
+
+  const pcl_ros::SearchCache::EntryConstPtr entry = cache.get (message);
+  ASSERT_TRUE (entry);
+  EXPECT_EQ (entry->cloud->size (), 10u);
+  EXPECT_EQ (cache.get (message), entry);
+
+  // Another message with the same points is another cloud
+  const std::shared_ptr<PointCloud2> copy (new PointCloud2 (*message));
+  EXPECT_NE (cache.get (copy), entry);
+
+  const pcl_ros::SearchCache::Statistics after = cache.statistics ();
+  EXPECT_EQ (after.misses - before.misses, 2u);
+  EXPECT_EQ (after.hits - before.hits, 1u);
+  EXPECT_EQ (after.entries, 2u);
+}
+
+TEST (SearchCache, invalidClouds)
+{
+  pcl_ros::SearchCache &cache = emptyCache ();
+  EXPECT_FALSE (cache.get (nullptr));
+
+  // No x, y and z fields
+  const std::shared_ptr<PointCloud2> message = makeMessage (1);
+  message->fields.clear ();
+  EXPECT_FALSE (cache.get (message));
+
+  // Not organized
+  EXPECT_FALSE (cache.get (makeMessage (2), pcl_ros::SearchCache::ORGANIZED));
+}
+
+TEST (SearchCache, releasedMessagesAreDropped)
+{
+  pcl_ros::SearchCache &cache = emptyCache ();
+  std::shared_ptr<PointCloud2> message = makeMessage (1);
+  ASSERT_TRUE (cache.get (message));
+  EXPECT_EQ (cache.statistics ().entries, 1u);
+
+  // The entry does not keep the message alive, and is dropped on the next request
+  const std::weak_ptr<PointCloud2> released = message;
+  message.reset ();
+  EXPECT_TRUE (released.expired ());
+  const std::shared_ptr<PointCloud2> next = makeMessage (2);
+  ASSERT_TRUE (cache.get (next));
+  EXPECT_EQ (cache.statistics ().entries, 1u);
+}
+
+TEST (SearchCache, leastRecentlyUsedEviction)
+{
+  // The default capacity is 2 entries, nothing raises it in this test
+  pcl_ros::SearchCache &cache = emptyCache ();
+  const std::shared_ptr<PointCloud2> first = makeMessage (1);
+  const std::shared_ptr<PointCloud2> second = makeMessage (2);
+  const std::shared_ptr<PointCloud2> third = makeMessage (3);
+  const pcl_ros::SearchCache::Statistics before = cache.statistics ();
+
+  const pcl_ros::SearchCache::EntryConstPtr first_entry = cache.get (first);
+  ASSERT_TRUE (cache.get (second));
+  // Use the first cloud again, the second is now the least recently used
+  EXPECT_EQ (cache.get (first), first_entry);
+  ASSERT_TRUE (cache.get (third));
+
+  pcl_ros::SearchCache::Statistics after = cache.statistics ();
+  EXPECT_EQ (after.evictions - before.evictions, 1u);
+  EXPECT_EQ (after.entries, 2u);
+
+  EXPECT_EQ (cache.get (first), first_entry);
+  ASSERT_TRUE (cache.get (second));
+  after = cache.statistics ();
+  EXPECT_EQ (after.misses - before.misses, 4u);
+  EXPECT_EQ (after.hits - before.hits, 2u);
+}
@@ -0,0 +1,114 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef PCL_ROS__TEST__TEST_UTILS_HPP_
+#define PCL_ROS__TEST__TEST_UTILS_HPP_
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <pcl/PointIndices.h>
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/common/point_tests.h>
+
+namespace pcl_ros
+{
+  namespace test
+  {
+    typedef pcl::PointCloud<pcl::PointXYZ> PointCloud;
+    typedef std::shared_ptr<std::vector<int> > IndicesPtr;
+
+    /** \brief Every \a step th point of a cloud of \a nr_points points, starting from the first. */
+    inline IndicesPtr
+    everyNthIndex (size_t nr_points, size_t step)
+    {
+      IndicesPtr indices (new std::vector<int>);
+      for (size_t i = 0; i < nr_points; i += step)
+        indices->push_back (static_cast<int> (i));
+      return (indices);
+    }
+
+    /** \brief The finite points among \a indices, all the points of \a cloud if null, as PCL search structures
+      * only take finite points.
+      */
+    inline IndicesPtr
+    finiteIndices (const PointCloud &cloud, const IndicesPtr &indices)
+    {
+      IndicesPtr finite (new std::vector<int>);
+      const size_t nr_selected = indices ? indices->size () : cloud.points.size ();
+      for (size_t n = 0; n < nr_selected; ++n)
+      {
+        const int index = indices ? (*indices)[n] : static_cast<int> (n);
+        if (pcl::isFinite (cloud.points[index]))
+          finite->push_back (index);
+      }
+      return (finite);
+    }
+
+    /** \brief The finite points of a cloud, as an unorganized dense cloud. */
+    inline PointCloud
+    finitePoints (const PointCloud &cloud)
+    {
+      PointCloud finite;
+      for (const pcl::PointXYZ &p : cloud.points)
+      {
+        if (pcl::isFinite (p))
+          finite.points.push_back (p);
+      }
+      finite.width = static_cast<uint32_t> (finite.points.size ());
+      finite.height = 1;
+      return (finite);
+    }
+
+    /** \brief Clusters as sorted lists of sorted indices, independent of the order of the clusters of a same size.
+      */
+    inline std::vector<std::vector<int> >
+    normalize (const std::vector<pcl::PointIndices> &clusters)
+    {
+      std::vector<std::vector<int> > normalized;
+      for (const pcl::PointIndices &cluster : clusters)
+      {
+        normalized.push_back (cluster.indices);
+        std::sort (normalized.back ().begin (), normalized.back ().end ());
+      }
+      std::sort (normalized.begin (), normalized.end ());
+      return (normalized);
+    }
+  }  // namespace test
+}  // namespace pcl_ros
+
+#endif  // PCL_ROS__TEST__TEST_UTILS_HPP_
@@ -0,0 +1,161 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/search/kdtree.h>
+#include <pcl/segmentation/extract_clusters.h>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/segmentation/voxel_clustering.hpp"
+#include "test_utils.hpp"
+
+typedef pcl::PointCloud<pcl::PointXYZ> PointCloud;
+
+static const float kTolerance = 0.1f;
+
+/** \brief Gaussian blobs in scattered points, a chain of points 0.9 tolerance apart with a 1.1 tolerance gap in the
+  * middle, points on the voxel boundaries, and NaN points.
+  */
+static PointCloud
+makeCloud (size_t nr_points)
+{
+  PointCloud cloud;
+  std::mt19937 rng (7);
+  std::uniform_real_distribution<float> coordinate (-2.0f, 2.0f);
+  std::normal_distribution<float> spread (0.0f, 0.08f);
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    if (i % 4 == 0)
+    {
+      cloud.points.push_back (pcl::PointXYZ (coordinate (rng), coordinate (rng), coordinate (rng)));
+      continue;
+    }
+    const float center = static_cast<float> (i % 5) - 2.0f;
+    cloud.points.push_back (pcl::PointXYZ (center + spread (rng), -center + spread (rng), spread (rng)));
+  }
+  for (int i = 0; i < 20; ++i)
+    cloud.points.push_back (pcl::PointXYZ (3.0f + kTolerance * (0.9f * i + (i >= 10 ? 0.2f : 0.0f)), 3.0f, 3.0f));
+  for (int i = -8; i <= 8; ++i)
+    cloud.points.push_back (pcl::PointXYZ (i * kTolerance, i * kTolerance, -3.0f));
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  for (int i = 0; i < 5; ++i)
+  {
+    cloud.points.push_back (pcl::PointXYZ (nan, nan, nan));
+    cloud.points.push_back (pcl::PointXYZ (0.0f, nan, 0.0f));
+  }
+  cloud.width = static_cast<uint32_t> (cloud.points.size ());
+  cloud.height = 1;
+  cloud.is_dense = false;
+  return (cloud);
+}
+
+/** \brief Cluster with VoxelClustering and with pcl::EuclideanClusterExtraction, and compare the clusters. */
+static void
+compareWithEuclideanClusterExtraction (const PointCloud &cloud, const std::shared_ptr<std::vector<int> > &indices,
+                                       int min_size, int max_size, unsigned int nr_threads)
+{
+  pcl::EuclideanClusterExtraction<pcl::PointXYZ> reference;
+  reference.setInputCloud (cloud.makeShared ());
+  reference.setIndices (pcl_ros::test::finiteIndices (cloud, indices));
+  reference.setSearchMethod (pcl::search::KdTree<pcl::PointXYZ>::Ptr (new pcl::search::KdTree<pcl::PointXYZ>));
+  reference.setClusterTolerance (kTolerance);
+  reference.setMinClusterSize (min_size);
+  reference.setMaxClusterSize (max_size);
+  std::vector<pcl::PointIndices> expected;
+  reference.extract (expected);
+
+  pcl_ros::VoxelClustering clustering;
+  clustering.setClusterTolerance (kTolerance);
+  clustering.setMinClusterSize (min_size);
+  clustering.setMaxClusterSize (max_size);
+  clustering.setNumberOfThreads (nr_threads);
+  std::vector<pcl::PointIndices> actual;
+  clustering.extract (cloud, indices, actual);
+
+  EXPECT_EQ (pcl_ros::test::normalize (actual), pcl_ros::test::normalize (expected));
+  // Sorted by decreasing size, with increasing indices
+  for (size_t i = 0; i < actual.size (); ++i)
+  {
+    EXPECT_TRUE (std::is_sorted (actual[i].indices.begin (), actual[i].indices.end ()));
+    if (i > 0)
+      EXPECT_GE (actual[i - 1].indices.size (), actual[i].indices.size ());
+  }
+}
+
+TEST (VoxelClustering, clustersMatchEuclideanClusterExtraction)
+{
+  compareWithEuclideanClusterExtraction (makeCloud (2000), nullptr, 1, std::numeric_limits<int>::max (), 1);
+}
+
+TEST (VoxelClustering, sizeLimitsMatchEuclideanClusterExtraction)
+{
+  compareWithEuclideanClusterExtraction (makeCloud (2000), nullptr, 3, 300, 1);
+}
+
+TEST (VoxelClustering, indicesMatchEuclideanClusterExtraction)
+{
+  const PointCloud cloud = makeCloud (2000);
+  const std::shared_ptr<std::vector<int> > indices = pcl_ros::test::everyNthIndex (cloud.points.size (), 2);
+  // The NaN points are at the end
+  indices->push_back (static_cast<int> (cloud.points.size () - 1));
+  compareWithEuclideanClusterExtraction (cloud, indices, 1, std::numeric_limits<int>::max (), 1);
+}
+
+TEST (VoxelClustering, threadsMatchEuclideanClusterExtraction)
+{
+  // Enough points for 4 threads to be used
+  compareWithEuclideanClusterExtraction (makeCloud (40000), nullptr, 2, std::numeric_limits<int>::max (), 4);
+}
+
+TEST (VoxelClustering, emptyInput)
+{
+  pcl_ros::VoxelClustering clustering;
+  clustering.setClusterTolerance (kTolerance);
+  std::vector<pcl::PointIndices> clusters (1);
+  clustering.extract (PointCloud (), nullptr, clusters);
+  EXPECT_TRUE (clusters.empty ());
+
+  clusters.resize (1);
+  clustering.extract (makeCloud (100), std::shared_ptr<std::vector<int> > (new std::vector<int>), clusters);
+  EXPECT_TRUE (clusters.empty ());
+}
@@ -0,0 +1,317 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/filters/radius_outlier_removal.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl_conversions/pcl_conversions.hpp>
+
+#include <gtest/gtest.h>
+
+#include "pcl_ros/filters/voxel_hash.hpp"
+#include "test_utils.hpp"
+
+typedef pcl::PointCloud<pcl::PointXYZ> PointCloud;
+typedef std::tuple<int, int, int> Key;
+
+// The leaf sizes are powers of two, so that the voxel of a point is the same whether its coordinates are scaled in
+// single (pcl::VoxelGrid) or double precision (VoxelHashGrid).
+static const float kLeaf[3] = {0.25f, 0.5f, 1.0f};
+
+/** \brief Random points in a 4 m cube, plus points lying exactly on voxel boundaries and a few NaN points. */
+static PointCloud
+makeCloud (size_t nr_points)
+{
+  PointCloud cloud;
+  std::mt19937 rng (42);
+  std::uniform_real_distribution<float> coordinate (-2.0f, 2.0f);
+  for (size_t i = 0; i < nr_points; ++i)
+    cloud.points.push_back (pcl::PointXYZ (coordinate (rng), coordinate (rng), coordinate (rng)));
+  for (int i = -4; i <= 4; ++i)
+    cloud.points.push_back (pcl::PointXYZ (i * kLeaf[0], i * kLeaf[1], i * kLeaf[2]));
+  const float nan = std::numeric_limits<float>::quiet_NaN ();
+  cloud.points.push_back (pcl::PointXYZ (nan, nan, nan));
+  cloud.points.push_back (pcl::PointXYZ (1.0f, nan, 0.0f));
+  cloud.width = static_cast<uint32_t> (cloud.points.size ());
+  cloud.height = 1;
+  cloud.is_dense = false;
+  return (cloud);
+}
+
+/** \brief Index the points of a downsampled cloud by the voxel they lie in. */
+static std::map<Key, pcl::PointXYZ>
+byVoxel (const PointCloud &cloud)
+{
+  std::map<Key, pcl::PointXYZ> voxels;
+  for (const pcl::PointXYZ &p : cloud.points)
+  {
+    const Key key (static_cast<int> (std::floor (p.x / kLeaf[0])), static_cast<int> (std::floor (p.y / kLeaf[1])),
+                   static_cast<int> (std::floor (p.z / kLeaf[2])));
+    EXPECT_EQ (voxels.count (key), 0u);
+    voxels[key] = p;
+  }
+  return (voxels);
+}
+
+/** \brief Downsample with VoxelHashGrid and with pcl::VoxelGrid, and compare the centroids voxel by voxel. */
+static void
+compareWithVoxelGrid (const PointCloud &cloud, const std::shared_ptr<std::vector<int> > &indices,
+                      unsigned int nr_threads)
+{
+  pcl::VoxelGrid<pcl::PointXYZ> reference;
+  PointCloud expected;
+  reference.setInputCloud (cloud.makeShared ());
+  if (indices)
+    reference.setIndices (indices);
+  reference.setLeafSize (kLeaf[0], kLeaf[1], kLeaf[2]);
+  reference.filter (expected);
+
+  sensor_msgs::msg::PointCloud2 input, output;
+  pcl::toROSMsg (cloud, input);
+  pcl_ros::VoxelHashGrid grid;
+  grid.setLeafSize (kLeaf[0], kLeaf[1], kLeaf[2]);
+  grid.setNumberOfThreads (nr_threads);
+  ASSERT_TRUE (grid.filter (input, indices, output));
+  PointCloud actual;
+  pcl::fromROSMsg (output, actual);
+
+  const std::map<Key, pcl::PointXYZ> expected_voxels = byVoxel (expected);
+  const std::map<Key, pcl::PointXYZ> actual_voxels = byVoxel (actual);
+  ASSERT_EQ (actual_voxels.size (), expected_voxels.size ());
+  for (const auto &voxel : expected_voxels)
+  {
+    const auto it = actual_voxels.find (voxel.first);
+    ASSERT_NE (it, actual_voxels.end ());
+    EXPECT_NEAR (it->second.x, voxel.second.x, 1e-5);
+    EXPECT_NEAR (it->second.y, voxel.second.y, 1e-5);
+    EXPECT_NEAR (it->second.z, voxel.second.z, 1e-5);
+  }
+}
+
+TEST (VoxelHashGrid, centroidsMatchVoxelGrid)
+{
+  compareWithVoxelGrid (makeCloud (2000), nullptr, 1);
+}
+
+TEST (VoxelHashGrid, indicesMatchVoxelGrid)
+{
+  const PointCloud cloud = makeCloud (2000);
+  compareWithVoxelGrid (cloud, pcl_ros::test::everyNthIndex (cloud.points.size (), 3), 1);
+}
+
+TEST (VoxelHashGrid, threadsMatchVoxelGrid)
+{
+  // Enough points for several threads to be used
+  compareWithVoxelGrid (makeCloud (200000), nullptr, 4);
+}
+
+/** \brief The voxel of a point, as in byVoxel (). */
+static Key
+voxelOf (const pcl::PointXYZ &p)
+{
+  return (Key (static_cast<int> (std::floor (p.x / kLeaf[0])), static_cast<int> (std::floor (p.y / kLeaf[1])),
+               static_cast<int> (std::floor (p.z / kLeaf[2]))));
+}
+
+/** \brief Downsample with VoxelHashGrid, keeping an input point per voxel. */
+static PointCloud
+downsample (const PointCloud &cloud, pcl_ros::VoxelHashGrid::Representative representative, unsigned int nr_threads)
+{
+  sensor_msgs::msg::PointCloud2 input, output;
+  pcl::toROSMsg (cloud, input);
+  pcl_ros::VoxelHashGrid grid;
+  grid.setLeafSize (kLeaf[0], kLeaf[1], kLeaf[2]);
+  grid.setNumberOfThreads (nr_threads);
+  grid.setRepresentative (representative);
+  EXPECT_TRUE (grid.filter (input, nullptr, output));
+  PointCloud actual;
+  pcl::fromROSMsg (output, actual);
+  return (actual);
+}
+
+TEST (VoxelHashGrid, firstPointOfEachVoxel)
+{
+  const PointCloud cloud = makeCloud (2000);
+  std::map<Key, pcl::PointXYZ> expected;
+  for (const pcl::PointXYZ &p : cloud.points)
+  {
+    if (pcl::isFinite (p))
+      expected.insert (std::make_pair (voxelOf (p), p));
+  }
+
+  for (unsigned int nr_threads : {1u, 4u})
+  {
+    const std::map<Key, pcl::PointXYZ> actual = byVoxel (downsample (cloud, pcl_ros::VoxelHashGrid::FIRST, nr_threads));
+    ASSERT_EQ (actual.size (), expected.size ());
+    for (const auto &voxel : expected)
+    {
+      const auto it = actual.find (voxel.first);
+      ASSERT_NE (it, actual.end ());
+      EXPECT_EQ (it->second.x, voxel.second.x);
+      EXPECT_EQ (it->second.y, voxel.second.y);
+      EXPECT_EQ (it->second.z, voxel.second.z);
+    }
+  }
+}
+
+TEST (VoxelHashGrid, nearestPointToEachCentroid)
+{
+  const PointCloud cloud = makeCloud (2000);
+  std::map<Key, std::vector<pcl::PointXYZ> > points;
+  for (const pcl::PointXYZ &p : cloud.points)
+  {
+    if (pcl::isFinite (p))
+      points[voxelOf (p)].push_back (p);
+  }
+
+  const std::map<Key, pcl::PointXYZ> actual = byVoxel (downsample (cloud, pcl_ros::VoxelHashGrid::NEAREST, 1));
+  ASSERT_EQ (actual.size (), points.size ());
+  for (const auto &voxel : points)
+  {
+    const auto it = actual.find (voxel.first);
+    ASSERT_NE (it, actual.end ());
+    double centroid[3] = {0.0, 0.0, 0.0};
+    for (const pcl::PointXYZ &p : voxel.second)
+    {
+      centroid[0] += p.x;
+      centroid[1] += p.y;
+      centroid[2] += p.z;
+    }
+    auto distance = [&centroid, &voxel] (const pcl::PointXYZ &p)
+    {
+      const double n = static_cast<double> (voxel.second.size ());
+      return (std::pow (p.x - centroid[0] / n, 2) + std::pow (p.y - centroid[1] / n, 2) + std::pow (p.z - centroid[2] / n, 2));
+    };
+    // The representative is one of the points of the voxel, the closest to their centroid
+    double best = std::numeric_limits<double>::max ();
+    bool found = false;
+    for (const pcl::PointXYZ &p : voxel.second)
+    {
+      best = std::min (best, distance (p));
+      found |= (p.x == it->second.x && p.y == it->second.y && p.z == it->second.z);
+    }
+    EXPECT_TRUE (found);
+    EXPECT_NEAR (distance (it->second), best, 1e-6);
+  }
+}
+
+TEST (VoxelHashGrid, emptyInput)
+{
+  sensor_msgs::msg::PointCloud2 input, output;
+  pcl::toROSMsg (PointCloud (), input);
+  pcl_ros::VoxelHashGrid grid;
+  grid.setLeafSize (kLeaf[0], kLeaf[1], kLeaf[2]);
+  ASSERT_TRUE (grid.filter (input, nullptr, output));
+  EXPECT_EQ (output.width * output.height, 0u);
+}
+
+// A point of makeCloud () has about 4 neighbors within this radius, so that many points are close to the threshold
+static const double kRadius = 0.3;
+static const int kMinNeighbors = 4;
+
+/** \brief The inliers of pcl::RadiusOutlierRemoval, sorted. */
+static std::vector<int>
+referenceInliers (const PointCloud &cloud, const std::shared_ptr<std::vector<int> > &indices)
+{
+  pcl::RadiusOutlierRemoval<pcl::PointXYZ> reference;
+  reference.setInputCloud (cloud.makeShared ());
+  if (indices)
+    reference.setIndices (indices);
+  reference.setRadiusSearch (kRadius);
+  reference.setMinNeighborsInRadius (kMinNeighbors);
+  std::vector<int> inliers;
+  reference.filter (inliers);
+  std::sort (inliers.begin (), inliers.end ());
+  return (inliers);
+}
+
+/** \brief The inliers of voxelRadiusOutlierRemoval, sorted. */
+static std::vector<int>
+voxelInliers (const PointCloud &cloud, const std::shared_ptr<std::vector<int> > &indices, double refine_ratio)
+{
+  sensor_msgs::msg::PointCloud2 input;
+  pcl::toROSMsg (cloud, input);
+  std::vector<int> inliers;
+  EXPECT_TRUE (pcl_ros::voxelRadiusOutlierRemoval (input, indices, kRadius, kMinNeighbors, refine_ratio, inliers));
+  std::sort (inliers.begin (), inliers.end ());
+  return (inliers);
+}
+
+TEST (VoxelRadiusOutlierRemoval, refinedMatchesRadiusOutlierRemoval)
+{
+  // With a refine ratio this large, the neighbors of every point passing the bound are counted exactly
+  const PointCloud cloud = pcl_ros::test::finitePoints (makeCloud (2000));
+  const std::vector<int> expected = referenceInliers (cloud, nullptr);
+  ASSERT_FALSE (expected.empty ());
+  ASSERT_LT (expected.size (), cloud.points.size ());
+  EXPECT_EQ (voxelInliers (cloud, nullptr, 1e9), expected);
+}
+
+TEST (VoxelRadiusOutlierRemoval, indicesMatchRadiusOutlierRemoval)
+{
+  const PointCloud cloud = pcl_ros::test::finitePoints (makeCloud (4000));
+  const std::shared_ptr<std::vector<int> > indices = pcl_ros::test::everyNthIndex (cloud.points.size (), 2);
+  EXPECT_EQ (voxelInliers (cloud, indices, 1e9), referenceInliers (cloud, indices));
+}
+
+TEST (VoxelRadiusOutlierRemoval, approximateKeepsEveryInlier)
+{
+  // Below the refine bound the count is exact, above it the point is kept: only outliers can be misclassified
+  const PointCloud cloud = pcl_ros::test::finitePoints (makeCloud (2000));
+  const std::vector<int> expected = referenceInliers (cloud, nullptr);
+  for (double refine_ratio : {1.0, 2.0})
+  {
+    const std::vector<int> actual = voxelInliers (cloud, nullptr, refine_ratio);
+    EXPECT_TRUE (std::includes (actual.begin (), actual.end (), expected.begin (), expected.end ()));
+  }
+}
+
+TEST (VoxelRadiusOutlierRemoval, invalidPointsAreOutliers)
+{
+  const PointCloud cloud = makeCloud (2000);
+  for (int index : voxelInliers (cloud, nullptr, 1e9))
+  {
+    EXPECT_TRUE (pcl::isFinite (cloud.points[index]));
+  }
+}
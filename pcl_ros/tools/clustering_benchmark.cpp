@@ -0,0 +1,236 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+
+@b clustering_benchmark times the clustering engines of the pcl_ros EuclideanClusterExtraction node on simulated
+urban LiDAR scans, after ground removal: pcl::EuclideanClusterExtraction, and VoxelClustering for 1 to all the
+cores, with and without refinement.
+
+Usage: clustering_benchmark [nr_points (default 200000)] [nr_runs (default 5)]
+
+ **/
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// PCL includes
+#include <pcl/point_types.h>
+#include <pcl/segmentation/extract_clusters.h>
+
+#include "pcl_ros/segmentation/voxel_clustering.hpp"
+/** \brief Simulate a 64 beam spinning LiDAR at 1.8 m in an urban street: ground, building facades, parked cars, poles
+  * and pedestrians, with 2 cm of range noise. Rays that hit nothing within 120 m are dropped.
+  */
+pcl::PointCloud<pcl::PointXYZ>::Ptr
+makeScan (size_t nr_points, unsigned int seed)
+{
+  struct Box
+  {
+    float min[3], max[3];
+  };
+  std::mt19937 rng (seed);
+  std::uniform_real_distribution<float> unit (0.0f, 1.0f);
+  std::normal_distribution<float> noise (0.0f, 0.02f);
+
+  // The street runs along x, 16 m wide between the facades
+  std::vector<Box> boxes;
+  for (int side = -1; side <= 1; side += 2)
+  {
+    for (float x = -120.0f; x < 120.0f; )
+    {
+      const float length = 15.0f + 15.0f * unit (rng), height = 8.0f + 12.0f * unit (rng);
+      const float y0 = side * (10.0f + 2.0f * unit (rng));
+      boxes.push_back (Box {{x, std::min (y0, y0 + side * 15.0f), 0.0f}, {x + length, std::max (y0, y0 + side * 15.0f), height}});
+      x += length + 3.0f + 6.0f * unit (rng);
+    }
+    for (float x = -60.0f; x < 60.0f; x += 5.5f + 3.0f * unit (rng))      // cars
+    {
+      if (unit (rng) < 0.3f)
+        continue;
+      const float y = side * 6.5f;
+      boxes.push_back (Box {{x, y - 0.9f, 0.2f}, {x + 4.5f, y + 0.9f, 1.6f}});
+    }
+    for (float x = -100.0f; x < 100.0f; x += 20.0f)                        // poles
+      boxes.push_back (Box {{x, side * 8.5f - 0.1f, 0.0f}, {x + 0.2f, side * 8.5f + 0.1f, 6.0f}});
+  }
+  for (int i = 0; i < 30; ++i)                                             // pedestrians
+  {
+    const float x = -40.0f + 80.0f * unit (rng), y = (unit (rng) < 0.5f ? -1.0f : 1.0f) * (8.0f + 1.5f * unit (rng));
+    boxes.push_back (Box {{x, y, 0.0f}, {x + 0.5f, y + 0.5f, 1.7f}});
+  }
+
+  const float origin[3] = {0.0f, 0.0f, 1.8f};
+  const int nr_beams = 64;
+  const size_t nr_steps = std::max<size_t> (1, nr_points / nr_beams);
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
+  cloud->points.reserve (nr_steps * nr_beams);
+  for (size_t step = 0; step < nr_steps; ++step)
+  {
+    const float azimuth = 2.0f * static_cast<float> (M_PI) * step / nr_steps;
+    for (int beam = 0; beam < nr_beams; ++beam)
+    {
+      const float elevation = static_cast<float> (M_PI) / 180.0f * (-25.0f + 28.0f * beam / (nr_beams - 1));
+      const float dir[3] = {std::cos (elevation) * std::cos (azimuth), std::cos (elevation) * std::sin (azimuth),
+                            std::sin (elevation)};
+      float range = 120.0f;
+      if (dir[2] < 0.0f)
+        range = std::min (range, -origin[2] / dir[2]);
+      for (const Box &box : boxes)
+      {
+        // Slab test
+        float t0 = 0.0f, t1 = range;
+        for (int axis = 0; axis < 3 && t0 <= t1; ++axis)
+        {
+          if (std::abs (dir[axis]) < 1e-9f)
+          {
+            if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis])
+              t0 = t1 + 1.0f;
+            continue;
+          }
+          float near = (box.min[axis] - origin[axis]) / dir[axis], far = (box.max[axis] - origin[axis]) / dir[axis];
+          if (near > far)
+            std::swap (near, far);
+          t0 = std::max (t0, near);
+          t1 = std::min (t1, far);
+        }
+        if (t0 <= t1 && t0 > 0.0f)
+          range = t0;
+      }
+      if (range >= 120.0f)
+        continue;
+      range += noise (rng);
+      pcl::PointXYZ p;
+      p.x = origin[0] + range * dir[0]; p.y = origin[1] + range * dir[1]; p.z = origin[2] + range * dir[2];
+      cloud->points.push_back (p);
+    }
+  }
+  cloud->width = static_cast<uint32_t> (cloud->points.size ());
+  cloud->height = 1;
+  return (cloud);
+}
+
+/** \brief Run \a fn \a nr_runs times (after one warm up run) and return the median duration in milliseconds. */
+double
+medianMs (const std::function<void ()> &fn, int nr_runs)
+{
+  fn ();
+  std::vector<double> times;
+  for (int i = 0; i < nr_runs; ++i)
+  {
+    const auto start = std::chrono::steady_clock::now ();
+    fn ();
+    times.push_back (std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ());
+  }
+  std::sort (times.begin (), times.end ());
+  return (times[times.size () / 2]);
+}
+
+/** \brief Check whether two sets of clusters are the same, whatever the order of the clusters of the same size. */
+bool
+sameClusters (std::vector<pcl::PointIndices> a, std::vector<pcl::PointIndices> b)
+{
+  auto less = [] (const pcl::PointIndices &x, const pcl::PointIndices &y) { return (x.indices < y.indices); };
+  std::sort (a.begin (), a.end (), less);
+  std::sort (b.begin (), b.end (), less);
+  return (std::equal (a.begin (), a.end (), b.begin (), b.end (),
+                      [] (const pcl::PointIndices &x, const pcl::PointIndices &y) { return (x.indices == y.indices); }));
+}
+
+int
+main (int argc, char **argv)
+{
+  const size_t nr_points = (argc > 1) ? std::strtoul (argv[1], nullptr, 10) : 200000;
+  const int nr_runs = (argc > 2) ? std::atoi (argv[2]) : 5;
+
+  const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud = makeScan (nr_points, 42);
+
+  // Cluster the points above the ground, as given by a ground segmentation on the indices topic
+  auto indices = std::make_shared<std::vector<int> > ();
+  for (size_t i = 0; i < cloud->points.size (); ++i)
+    if (cloud->points[i].z > 0.15f)
+      indices->push_back (static_cast<int> (i));
+
+  const unsigned int nr_cores = std::max (1u, std::thread::hardware_concurrency ());
+  std::printf ("%zu points, %zu above the ground, median of %d runs, %u cores\n",
+               cloud->points.size (), indices->size (), nr_runs, nr_cores);
+
+  std::vector<unsigned int> thread_counts;
+  for (unsigned int nr_threads = 1; nr_threads < nr_cores; nr_threads *= 2)
+    thread_counts.push_back (nr_threads);
+  thread_counts.push_back (nr_cores);
+
+  for (double tolerance : {0.3, 0.5, 0.75, 1.0})
+  {
+    std::vector<pcl::PointIndices> reference;
+    const double pcl_ms = medianMs ([&] ()
+    {
+      // The kd-tree is built by extract (), as in the node
+      pcl::EuclideanClusterExtraction<pcl::PointXYZ> impl;
+      impl.setClusterTolerance (tolerance);
+      impl.setInputCloud (cloud);
+      impl.setIndices (indices);
+      impl.extract (reference);
+    }, nr_runs);
+    std::printf ("tolerance %.2f  %-26s  %9.2f ms  %5zu clusters\n", tolerance, "euclidean", pcl_ms, reference.size ());
+
+    for (bool refine : {true, false})
+    {
+      for (unsigned int nr_threads : thread_counts)
+      {
+        pcl_ros::VoxelClustering impl;
+        impl.setClusterTolerance (tolerance);
+        impl.setRefine (refine);
+        impl.setNumberOfThreads (nr_threads);
+        std::vector<pcl::PointIndices> clusters;
+        const double ms = medianMs ([&] () { impl.extract (*cloud, indices, clusters); }, nr_runs);
+        char name[64];
+        std::snprintf (name, sizeof (name), "voxel%s  threads %u", refine ? "" : " coarse", nr_threads);
+        std::printf ("tolerance %.2f  %-26s  %9.2f ms  %5zu clusters  x%.2f%s\n", tolerance, name, ms, clusters.size (),
+                     pcl_ms / ms, sameClusters (clusters, reference) ? "  (same clusters)" : "");
+      }
+    }
+  }
+
+  return (0);
+}
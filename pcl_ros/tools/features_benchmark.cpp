@@ -0,0 +1,185 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+
+@b features_benchmark times the OpenMP feature estimators of the pcl_ros feature nodes on a synthetic scene, for 1
+to all the cores, the way the num_threads parameter of the nodes sets them.
+
+Usage: features_benchmark [nr_points (default 300000)] [nr_runs (default 5)]
+
+ **/
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// PCL includes
+#include <pcl/features/fpfh_omp.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/shot_omp.h>
+#include <pcl/point_types.h>
+
+/** \brief Generate an indoor-like scene of smooth surfaces: a floor, two walls and a few spheres, over 20x20 m. */
+pcl::PointCloud<pcl::PointXYZ>::Ptr
+makeScene (size_t nr_points, unsigned int seed)
+{
+  std::mt19937 rng (seed);
+  std::uniform_real_distribution<float> u (-10.0f, 10.0f);
+  std::uniform_real_distribution<float> h (0.0f, 3.0f);
+  std::uniform_real_distribution<float> angle (0.0f, 2.0f * static_cast<float> (M_PI));
+  std::uniform_real_distribution<float> unit (-1.0f, 1.0f);
+  std::normal_distribution<float> noise (0.0f, 0.002f);
+
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud (new pcl::PointCloud<pcl::PointXYZ>);
+  cloud->points.resize (nr_points);
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    pcl::PointXYZ &p = cloud->points[i];
+    const size_t kind = i % 10;
+    if (kind < 5)         // floor
+    {
+      p.x = u (rng); p.y = u (rng); p.z = noise (rng);
+    }
+    else if (kind < 7)    // walls
+    {
+      p.x = (kind == 5 ? -10.0f : 10.0f) + noise (rng); p.y = u (rng); p.z = h (rng);
+    }
+    else                  // spheres of 0.5 m on a 4 m grid
+    {
+      const float z = unit (rng), phi = angle (rng), r = std::sqrt (1.0f - z * z);
+      const float cx = std::round (u (rng) / 4.0f) * 4.0f, cy = std::round (u (rng) / 4.0f) * 4.0f;
+      p.x = cx + 0.5f * r * std::cos (phi); p.y = cy + 0.5f * r * std::sin (phi); p.z = 1.0f + 0.5f * z;
+    }
+  }
+  cloud->width = static_cast<uint32_t> (nr_points);
+  cloud->height = 1;
+  cloud->is_dense = true;
+  return (cloud);
+}
+
+/** \brief Run \a fn \a nr_runs times (after one warm up run) and return the median duration in milliseconds. */
+double
+medianMs (const std::function<void ()> &fn, int nr_runs)
+{
+  fn ();
+  std::vector<double> times;
+  for (int i = 0; i < nr_runs; ++i)
+  {
+    const auto start = std::chrono::steady_clock::now ();
+    fn ();
+    times.push_back (std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ());
+  }
+  std::sort (times.begin (), times.end ());
+  return (times[times.size () / 2]);
+}
+
+/** \brief Time \a fn for 1, 2, 4... and all the cores, and print the speedup over a single thread.
+  * \param name the name of the estimator
+  * \param fn the estimation, with the number of threads to use
+  */
+void
+scale (const char *name, const std::function<void (unsigned int)> &fn, int nr_runs)
+{
+  const unsigned int nr_cores = std::max (1u, std::thread::hardware_concurrency ());
+  std::vector<unsigned int> thread_counts;
+  for (unsigned int nr_threads = 1; nr_threads < nr_cores; nr_threads *= 2)
+    thread_counts.push_back (nr_threads);
+  thread_counts.push_back (nr_cores);
+
+  double single_ms = 0.0;
+  for (unsigned int nr_threads : thread_counts)
+  {
+    const double ms = medianMs ([&] () { fn (nr_threads); }, nr_runs);
+    if (nr_threads == 1)
+      single_ms = ms;
+    std::printf ("%-32s  threads %3u  %9.2f ms  x%.2f\n", name, nr_threads, ms, single_ms / ms);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  const size_t nr_points = (argc > 1) ? std::strtoul (argv[1], nullptr, 10) : 300000;
+  const int nr_runs = (argc > 2) ? std::atoi (argv[2]) : 5;
+
+  const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud = makeScene (nr_points, 42);
+  std::printf ("%zu points, median of %d runs, %u cores\n", nr_points, nr_runs, std::thread::hardware_concurrency ());
+
+  // The descriptors are computed on every 10th point, with the whole cloud as the search surface
+  auto keypoints = std::make_shared<std::vector<int> > ();
+  for (size_t i = 0; i < nr_points; i += 10)
+    keypoints->push_back (static_cast<int> (i));
+
+  pcl::PointCloud<pcl::Normal>::Ptr normals (new pcl::PointCloud<pcl::Normal>);
+  scale ("normal_3d_omp  k 10", [&] (unsigned int nr_threads)
+  {
+    pcl::NormalEstimationOMP<pcl::PointXYZ, pcl::Normal> impl (nr_threads);
+    impl.setKSearch (10);
+    impl.setInputCloud (cloud);
+    impl.compute (*normals);
+  }, nr_runs);
+
+  scale ("fpfh_omp  radius 0.25  1/10 pts", [&] (unsigned int nr_threads)
+  {
+    pcl::FPFHEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::FPFHSignature33> impl (nr_threads);
+    impl.setRadiusSearch (0.25);
+    impl.setInputCloud (cloud);
+    impl.setIndices (keypoints);
+    impl.setInputNormals (normals);
+    pcl::PointCloud<pcl::FPFHSignature33> output;
+    impl.compute (output);
+  }, nr_runs);
+
+  scale ("shot_omp  radius 0.25  1/10 pts", [&] (unsigned int nr_threads)
+  {
+    pcl::SHOTEstimationOMP<pcl::PointXYZ, pcl::Normal, pcl::SHOT352> impl (nr_threads);
+    impl.setRadiusSearch (0.25);
+    impl.setInputCloud (cloud);
+    impl.setIndices (keypoints);
+    impl.setInputNormals (normals);
+    pcl::PointCloud<pcl::SHOT352> output;
+    impl.compute (output);
+  }, nr_runs);
+
+  return (0);
+}
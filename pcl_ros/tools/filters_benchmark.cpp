@@ -0,0 +1,339 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+
+@b filters_benchmark times the engines of the pcl_ros filters on synthetic clouds, the way the nodes run
+them (PointCloud2 in, PointCloud2 out).
+
+Usage: filters_benchmark [nr_points (default 1000000)] [nr_runs (default 7)]
+
+ **/
+
+// STL
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+// PCL includes
+#include <pcl/common/io.h>
+#include <pcl/filters/crop_box.h>
+#include <pcl/filters/passthrough.h>
+#include <pcl/filters/radius_outlier_removal.h>
+#include <pcl/filters/voxel_grid.h>
+#include <pcl/point_types.h>
+#include <pcl_conversions/pcl_conversions.hpp>
+
+#include "pcl_ros/transforms.hpp"
+#include "pcl_ros/filters/voxel_hash.hpp"
+
+/** \brief Generate an outdoor-like scene: a ground plane, a few walls and boxes, and sparse clutter, over 100x100 m. */
+sensor_msgs::msg::PointCloud2
+makeScene (size_t nr_points, unsigned int seed)
+{
+  std::mt19937 rng (seed);
+  std::uniform_real_distribution<float> u (-50.0f, 50.0f);
+  std::uniform_real_distribution<float> h (0.0f, 3.0f);
+  std::normal_distribution<float> noise (0.0f, 0.01f);
+  std::uniform_real_distribution<float> intensity (0.0f, 255.0f);
+
+  pcl::PointCloud<pcl::PointXYZI> cloud;
+  cloud.points.resize (nr_points);
+  for (size_t i = 0; i < nr_points; ++i)
+  {
+    pcl::PointXYZI &p = cloud.points[i];
+    const size_t kind = i % 10;
+    if (kind < 6)         // ground
+    {
+      p.x = u (rng); p.y = u (rng); p.z = noise (rng);
+    }
+    else if (kind < 9)    // walls every 10 m
+    {
+      p.x = std::round (u (rng) / 10.0f) * 10.0f + noise (rng); p.y = u (rng); p.z = h (rng);
+    }
+    else                  // clutter
+    {
+      p.x = u (rng); p.y = u (rng); p.z = h (rng) * 5.0f;
+    }
+    p.intensity = intensity (rng);
+  }
+  cloud.width = static_cast<uint32_t> (nr_points);
+  cloud.height = 1;
+  cloud.is_dense = true;
+
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg (cloud, msg);
+  msg.header.frame_id = "map";
+  return (msg);
+}
+
+/** \brief Run \a fn \a nr_runs times (after one warm up run) and return the median duration in milliseconds. */
+double
+medianMs (const std::function<void ()> &fn, int nr_runs)
+{
+  fn ();
+  std::vector<double> times;
+  for (int i = 0; i < nr_runs; ++i)
+  {
+    const auto start = std::chrono::steady_clock::now ();
+    fn ();
+    times.push_back (std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ());
+  }
+  std::sort (times.begin (), times.end ());
+  return (times[times.size () / 2]);
+}
+
+/** \brief Compare pcl::VoxelGrid, as used by the VoxelGrid node, with each output mode of VoxelHashGrid. */
+void
+benchmarkVoxelGrid (const sensor_msgs::msg::PointCloud2 &input, float leaf_size, int nr_runs)
+{
+  size_t pcl_size = 0;
+  const double pcl_ms = medianMs ([&] ()
+  {
+    pcl::PCLPointCloud2::Ptr pcl_input (new pcl::PCLPointCloud2);
+    pcl_conversions::toPCL (input, *pcl_input);
+    pcl::VoxelGrid<pcl::PCLPointCloud2> impl;
+    impl.setLeafSize (leaf_size, leaf_size, leaf_size);
+    impl.setInputCloud (pcl_input);
+    pcl::PCLPointCloud2 pcl_output;
+    impl.filter (pcl_output);
+    sensor_msgs::msg::PointCloud2 output;
+    pcl_conversions::moveFromPCL (pcl_output, output);
+    pcl_size = output.width * output.height;
+  }, nr_runs);
+  const double nr_points = static_cast<double> (input.width) * input.height;
+  std::printf ("voxel_grid  leaf %.2f  pcl       centroid  %9.2f ms  %7.1f Mpts/s  %8zu points\n", leaf_size, pcl_ms,
+               nr_points / pcl_ms * 1e-3, pcl_size);
+
+  const std::pair<pcl_ros::VoxelHashGrid::Representative, const char *> modes[] = {
+    {pcl_ros::VoxelHashGrid::CENTROID, "centroid"},
+    {pcl_ros::VoxelHashGrid::NEAREST, "nearest"},
+    {pcl_ros::VoxelHashGrid::FIRST, "first"}};
+  for (const auto &mode : modes)
+  {
+    for (unsigned int nr_threads : {1u, 0u})
+    {
+      pcl_ros::VoxelHashGrid impl;
+      impl.setLeafSize (leaf_size, leaf_size, leaf_size);
+      impl.setNumberOfThreads (nr_threads);
+      impl.setRepresentative (mode.first);
+      size_t hash_size = 0;
+      const double hash_ms = medianMs ([&] ()
+      {
+        sensor_msgs::msg::PointCloud2 output;
+        impl.filter (input, nullptr, output);
+        hash_size = output.width * output.height;
+      }, nr_runs);
+      std::printf ("voxel_grid  leaf %.2f  hash (%2s) %-8s  %9.2f ms  %7.1f Mpts/s  %8zu points  x%.2f\n", leaf_size,
+                   nr_threads == 0 ? "mt" : "1", mode.second, hash_ms, nr_points / hash_ms * 1e-3, hash_size,
+                   pcl_ms / hash_ms);
+    }
+  }
+}
+
+/** \brief Compare cropping in a rotated and translated box frame by transforming the cloud into the box frame and
+  * back (CropBox with input_frame), with cropping through pcl::CropBox::setTransform (CropBox with box_frame).
+  */
+void
+benchmarkOrientedCropBox (const sensor_msgs::msg::PointCloud2 &input, int nr_runs)
+{
+  Eigen::Affine3f input_to_box = Eigen::Affine3f::Identity ();
+  input_to_box.translate (Eigen::Vector3f (2.0f, -1.0f, 0.5f));
+  input_to_box.rotate (Eigen::AngleAxisf (0.5f, Eigen::Vector3f::UnitZ ()));
+  const Eigen::Matrix4f box_to_input = input_to_box.inverse ().matrix ();
+
+  auto crop = [] (const sensor_msgs::msg::PointCloud2 &cloud, const Eigen::Affine3f &transform,
+                  sensor_msgs::msg::PointCloud2 &output)
+  {
+    pcl::PCLPointCloud2::Ptr pcl_input (new pcl::PCLPointCloud2);
+    pcl_conversions::toPCL (cloud, *pcl_input);
+    pcl::CropBox<pcl::PCLPointCloud2> impl;
+    impl.setMin (Eigen::Vector4f (-20.0f, -10.0f, -1.0f, 1.0f));
+    impl.setMax (Eigen::Vector4f (20.0f, 10.0f, 2.0f, 1.0f));
+    impl.setTransform (transform);
+    impl.setInputCloud (pcl_input);
+    pcl::PCLPointCloud2 pcl_output;
+    impl.filter (pcl_output);
+    pcl_conversions::moveFromPCL (pcl_output, output);
+  };
+
+  size_t transform_size = 0;
+  const double transform_ms = medianMs ([&] ()
+  {
+    sensor_msgs::msg::PointCloud2 transformed, cropped, output;
+    pcl_ros::transformPointCloud (input_to_box.matrix (), input, transformed);
+    crop (transformed, Eigen::Affine3f::Identity (), cropped);
+    pcl_ros::transformPointCloud (box_to_input, cropped, output);
+    transform_size = output.width * output.height;
+  }, nr_runs);
+  std::printf ("crop_box    transform + crop + transform back  %9.2f ms  %8zu points\n", transform_ms, transform_size);
+
+  size_t oriented_size = 0;
+  const double oriented_ms = medianMs ([&] ()
+  {
+    sensor_msgs::msg::PointCloud2 output;
+    crop (input, input_to_box, output);
+    oriented_size = output.width * output.height;
+  }, nr_runs);
+  std::printf ("crop_box    oriented crop                      %9.2f ms  %8zu points  x%.2f\n", oriented_ms, oriented_size,
+               transform_ms / oriented_ms);
+}
+
+/** \brief Compare pcl::RadiusOutlierRemoval (kd-tree radius search) with voxelRadiusOutlierRemoval, for several
+  * refine ratios. The agreement is the fraction of points classified the same way by both.
+  */
+void
+benchmarkRadiusOutlierRemoval (const sensor_msgs::msg::PointCloud2 &input, double radius, int min_neighbors,
+                               int nr_runs)
+{
+  const size_t nr_points = static_cast<size_t> (input.width) * input.height;
+  std::vector<int> pcl_inliers;
+  const double pcl_ms = medianMs ([&] ()
+  {
+    pcl::PCLPointCloud2::Ptr pcl_input (new pcl::PCLPointCloud2);
+    pcl_conversions::toPCL (input, *pcl_input);
+    pcl::RadiusOutlierRemoval<pcl::PCLPointCloud2> impl;
+    impl.setRadiusSearch (radius);
+    impl.setMinNeighborsInRadius (min_neighbors);
+    impl.setInputCloud (pcl_input);
+    impl.filter (pcl_inliers);
+  }, nr_runs);
+  std::printf ("radius_outlier_removal  radius %.2f  min %d  pcl             %9.2f ms  %8zu inliers\n", radius,
+               min_neighbors, pcl_ms, pcl_inliers.size ());
+
+  std::vector<uint8_t> pcl_inlier (nr_points, 0);
+  for (int index : pcl_inliers)
+    pcl_inlier[index] = 1;
+  for (double refine_ratio : {1.0, 2.0, 4.0})
+  {
+    std::vector<int> inliers;
+    const double voxel_ms = medianMs ([&] ()
+    {
+      pcl_ros::voxelRadiusOutlierRemoval (input, nullptr, radius, min_neighbors, refine_ratio, inliers);
+    }, nr_runs);
+    std::vector<uint8_t> inlier (nr_points, 0);
+    for (int index : inliers)
+      inlier[index] = 1;
+    size_t agreeing = 0;
+    for (size_t i = 0; i < nr_points; ++i)
+      agreeing += (inlier[i] == pcl_inlier[i]);
+    std::printf ("radius_outlier_removal  radius %.2f  min %d  voxel refine %.0f  %9.2f ms  %8zu inliers  "
+                 "agreement %.4f  x%.2f\n", radius, min_neighbors, refine_ratio, voxel_ms, inliers.size (),
+                 static_cast<double> (agreeing) / nr_points, pcl_ms / voxel_ms);
+  }
+}
+
+/** \brief Compare a passthrough, crop_box and voxel_grid pipeline run as three standalone filter nodes (each one
+  * converting its PointCloud2 input to PCL and its output back, as Filter does) with the same stages in a
+  * FilterChain (one conversion each way, the selecting stages passing indices on).
+  */
+void
+benchmarkFilterChain (const sensor_msgs::msg::PointCloud2 &input, int nr_runs)
+{
+  pcl::PassThrough<pcl::PCLPointCloud2> passthrough;
+  passthrough.setFilterFieldName ("z");
+  passthrough.setFilterLimits (-0.5, 2.5);
+  pcl::CropBox<pcl::PCLPointCloud2> crop_box;
+  crop_box.setMin (Eigen::Vector4f (-30.0f, -30.0f, -1.0f, 1.0f));
+  crop_box.setMax (Eigen::Vector4f (30.0f, 30.0f, 3.0f, 1.0f));
+  pcl::VoxelGrid<pcl::PCLPointCloud2> voxel_grid;
+  voxel_grid.setLeafSize (0.1f, 0.1f, 0.1f);
+  pcl::Filter<pcl::PCLPointCloud2> *stages[] = {&passthrough, &crop_box, &voxel_grid};
+  pcl::FilterIndices<pcl::PCLPointCloud2> *selecting_stages[] = {&passthrough, &crop_box};
+
+  size_t nodes_size = 0;
+  const double nodes_ms = medianMs ([&] ()
+  {
+    sensor_msgs::msg::PointCloud2 cloud = input;
+    for (pcl::Filter<pcl::PCLPointCloud2> *stage : stages)
+    {
+      pcl::PCLPointCloud2::Ptr pcl_input (new pcl::PCLPointCloud2);
+      pcl_conversions::toPCL (cloud, *pcl_input);
+      stage->setInputCloud (pcl_input);
+      stage->setIndices (pcl::IndicesPtr ());
+      pcl::PCLPointCloud2 pcl_output;
+      stage->filter (pcl_output);
+      pcl_conversions::moveFromPCL (pcl_output, cloud);
+    }
+    nodes_size = cloud.width * cloud.height;
+  }, nr_runs);
+  std::printf ("filter_chain  3 standalone nodes  %9.2f ms  %8zu points\n", nodes_ms, nodes_size);
+
+  size_t chain_size = 0;
+  const double chain_ms = medianMs ([&] ()
+  {
+    pcl::PCLPointCloud2::Ptr cloud (new pcl::PCLPointCloud2);
+    pcl_conversions::toPCL (input, *cloud);
+    pcl::IndicesPtr indices;
+    for (pcl::FilterIndices<pcl::PCLPointCloud2> *stage : selecting_stages)
+    {
+      stage->setInputCloud (cloud);
+      stage->setIndices (indices);
+      pcl::IndicesPtr selected (new std::vector<int>);
+      stage->filter (*selected);
+      indices = selected;
+    }
+    voxel_grid.setInputCloud (cloud);
+    voxel_grid.setIndices (indices);
+    pcl::PCLPointCloud2 pcl_output;
+    voxel_grid.filter (pcl_output);
+    sensor_msgs::msg::PointCloud2 output;
+    pcl_conversions::moveFromPCL (pcl_output, output);
+    chain_size = output.width * output.height;
+  }, nr_runs);
+  std::printf ("filter_chain  chain of 3 stages   %9.2f ms  %8zu points  x%.2f\n", chain_ms, chain_size,
+               nodes_ms / chain_ms);
+}
+
+int
+main (int argc, char **argv)
+{
+  const size_t nr_points = (argc > 1) ? std::strtoul (argv[1], nullptr, 10) : 1000000;
+  const int nr_runs = (argc > 2) ? std::atoi (argv[2]) : 7;
+
+  const sensor_msgs::msg::PointCloud2 input = makeScene (nr_points, 42);
+  std::printf ("%zu points, median of %d runs\n", nr_points, nr_runs);
+
+  benchmarkVoxelGrid (input, 0.05f, nr_runs);
+  benchmarkVoxelGrid (input, 0.2f, nr_runs);
+  benchmarkOrientedCropBox (input, nr_runs);
+  benchmarkRadiusOutlierRemoval (input, 0.2, 5, nr_runs);
+  benchmarkFilterChain (input, nr_runs);
+
+  return (0);
+}